@@ -7,6 +7,8 @@
 
 #include <common.h>
 #include <command.h>
+#include <errno.h>
+#include <perf.h>
 #include <asm/system.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -62,3 +64,81 @@ unsigned long usec2ticks(unsigned long usec)
 
 	return ticks;
 }
+
+#ifdef CONFIG_PERF_SAMPLE
+/*
+ * The sampling profiler uses the physical timer of the exception level
+ * U-Boot runs at: the secure physical timer at EL3, the hypervisor timer
+ * at EL2 and the non-secure physical timer at EL1. Each has its own PPI.
+ */
+#define PERF_TIMER_PPI_EL3	29
+#define PERF_TIMER_PPI_EL2	26
+#define PERF_TIMER_PPI_EL1	30
+
+#define CNT_CTL_ENABLE		(1 << 0)
+
+static unsigned long perf_timer_interval;
+
+static void perf_timer_set(unsigned long tval, unsigned long ctl)
+{
+	switch (current_el()) {
+	case 3:
+		asm volatile("msr cntps_tval_el1, %0" : : "r" (tval));
+		asm volatile("msr cntps_ctl_el1, %0" : : "r" (ctl));
+		break;
+	case 2:
+		asm volatile("msr cnthp_tval_el2, %0" : : "r" (tval));
+		asm volatile("msr cnthp_ctl_el2, %0" : : "r" (ctl));
+		break;
+	default:
+		asm volatile("msr cntp_tval_el0, %0" : : "r" (tval));
+		asm volatile("msr cntp_ctl_el0, %0" : : "r" (ctl));
+		break;
+	}
+	isb();
+}
+
+/* Called from do_irq() when the profiling timer fires */
+void arch_perf_timer_irq(struct pt_regs *regs)
+{
+	perf_record_sample(regs->elr);
+	/* Reloading the timer also deasserts its level-triggered PPI */
+	perf_timer_set(perf_timer_interval, CNT_CTL_ENABLE);
+}
+
+int arch_perf_timer_start(unsigned int hz)
+{
+	int ppi, ret;
+
+	if (!hz)
+		return -EINVAL;
+	perf_timer_interval = get_tbclk() / hz;
+	if (!perf_timer_interval)
+		return -EINVAL;
+
+	switch (current_el()) {
+	case 3:
+		ppi = PERF_TIMER_PPI_EL3;
+		break;
+	case 2:
+		ppi = PERF_TIMER_PPI_EL2;
+		break;
+	default:
+		ppi = PERF_TIMER_PPI_EL1;
+		break;
+	}
+
+	perf_timer_set(perf_timer_interval, CNT_CTL_ENABLE);
+	ret = arch_perf_irq_enable(ppi);
+	if (ret)
+		perf_timer_set(0, 0);
+
+	return ret;
+}
+
+void arch_perf_timer_stop(void)
+{
+	arch_perf_irq_disable();
+	perf_timer_set(0, 0);
+}
+#endif
@@ -0,0 +1,164 @@
+/*
+ * ARMv8 PMU (performance monitors extension) counters
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <pmu.h>
+#include <asm/system.h>
+
+#define ID_AA64DFR0_PMUVER_SHIFT	8
+#define ID_AA64DFR0_PMUVER_MASK		0xf
+
+#define PMCR_E		(1 << 0)	/* enable all counters */
+#define PMCR_P		(1 << 1)	/* reset event counters */
+#define PMCR_C		(1 << 2)	/* reset cycle counter */
+#define PMCR_LC		(1 << 6)	/* 64-bit cycle counter overflow */
+#define PMCR_N_SHIFT	11
+#define PMCR_N_MASK	0x1f
+
+#define PMCNTEN_CYCLES	(1UL << 31)
+
+/* Also count at EL2; EL1, EL0 and EL3 are counted by default */
+#define PMEVTYPER_NSH	(1 << 27)
+
+#define MDCR_EL3_SPME	(1 << 17)	/* allow counting in secure state */
+
+/* Common architectural event numbers */
+#define PMU_EV_L1D_CACHE_REFILL	0x03
+#define PMU_EV_L1D_TLB_REFILL	0x05
+#define PMU_EV_INST_RETIRED	0x08
+#define PMU_EV_L2D_CACHE_REFILL	0x17
+#define PMU_EV_CHAIN		0x1e
+
+/*
+ * Event counters are only 32 bits wide, which instructions overflow in a
+ * couple of seconds. So they are counted by a chained pair of counters,
+ * the odd one counting overflows of the even one. The cycle counter has
+ * its own 64-bit register.
+ */
+static const struct {
+	enum pmu_event event;
+	u8 type;
+	u8 counter;
+	bool chained;
+} pmu_counters[] = {
+	{ PMU_INSTRUCTIONS, PMU_EV_INST_RETIRED, 0, true },
+	{ PMU_L1D_MISSES, PMU_EV_L1D_CACHE_REFILL, 2, false },
+	{ PMU_L2D_MISSES, PMU_EV_L2D_CACHE_REFILL, 3, false },
+	{ PMU_TLB_MISSES, PMU_EV_L1D_TLB_REFILL, 4, false },
+};
+
+static inline ulong pmu_read_pmcr(void)
+{
+	ulong val;
+
+	asm volatile("mrs %0, pmcr_el0" : "=r" (val));
+
+	return val;
+}
+
+static void pmu_set_counter(int counter, ulong type)
+{
+	asm volatile("msr pmselr_el0, %0" : : "r" ((ulong)counter));
+	isb();
+	asm volatile("msr pmxevtyper_el0, %0" : : "r" (type | PMEVTYPER_NSH));
+	asm volatile("msr pmxevcntr_el0, %0" : : "r" (0UL));
+}
+
+static u32 pmu_get_counter(int counter)
+{
+	ulong val;
+
+	asm volatile("msr pmselr_el0, %0" : : "r" ((ulong)counter));
+	isb();
+	asm volatile("mrs %0, pmxevcntr_el0" : "=r" (val));
+
+	return val;
+}
+
+int pmu_init(void)
+{
+	ulong dfr0, pmcr, ceid, enable = PMCNTEN_CYCLES;
+	unsigned int ver, n, i;
+
+	asm volatile("mrs %0, id_aa64dfr0_el1" : "=r" (dfr0));
+	ver = (dfr0 >> ID_AA64DFR0_PMUVER_SHIFT) & ID_AA64DFR0_PMUVER_MASK;
+	if (!ver || ver == ID_AA64DFR0_PMUVER_MASK)
+		return -ENODEV;
+
+	/* Keep the counts if the counters were started before relocation */
+	pmcr = pmu_read_pmcr();
+	if (pmcr & PMCR_E)
+		return 0;
+
+	if (current_el() == 3) {
+		ulong mdcr;
+
+		asm volatile("mrs %0, mdcr_el3" : "=r" (mdcr));
+		asm volatile("msr mdcr_el3, %0" : : "r" (mdcr | MDCR_EL3_SPME));
+	}
+
+	n = (pmcr >> PMCR_N_SHIFT) & PMCR_N_MASK;
+	asm volatile("mrs %0, pmceid0_el0" : "=r" (ceid));
+	for (i = 0; i < ARRAY_SIZE(pmu_counters); i++) {
+		int counter = pmu_counters[i].counter;
+		bool chained = pmu_counters[i].chained;
+
+		if (counter + chained >= n ||
+		    !(ceid & (1UL << pmu_counters[i].type)))
+			continue;
+		pmu_set_counter(counter, pmu_counters[i].type);
+		enable |= 1UL << counter;
+		if (chained) {
+			pmu_set_counter(counter + 1, PMU_EV_CHAIN);
+			enable |= 1UL << (counter + 1);
+		}
+	}
+
+	asm volatile("msr pmccfiltr_el0, %0" : : "r" ((ulong)PMEVTYPER_NSH));
+	asm volatile("msr pmcntenset_el0, %0" : : "r" (enable));
+	asm volatile("msr pmcr_el0, %0"
+		     : : "r" (pmcr | PMCR_E | PMCR_P | PMCR_C | PMCR_LC));
+	isb();
+
+	return 0;
+}
+
+int pmu_read(struct pmu_snapshot *snap)
+{
+	ulong enabled, cycles;
+	unsigned int i;
+
+	memset(snap, '\0', sizeof(*snap));
+	if (!(pmu_read_pmcr() & PMCR_E))
+		return -ENODEV;
+
+	asm volatile("mrs %0, pmccntr_el0" : "=r" (cycles));
+	snap->count[PMU_CYCLES] = cycles;
+
+	asm volatile("mrs %0, pmcntenset_el0" : "=r" (enabled));
+	for (i = 0; i < ARRAY_SIZE(pmu_counters); i++) {
+		int counter = pmu_counters[i].counter;
+		u32 lo, hi;
+
+		if (!(enabled & (1UL << counter)))
+			continue;
+		if (!pmu_counters[i].chained) {
+			snap->count[pmu_counters[i].event] =
+				pmu_get_counter(counter);
+			continue;
+		}
+
+		/* Re-read if the low half wrapped between the two reads */
+		do {
+			hi = pmu_get_counter(counter + 1);
+			lo = pmu_get_counter(counter);
+		} while (hi != pmu_get_counter(counter + 1));
+		snap->count[pmu_counters[i].event] = (u64)hi << 32 | lo;
+	}
+
+	return 0;
+}
@@ -78,6 +78,7 @@
 #define HCR_EL2_RW_AARCH64	(1 << 31) /* EL1 is AArch64                   */
 #define HCR_EL2_RW_AARCH32	(0 << 31) /* Lower levels are AArch32         */
 #define HCR_EL2_HCD_DIS		(1 << 29) /* Hypervisor Call disabled         */
+#define HCR_EL2_IMO		(1 << 4)  /* Route IRQs to EL2                */
 
 /*
  * CPACR_EL1 bits definitions
@@ -255,6 +256,16 @@ void smc_call(struct pt_regs *args);
 void __noreturn psci_system_reset(void);
 void __noreturn psci_system_off(void);
 
+#ifdef CONFIG_PERF_SAMPLE
+/*
+ * Route the profiling timer PPI to the current exception level and
+ * unmask IRQs, see arch/arm/lib/interrupts_64.c
+ */
+int arch_perf_irq_enable(int ppi);
+void arch_perf_irq_disable(void);
+void arch_perf_timer_irq(struct pt_regs *regs);
+#endif
+
 #ifdef CONFIG_ARMV8_PSCI
 extern char __secure_start[];
 extern char __secure_end[];
@@ -6,9 +6,13 @@
  */
 
 #include <common.h>
+#include <errno.h>
 #include <linux/compiler.h>
+#include <linux/stringify.h>
 #include <efi_loader.h>
-
+#include <asm/gic.h>
+#include <asm/io.h>
+#include <asm/system.h>
 
 int interrupt_init(void)
 {
@@ -92,12 +96,149 @@ void do_sync(struct pt_regs *pt_regs, unsigned int esr)
 	panic("Resetting CPU ...\n");
 }
 
+#ifdef CONFIG_PERF_SAMPLE
+/*
+ * The sampling profiler is the only user of interrupts in U-Boot. It
+ * enables a single PPI on the boot CPU and handles it in do_irq().
+ */
+#define GIC_SPURIOUS_INTID	1023
+
+static int perf_ppi = -1;
+static unsigned long perf_saved_route;
+
+#ifdef CONFIG_GICV3
+static void *perf_gicr_sgi_base(void)
+{
+	unsigned long mpidr, aff;
+	void *rd = (void *)GICR_BASE;
+	u64 typer;
+
+	asm volatile("mrs %0, mpidr_el1" : "=r" (mpidr));
+	aff = ((mpidr >> 8) & 0xff000000) | (mpidr & 0xffffff);
+
+	/* Each redistributor has an RD_base and an SGI_base frame */
+	do {
+		typer = readq(rd + GICR_TYPER);
+		if ((typer >> 32) == aff)
+			return rd + 0x10000;
+		rd += 2 << 16;
+	} while (!(typer & (1 << 4)));	/* GICR_TYPER.Last */
+
+	return NULL;
+}
+#endif
+
+int arch_perf_irq_enable(int ppi)
+{
+	unsigned long route;
+#ifdef CONFIG_GICV3
+	void *sgi;
+#endif
+
+	/*
+	 * The secure GIC set-up makes every interrupt group 1, which at EL3
+	 * arrives as an FIQ (GICv3) or is not acknowledged by a secure read
+	 * of GICC_IAR (GICv2), so leave the interrupts to the next stage
+	 */
+	if (current_el() == 3)
+		return -EOPNOTSUPP;
+
+#if defined(CONFIG_GICV3)
+	sgi = perf_gicr_sgi_base();
+	if (!sgi)
+		return -ENODEV;
+	writeb(0, sgi + GICR_IPRIORITYRn + ppi);
+	writel(1 << ppi, sgi + GICR_ISENABLERn);
+	asm volatile("msr " __stringify(ICC_PMR_EL1) ", %0" : : "r" (0xffUL));
+	asm volatile("msr " __stringify(ICC_IGRPEN1_EL1) ", %0" : : "r" (1UL));
+#elif defined(CONFIG_GICV2)
+	writeb(0, GICD_BASE + GICD_IPRIORITYRn + ppi);
+	writel(1 << ppi, GICD_BASE + GICD_ISENABLERn);
+	writel(0xff, GICC_BASE + GICC_PMR);
+	writel(readl(GICC_BASE + GICC_CTLR) | 3, GICC_BASE + GICC_CTLR);
+#else
+	return -ENOSYS;
+#endif
+	isb();
+
+	/* Take IRQs at EL2 if U-Boot runs there */
+	if (current_el() == 2) {
+		asm volatile("mrs %0, hcr_el2" : "=r" (route));
+		perf_saved_route = route;
+		asm volatile("msr hcr_el2, %0" : : "r" (route | HCR_EL2_IMO));
+		isb();
+	}
+
+	perf_ppi = ppi;
+	asm volatile("msr daifclr, #2");
+
+	return 0;
+}
+
+void arch_perf_irq_disable(void)
+{
+#ifdef CONFIG_GICV3
+	void *sgi;
+#endif
+
+	if (perf_ppi < 0)
+		return;
+
+	asm volatile("msr daifset, #2");
+#if defined(CONFIG_GICV3)
+	sgi = perf_gicr_sgi_base();
+	if (sgi)
+		writel(1 << perf_ppi, sgi + GICR_ICENABLERn);
+#elif defined(CONFIG_GICV2)
+	writel(1 << perf_ppi, GICD_BASE + GICD_ICENABLERn);
+#endif
+
+	if (current_el() == 2) {
+		asm volatile("msr hcr_el2, %0" : : "r" (perf_saved_route));
+		isb();
+	}
+	perf_ppi = -1;
+}
+
+static bool perf_handle_irq(struct pt_regs *pt_regs)
+{
+	unsigned long intid;
+
+#if defined(CONFIG_GICV3)
+	asm volatile("mrs %0, " __stringify(ICC_IAR1_EL1) : "=r" (intid));
+#elif defined(CONFIG_GICV2)
+	intid = readl(GICC_BASE + GICC_IAR);
+#else
+	return false;
+#endif
+	intid &= 0x3ff;
+	if (intid == GIC_SPURIOUS_INTID)
+		return true;
+	if ((int)intid != perf_ppi)
+		return false;
+
+	arch_perf_timer_irq(pt_regs);
+
+#if defined(CONFIG_GICV3)
+	asm volatile("msr " __stringify(ICC_EOIR1_EL1) ", %0" : : "r" (intid));
+#elif defined(CONFIG_GICV2)
+	writel(intid, GICC_BASE + GICC_EOIR);
+#endif
+
+	return true;
+}
+#endif
+
 /*
  * do_irq handles the Irq exception.
  */
 void do_irq(struct pt_regs *pt_regs, unsigned int esr)
 {
 	efi_restore_gd();
+#ifdef CONFIG_PERF_SAMPLE
+	if (perf_handle_irq(pt_regs))
+		return;
+#endif
 	printf("\"Irq\" handler, esr 0x%08x\n", esr);
 	show_regs(pt_regs);
 	panic("Resetting CPU ...\n");
@@ -15,10 +15,12 @@
 #include <time.h>
 #include <unistd.h>
 #include <sys/mman.h>
+#include <sys/syscall.h>
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/types.h>
 #include <linux/types.h>
+#include <linux/perf_event.h>
 
 #include <asm/getopt.h>
 #include <asm/sections.h>
@@ -206,6 +208,33 @@ uint64_t __attribute__((no_instrument_function)) os_get_nsec(void)
 #endif
 }
 
+int os_perf_open(unsigned int type, uint64_t config)
+{
+	struct perf_event_attr attr;
+	int fd;
+
+	memset(&attr, '\0', sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = type;
+	attr.config = config;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+
+	fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+	if (fd < 0)
+		return -errno;
+
+	return fd;
+}
+
+int os_perf_read(int fd, uint64_t *count)
+{
+	if (read(fd, count, sizeof(*count)) != sizeof(*count))
+		return -EIO;
+
+	return 0;
+}
+
 static char *short_opts;
 static struct option *long_opts;
 
@@ -0,0 +1,78 @@
+/*
+ * Sandbox PMU counters, backed by the host's perf events
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <os.h>
+#include <pmu.h>
+
+/* Event types and numbers from the Linux perf_event_open() ABI */
+#define PERF_TYPE_HARDWARE		0
+#define PERF_TYPE_HW_CACHE		3
+#define PERF_COUNT_HW_CPU_CYCLES	0
+#define PERF_COUNT_HW_INSTRUCTIONS	1
+#define PERF_CACHE_READ_MISS(cache)	((cache) | 0 << 8 | 1 << 16)
+#define PERF_COUNT_HW_CACHE_L1D		0
+#define PERF_COUNT_HW_CACHE_LL		2
+#define PERF_COUNT_HW_CACHE_DTLB	3
+
+static const struct {
+	unsigned int type;
+	u64 config;
+} pmu_host_events[PMU_EVENT_COUNT] = {
+	[PMU_CYCLES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+	[PMU_INSTRUCTIONS] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+	[PMU_L1D_MISSES] = { PERF_TYPE_HW_CACHE,
+			     PERF_CACHE_READ_MISS(PERF_COUNT_HW_CACHE_L1D) },
+	[PMU_L2D_MISSES] = { PERF_TYPE_HW_CACHE,
+			     PERF_CACHE_READ_MISS(PERF_COUNT_HW_CACHE_LL) },
+	[PMU_TLB_MISSES] = { PERF_TYPE_HW_CACHE,
+			     PERF_CACHE_READ_MISS(PERF_COUNT_HW_CACHE_DTLB) },
+};
+
+/* Host file descriptor for each event, or -ve if it cannot be counted */
+static int pmu_fds[PMU_EVENT_COUNT];
+static bool pmu_running;
+
+int pmu_init(void)
+{
+	bool any = false;
+	int i;
+
+	if (pmu_running)
+		return 0;
+
+	for (i = 0; i < PMU_EVENT_COUNT; i++) {
+		pmu_fds[i] = os_perf_open(pmu_host_events[i].type,
+					  pmu_host_events[i].config);
+		if (pmu_fds[i] >= 0)
+			any = true;
+		else
+			debug("%s: cannot count %s (err=%d)\n", __func__,
+			      pmu_event_name(i), pmu_fds[i]);
+	}
+	if (!any)
+		return -ENODEV;
+	pmu_running = true;
+
+	return 0;
+}
+
+int pmu_read(struct pmu_snapshot *snap)
+{
+	int i;
+
+	memset(snap, '\0', sizeof(*snap));
+	if (!pmu_running)
+		return -ENODEV;
+
+	for (i = 0; i < PMU_EVENT_COUNT; i++) {
+		if (pmu_fds[i] >= 0)
+			os_perf_read(pmu_fds[i], &snap->count[i]);
+	}
+
+	return 0;
+}
@@ -14,4 +14,34 @@ void sandbox_eth_disable_response(int index, bool disable);
 
 void sandbox_eth_skip_timeout(void);
 
+/* Number of packets which can be queued to be received */
+#define SANDBOX_ETH_QUEUE	32
+
+/**
+ * sandbox_eth_tx_hand_f() - Handle a packet sent by the sandbox driver
+ *
+ * This can act as the other end of a connection, replying with
+ * sandbox_eth_queue_recv().
+ *
+ * @dev:	Ethernet device
+ * @packet:	Packet sent
+ * @len:	Length of the packet
+ * @return 0 if OK, -ve on error, which is returned from the send
+ */
+typedef int sandbox_eth_tx_hand_f(struct udevice *dev, void *packet,
+				  unsigned int len);
+
+void sandbox_eth_set_tx_handler(int index, sandbox_eth_tx_hand_f *handler);
+
+/**
+ * sandbox_eth_queue_recv() - Queue a packet to be received
+ *
+ * @dev:	Ethernet device
+ * @packet:	Packet, which is copied
+ * @length:	Length of the packet
+ * @return 0 if OK, -ENOSPC if the queue is full, -EINVAL if too long
+ */
+int sandbox_eth_queue_recv(struct udevice *dev, const void *packet,
+			   int length);
+
 #endif /* __ETH_H */
@@ -5,6 +5,7 @@
  */
 
 #include <common.h>
+#include <mapmem.h>
 
 static int do_bootstage_report(cmd_tbl_t *cmdtp, int flag, int argc,
 			       char * const argv[])
@@ -58,10 +59,52 @@ static int do_bootstage_stash(cmd_tbl_t *cmdtp, int flag, int argc,
 	return 0;
 }
 
+#ifdef CONFIG_BOOTSTAGE_SPANS
+static int do_bootstage_export(cmd_tbl_t *cmdtp, int flag, int argc,
+			       char * const argv[])
+{
+	enum bootstage_export_fmt fmt;
+	ulong base, size = 0x10000;
+	char *endp, *buf;
+	int len;
+
+	if (argc < 3)
+		return CMD_RET_USAGE;
+	if (!strcmp(argv[1], "chrome"))
+		fmt = BOOTSTAGE_EXPORT_CHROME;
+	else if (!strcmp(argv[1], "folded"))
+		fmt = BOOTSTAGE_EXPORT_FOLDED;
+	else
+		return CMD_RET_USAGE;
+	base = simple_strtoul(argv[2], &endp, 16);
+	if (*argv[2] == 0 || *endp != 0)
+		return CMD_RET_USAGE;
+	if (argc > 3)
+		size = simple_strtoul(argv[3], NULL, 16);
+
+	buf = map_sysmem(base, size);
+	len = bootstage_export(fmt, buf, size);
+	unmap_sysmem(buf);
+	if (len < 0)
+		return CMD_RET_FAILURE;
+	if (len > size) {
+		printf("Not enough space, %#x bytes needed\n", len);
+		return CMD_RET_FAILURE;
+	}
+	printf("%d bytes written to %08lx\n", len, base);
+	setenv_hex("filesize", len);
+
+	return 0;
+}
+#endif
+
 static cmd_tbl_t cmd_bootstage_sub[] = {
 	U_BOOT_CMD_MKENT(report, 2, 1, do_bootstage_report, "", ""),
 	U_BOOT_CMD_MKENT(stash, 4, 0, do_bootstage_stash, "", ""),
 	U_BOOT_CMD_MKENT(unstash, 4, 0, do_bootstage_stash, "", ""),
+#ifdef CONFIG_BOOTSTAGE_SPANS
+	U_BOOT_CMD_MKENT(export, 4, 0, do_bootstage_export, "", ""),
+#endif
 };
 
 /*
@@ -86,10 +129,15 @@ static int do_boostage(cmd_tbl_t *cmdtp, int flag, int argc,
 }
 
 
-U_BOOT_CMD(bootstage, 4, 1, do_boostage,
+U_BOOT_CMD(bootstage, 5, 1, do_boostage,
 	"Boot stage command",
 	" - check boot progress and timing\n"
 	"report                      - Print a report\n"
 	"stash [<start> [<size>]]    - Stash data into memory\n"
 	"unstash [<start> [<size>]]  - Unstash data from memory"
+#ifdef CONFIG_BOOTSTAGE_SPANS
+	"\nexport chrome|folded <addr> [<size>]\n"
+	"                            - Export spans to memory, setting\n"
+	"                              'filesize' so they can be saved"
+#endif
 );
@@ -0,0 +1,42 @@
+/*
+ * Show what malloc() is used for
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc_track.h>
+
+static int do_malloc(cmd_tbl_t *cmdtp, int flag, int argc,
+		     char * const argv[])
+{
+	const char *cmd = argc < 2 ? NULL : argv[1];
+
+	if (!cmd)
+		return CMD_RET_USAGE;
+	switch (*cmd) {
+	case 't':
+		malloc_track_print_top(argc > 2 ?
+				       simple_strtoul(argv[2], NULL, 10) : 20);
+		break;
+	case 'l':
+		malloc_track_print_live();
+		break;
+	case 'p':
+		malloc_track_print_phases();
+		break;
+	default:
+		return CMD_RET_USAGE;
+	}
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	malloc,	3,	1,	do_malloc,
+	"show malloc() use by each caller",
+	"top [<n>]  - show the <n> callers which allocated most bytes\n"
+	"malloc live       - show allocations which are not freed yet\n"
+	"malloc phases     - show the peak use in each boot phase"
+);
@@ -64,9 +64,10 @@ U_BOOT_CMD(
 	tftpsrv,	2,	1,	do_tftpsrv,
 	"act as a TFTP server and boot the first received file",
 	"[loadAddress]\n"
-	"Listen for an incoming TFTP transfer, receive a file and boot it.\n"
-	"The transfer is aborted if a transfer has not been started after\n"
-	"about 50 seconds or if Ctrl-C is pressed."
+	"Serve TFTP transfers until a file is put into memory, then boot it.\n"
+	"Clients may get the image at loadAddress (of size $filesize), or\n"
+	"get or put a block device or partition named like 'mmc/0:1'.\n"
+	"Press Ctrl-C to stop the server."
 );
 #endif
 
@@ -110,6 +111,19 @@ U_BOOT_CMD(
 );
 #endif
 
+#if defined(CONFIG_CMD_WGET)
+static int do_wget(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	return netboot_common(WGET, cmdtp, argc, argv);
+}
+
+U_BOOT_CMD(
+	wget,	3,	1,	do_wget,
+	"boot image via network using HTTP",
+	"[loadAddress] [[hostIPaddr:]path]"
+);
+#endif
+
 static void netboot_update_env(void)
 {
 	char tmp[22];
@@ -281,6 +295,31 @@ U_BOOT_CMD(
 );
 #endif
 
+#if defined(CONFIG_CMD_ARP)
+static int do_arp(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	if (argc == 1) {
+		arp_cache_show();
+		return CMD_RET_SUCCESS;
+	}
+	if (argc == 2 && !strcmp(argv[1], "-d")) {
+		arp_cache_flush();
+		return CMD_RET_SUCCESS;
+	}
+
+	return CMD_RET_USAGE;
+}
+
+U_BOOT_CMD(
+	arp,	2,	1,	do_arp,
+	"show or clear the ARP cache",
+	"\n"
+	"    - show the addresses resolved by earlier commands\n"
+	"arp -d\n"
+	"    - forget them all"
+);
+#endif
+
 #if defined(CONFIG_CMD_CDP)
 
 static void cdp_update_env(void)
@@ -0,0 +1,187 @@
+/*
+ * Control of the sampling profiler
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <perf.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+struct perf_func {
+	ulong addr;		/* start of the function (link address) */
+	const char *name;	/* symbol name, or NULL if unknown */
+	unsigned int count;	/* samples taken in the function */
+};
+
+/* Find the function containing a sampled runtime address */
+static void perf_lookup(ulong pc, struct perf_func *func)
+{
+	func->addr = pc - gd->reloc_off;
+	func->name = NULL;
+#ifdef CONFIG_KALLSYMS
+	func->name = symbol_lookup(func->addr, &func->addr);
+#endif
+}
+
+static int perf_func_cmp(const void *a, const void *b)
+{
+	const struct perf_func *fa = a, *fb = b;
+
+	return fa->count > fb->count ? -1 : fa->count < fb->count;
+}
+
+static int perf_report(unsigned int top)
+{
+	struct perf_func *funcs, func;
+	unsigned int count, nfuncs, i, j;
+	ulong *samples, lost;
+
+	count = perf_get_samples(&samples, &lost);
+	if (!count) {
+		printf("No samples\n");
+		return 0;
+	}
+
+	funcs = malloc(count * sizeof(*funcs));
+	if (!funcs) {
+		printf("Out of memory\n");
+		return -1;
+	}
+
+	/* Samples are sorted, so each function's samples are adjacent */
+	for (i = nfuncs = 0; i < count; ) {
+		perf_lookup(samples[i], &func);
+		func.count = 0;
+		for (j = i; j < count && samples[j] == samples[i]; j++)
+			func.count++;
+		i = j;
+
+		if (nfuncs && funcs[nfuncs - 1].addr == func.addr)
+			funcs[nfuncs - 1].count += func.count;
+		else
+			funcs[nfuncs++] = func;
+	}
+	qsort(funcs, nfuncs, sizeof(*funcs), perf_func_cmp);
+
+	printf("%u samples in %u functions", count, nfuncs);
+	if (lost)
+		printf(", %lu older samples lost", lost);
+	printf("\n   Samples      %%  Address   Function\n");
+	for (i = 0; i < nfuncs && i < top; i++) {
+		printf("%10u %3u.%u%% %08lx  %s\n", funcs[i].count,
+		       funcs[i].count * 100 / count,
+		       funcs[i].count * 1000 / count % 10, funcs[i].addr,
+		       funcs[i].name ? funcs[i].name : "?");
+	}
+	free(funcs);
+
+	return 0;
+}
+
+static int do_perf_dump(cmd_tbl_t *cmdtp, int flag, int argc,
+			char * const argv[])
+{
+	size_t buff_size, avail, buff_ptr, used;
+	unsigned int needed;
+	char *buff;
+	int err;
+
+	perf_stop();
+	if (argc < 3) {
+		buff_size = getenv_ulong("profsize", 16, 0);
+		buff = map_sysmem(getenv_ulong("profbase", 16, 0), buff_size);
+		buff_ptr = getenv_ulong("profoffset", 16, 0);
+	} else {
+		buff_size = simple_strtoul(argv[2], NULL, 16);
+		buff = map_sysmem(simple_strtoul(argv[1], NULL, 16),
+				  buff_size);
+		buff_ptr = 0;
+	}
+	if (!buff_size)
+		return CMD_RET_USAGE;
+
+	avail = buff_size - buff_ptr;
+	err = perf_list_samples(buff + buff_ptr, avail, &needed);
+	if (err)
+		printf("Error: truncated (%#x bytes needed)\n", needed);
+	used = min(avail, (size_t)needed);
+	printf("Samples dumped to %08lx, size %#zx\n",
+	       (ulong)map_to_sysmem(buff + buff_ptr), used);
+
+	setenv_hex("profbase", map_to_sysmem(buff));
+	setenv_hex("profsize", buff_size);
+	setenv_hex("profoffset", buff_ptr + used);
+
+	return 0;
+}
+
+static int do_perf_start(cmd_tbl_t *cmdtp, int flag, int argc,
+			 char * const argv[])
+{
+	unsigned int hz;
+	int ret;
+
+	hz = argc > 1 ? simple_strtoul(argv[1], NULL, 10) :
+		CONFIG_PERF_SAMPLE_HZ;
+	ret = perf_start(hz);
+	if (ret) {
+		printf("Cannot start profiler (err=%d)\n", ret);
+		return CMD_RET_FAILURE;
+	}
+
+	return 0;
+}
+
+static int do_perf_stop(cmd_tbl_t *cmdtp, int flag, int argc,
+			char * const argv[])
+{
+	perf_stop();
+
+	return 0;
+}
+
+static int do_perf_report(cmd_tbl_t *cmdtp, int flag, int argc,
+			  char * const argv[])
+{
+	perf_stop();
+	if (perf_report(argc > 1 ? simple_strtoul(argv[1], NULL, 10) : 20))
+		return CMD_RET_FAILURE;
+
+	return 0;
+}
+
+static cmd_tbl_t cmd_perf_sub[] = {
+	U_BOOT_CMD_MKENT(start, 2, 0, do_perf_start, "", ""),
+	U_BOOT_CMD_MKENT(stop, 1, 0, do_perf_stop, "", ""),
+	U_BOOT_CMD_MKENT(report, 2, 0, do_perf_report, "", ""),
+	U_BOOT_CMD_MKENT(dump, 3, 0, do_perf_dump, "", ""),
+};
+
+static int do_perf(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	cmd_tbl_t *c;
+
+	/* Strip off leading 'perf' command argument */
+	argc--;
+	argv++;
+
+	c = find_cmd_tbl(argv[0], cmd_perf_sub, ARRAY_SIZE(cmd_perf_sub));
+	if (!c || argc > c->maxargs)
+		return CMD_RET_USAGE;
+
+	return c->cmd(cmdtp, flag, argc, argv);
+}
+
+U_BOOT_CMD(
+	perf,	4,	1,	do_perf,
+	"sampling profiler",
+	"start [<hz>]             - start sampling the program counter\n"
+	"perf stop                     - stop sampling\n"
+	"perf report [<n>]             - show the <n> functions with most samples\n"
+	"perf dump [<addr> <size>]     - dump samples into buffer for proftool"
+);
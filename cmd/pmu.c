@@ -0,0 +1,64 @@
+/*
+ * Hardware performance counter command
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <pmu.h>
+
+static int do_pmu_run(cmd_tbl_t *cmdtp, int flag, int argc,
+		      char * const argv[])
+{
+	struct pmu_snapshot start, end, diff;
+	enum command_ret_t ret;
+	int repeatable = 1;
+	ulong us;
+
+	if (argc < 2)
+		return CMD_RET_USAGE;
+
+	us = timer_get_us();
+	pmu_read(&start);
+	ret = cmd_process(flag, argc - 1, argv + 1, &repeatable, NULL);
+	pmu_read(&end);
+	us = timer_get_us() - us;
+
+	pmu_diff(&diff, &start, &end);
+	pmu_print(&diff);
+	print_grouped_ull(us, 12);
+	printf(" us elapsed\n");
+
+	return ret;
+}
+
+static int do_pmu(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	struct pmu_snapshot snap;
+	int ret;
+
+	ret = pmu_init();
+	if (ret) {
+		printf("No performance counters (err=%d)\n", ret);
+		return CMD_RET_FAILURE;
+	}
+
+	if (argc > 1 && !strcmp(argv[1], "run"))
+		return do_pmu_run(cmdtp, flag, argc - 1, argv + 1);
+	if (argc > 1)
+		return CMD_RET_USAGE;
+
+	pmu_read(&snap);
+	pmu_print(&snap);
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	pmu,	CONFIG_SYS_MAXARGS,	0,	do_pmu,
+	"hardware performance counters",
+	"\n    - show the counts since the counters were started\n"
+	"pmu run <command> [<args>...]\n"
+	"    - run a command and show the counts it took"
+);
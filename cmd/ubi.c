@@ -85,6 +85,14 @@ static void display_ubi_info(struct ubi_device *ubi)
 	ubi_msg("number of PEBs reserved for bad PEB handling: %d",
 			ubi->beb_rsvd_pebs);
 	ubi_msg("max/mean erase counter: %d/%d", ubi->max_ec, ubi->mean_ec);
+	ubi_msg("attached from:              %s%s",
+			ubi->attach_stats.fastmap ? "fastmap" : "scan",
+			ubi->attach_stats.fm_written ? " (fastmap written)" : "");
+	ubi_msg("attach time:                %lu ms",
+			ubi->attach_stats.time);
+	ubi_msg("PEBs scanned:               %d (%d with one header read)",
+			ubi->attach_stats.scanned,
+			ubi->attach_stats.hdr_reads);
 }
 
 static int ubi_info(int layout)
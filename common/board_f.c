@@ -23,6 +23,7 @@
 #include <malloc.h>
 #include <mapmem.h>
 #include <os.h>
+#include <pmu.h>
 #include <post.h>
 #include <relocate.h>
 #include <spi.h>
@@ -699,6 +700,20 @@ static int jump_to_copy(void)
 }
 #endif
 
+#ifdef CONFIG_PMU
+/* Start the performance counters, carrying on without them on failure */
+static int initf_pmu(void)
+{
+	int ret;
+
+	ret = pmu_init();
+	if (ret)
+		debug("PMU not available (err=%d)\n", ret);
+
+	return 0;
+}
+#endif
+
 /* Record the board_init_f() bootstage (after arch_cpu_init()) */
 static int initf_bootstage(void)
 {
@@ -774,6 +789,9 @@ static const init_fnc_t init_sequence_f[] = {
 	trace_early_init,
 #endif
 	initf_malloc,
+#ifdef CONFIG_PMU
+	initf_pmu,		/* before bootstage, which can record counts */
+#endif
 	initf_bootstage,	/* uses its own timer, so does not need DM */
 	initf_console_record,
 #if defined(CONFIG_HAVE_FSP)
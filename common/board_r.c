@@ -35,6 +35,7 @@
 #endif
 #include <logbuff.h>
 #include <malloc.h>
+#include <malloc_track.h>
 #include <mapmem.h>
 #ifdef CONFIG_BITBANGMII
 #include <miiphy.h>
@@ -264,6 +265,8 @@ static int initr_malloc(void)
 	malloc_start = gd->relocaddr - TOTAL_MALLOC_LEN;
 	mem_malloc_init((ulong)map_sysmem(malloc_start, TOTAL_MALLOC_LEN),
 			TOTAL_MALLOC_LEN);
+	if (malloc_track_init())
+		printf("Cannot track malloc() use\n");
 	return 0;
 }
 
@@ -684,6 +687,7 @@ static int initr_kbd(void)
 
 static int run_main_loop(void)
 {
+	malloc_track_set_phase(MALLOC_PHASE_CLI);
 #ifdef CONFIG_SANDBOX
 	sandbox_main_loop_init();
 #endif
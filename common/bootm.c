@@ -13,7 +13,9 @@
 #include <fdt_support.h>
 #include <lmb.h>
 #include <malloc.h>
+#include <malloc_track.h>
 #include <mapmem.h>
+#include <perf.h>
 #include <asm/io.h>
 #include <linux/lzo.h>
 #include <lzma/LzmaTypes.h>
@@ -71,6 +73,10 @@ static inline void boot_start_lmb(bootm_headers_t *images) { }
 static int bootm_start(cmd_tbl_t *cmdtp, int flag, int argc,
 		       char * const argv[])
 {
+#ifdef CONFIG_LMB
+	/* Free any region storage left by a previous bootm */
+	lmb_release(&images.lmb);
+#endif
 	memset((void *)&images, 0, sizeof(images));
 	images.verify = getenv_yesno("verify");
 
@@ -492,6 +498,10 @@ ulong bootm_disable_interrupts(void)
 	 * recover from any failures any more...
 	 */
 	iflag = disable_interrupts();
+#ifdef CONFIG_PERF_SAMPLE
+	perf_stop();
+#endif
+	malloc_track_set_phase(MALLOC_PHASE_HANDOFF);
 #ifdef CONFIG_NETCONSOLE
 	/* Stop the ethernet stack if NetConsole could have left it up */
 	eth_halt();
@@ -13,12 +13,17 @@
 #include <common.h>
 #include <libfdt.h>
 #include <malloc.h>
+#include <pmu.h>
 #include <linux/compiler.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
 enum {
 	RECORD_COUNT = CONFIG_BOOTSTAGE_RECORD_COUNT,
+#ifdef CONFIG_BOOTSTAGE_SPANS
+	SPAN_COUNT = CONFIG_BOOTSTAGE_SPAN_COUNT,
+	SPAN_MAX_DEPTH = 32,
+#endif
 };
 
 struct bootstage_record {
@@ -27,12 +32,38 @@ struct bootstage_record {
 	const char *name;
 	int flags;		/* see enum bootstage_flags */
 	enum bootstage_id id;
+#ifdef CONFIG_BOOTSTAGE_PMU
+	struct pmu_snapshot pmu;	/* counters at the time of the mark */
+#endif
+};
+
+#ifdef CONFIG_BOOTSTAGE_SPANS
+/*
+ * A span covers the time between bootstage_span_begin() and
+ * bootstage_span_end(). Spans begun while another one is open become its
+ * children, so that for example the probe of an MMC device shows up
+ * inside the command which caused it.
+ */
+struct bootstage_span {
+	const char *name;
+	uint32_t start_us;
+	uint32_t duration_us;
+	int parent;		/* index of the enclosing span, or -1 */
+	bool open;
 };
+#endif
 
 struct bootstage_data {
 	uint rec_count;
 	uint next_id;
 	struct bootstage_record record[RECORD_COUNT];
+#ifdef CONFIG_BOOTSTAGE_SPANS
+	uint span_count;
+	uint span_lost;		/* spans not recorded as the table was full */
+	int span_cur;		/* innermost open span, or -1 */
+	bool span_copy_names;	/* malloc() is ready, names are copied */
+	struct bootstage_span span[SPAN_COUNT];
+#endif
 };
 
 enum {
@@ -60,6 +91,11 @@ int bootstage_relocate(void)
 	debug("Relocating %d records\n", data->rec_count);
 	for (i = 0; i < data->rec_count; i++)
 		data->record[i].name = strdup(data->record[i].name);
+#ifdef CONFIG_BOOTSTAGE_SPANS
+	for (i = 0; i < data->span_count; i++)
+		data->span[i].name = strdup(data->span[i].name);
+	data->span_copy_names = true;
+#endif
 
 	return 0;
 }
@@ -111,6 +147,9 @@ ulong bootstage_add_record(enum bootstage_id id, const char *name,
 		rec->name = name;
 		rec->flags = flags;
 		rec->id = id;
+#ifdef CONFIG_BOOTSTAGE_PMU
+		pmu_read(&rec->pmu);
+#endif
 	}
 
 	/* Tell the board about this progress */
@@ -196,6 +235,115 @@ uint32_t bootstage_accum(enum bootstage_id id)
 	return duration;
 }
 
+#ifdef CONFIG_BOOTSTAGE_SPANS
+int bootstage_span_begin(const char *name)
+{
+	struct bootstage_data *data = gd->bootstage;
+	struct bootstage_span *span;
+
+	if (!data)
+		return -ENOENT;
+	if (data->span_count == SPAN_COUNT) {
+		data->span_lost++;
+		return -ENOSPC;
+	}
+
+	/*
+	 * Names such as those of devices may be freed long before the spans
+	 * are reported, so keep a copy. Until relocation there is no malloc()
+	 * to spare; bootstage_relocate() copies the names taken so far.
+	 */
+	if (data->span_copy_names) {
+		name = strdup(name);
+		if (!name)
+			return -ENOMEM;
+	}
+
+	span = &data->span[data->span_count];
+	span->name = name;
+	span->parent = data->span_cur;
+	span->open = true;
+	span->duration_us = 0;
+	span->start_us = timer_get_boot_us();
+	data->span_cur = data->span_count;
+
+	return data->span_count++;
+}
+
+uint32_t bootstage_span_end(int id)
+{
+	struct bootstage_data *data = gd->bootstage;
+	struct bootstage_span *span;
+	uint32_t now;
+
+	if (!data || id < 0 || id >= data->span_count)
+		return 0;
+
+	span = &data->span[id];
+	if (!span->open)
+		return span->duration_us;
+
+	/* Close any children left open, e.g. by an error path */
+	now = timer_get_boot_us();
+	while (data->span_cur >= id) {
+		struct bootstage_span *child = &data->span[data->span_cur];
+
+		child->duration_us = now - child->start_us;
+		child->open = false;
+		data->span_cur = child->parent;
+	}
+
+	return span->duration_us;
+}
+
+/* Get the duration of a span, counting open spans up to now */
+static uint32_t span_duration(const struct bootstage_span *span, uint32_t now)
+{
+	return span->open ? now - span->start_us : span->duration_us;
+}
+
+/* Get the time spent in a span but outside any of its children */
+static uint32_t span_self_time(const struct bootstage_data *data, int id,
+			       uint32_t now)
+{
+	uint32_t self = span_duration(&data->span[id], now);
+	int i;
+
+	/* Children always follow their parent in the table */
+	for (i = id + 1; i < data->span_count; i++) {
+		if (data->span[i].parent == id)
+			self -= span_duration(&data->span[i], now);
+	}
+
+	return self;
+}
+
+static void print_spans(const struct bootstage_data *data)
+{
+	uint32_t now = timer_get_boot_us();
+	int i, depth, p;
+
+	printf("\nSpans:\n%11s%11s%11s  %s\n", "Start", "Duration", "Self",
+	       "Span");
+	for (i = 0; i < data->span_count; i++) {
+		const struct bootstage_span *span = &data->span[i];
+
+		for (depth = 0, p = span->parent; p >= 0;
+		     p = data->span[p].parent)
+			depth++;
+		print_grouped_ull(span->start_us, BOOTSTAGE_DIGITS);
+		print_grouped_ull(span_duration(span, now), BOOTSTAGE_DIGITS);
+		print_grouped_ull(span_self_time(data, i, now),
+				  BOOTSTAGE_DIGITS);
+		printf("  %*s%s%s\n", min(depth, (int)SPAN_MAX_DEPTH) * 2, "",
+		       span->name, span->open ? " (open)" : "");
+	}
+	if (data->span_lost)
+		printf("%u spans lost - please increase CONFIG_BOOTSTAGE_SPAN_COUNT\n",
+		       data->span_lost);
+}
+#endif
+
 /**
  * Get a record name as a printable string
  *
@@ -217,6 +365,26 @@ static const char *get_record_name(char *buf, int len,
 	return buf;
 }
 
+#ifdef CONFIG_BOOTSTAGE_PMU
+/* Counters at the previous mark printed in the report */
+static struct pmu_snapshot pmu_prev;
+
+/* Print the cycles and instructions since the previous mark */
+static void print_pmu_record(const struct bootstage_record *rec, bool accum)
+{
+	struct pmu_snapshot diff;
+
+	if (accum) {
+		printf("%30s", "");
+		return;
+	}
+	pmu_diff(&diff, &pmu_prev, &rec->pmu);
+	print_grouped_ull(diff.count[PMU_CYCLES], 12);
+	print_grouped_ull(diff.count[PMU_INSTRUCTIONS], 12);
+	pmu_prev = rec->pmu;
+}
+#endif
+
 static uint32_t print_time_record(struct bootstage_record *rec, uint32_t prev)
 {
 	char buf[20];
@@ -228,6 +396,9 @@ static uint32_t print_time_record(struct bootstage_record *rec, uint32_t prev)
 		print_grouped_ull(rec->time_us, BOOTSTAGE_DIGITS);
 		print_grouped_ull(rec->time_us - prev, BOOTSTAGE_DIGITS);
 	}
+#ifdef CONFIG_BOOTSTAGE_PMU
+	print_pmu_record(rec, prev == -1U);
+#endif
 	printf("  %s\n", get_record_name(buf, sizeof(buf), rec));
 
 	return rec->time_us;
@@ -241,6 +412,49 @@ static int h_compare_record(const void *r1, const void *r2)
 }
 
 #ifdef CONFIG_OF_LIBFDT
+#ifdef CONFIG_BOOTSTAGE_SPANS
+/**
+ * Add the spans to a 'spans' subnode of the bootstage node
+ *
+ * Each span gets a node named after its index with 'name', 'start' and
+ * 'duration' properties, and a 'parent' property holding the index of the
+ * enclosing span, if any.
+ *
+ * @param blob		Device tree blob
+ * @param bootstage	Offset of the bootstage node
+ * @return 0 on success, != 0 on failure.
+ */
+static int add_spans_devicetree(struct fdt_header *blob, int bootstage)
+{
+	struct bootstage_data *data = gd->bootstage;
+	uint32_t now = timer_get_boot_us();
+	int spans, node, i;
+
+	spans = fdt_add_subnode(blob, bootstage, "spans");
+	if (spans < 0)
+		return -EINVAL;
+
+	/* Added in reverse so that they appear in order */
+	for (i = data->span_count - 1; i >= 0; i--) {
+		struct bootstage_span *span = &data->span[i];
+
+		node = fdt_add_subnode(blob, spans, simple_itoa(i));
+		if (node < 0)
+			break;
+		if (fdt_setprop_string(blob, node, "name", span->name) ||
+		    fdt_setprop_cell(blob, node, "start", span->start_us) ||
+		    fdt_setprop_cell(blob, node, "duration",
+				     span_duration(span, now)))
+			return -EINVAL;
+		if (span->parent >= 0 &&
+		    fdt_setprop_cell(blob, node, "parent", span->parent))
+			return -EINVAL;
+	}
+
+	return 0;
+}
+#endif
+
 /**
  * Add all bootstage timings to a device tree.
  *
@@ -293,6 +507,11 @@ static int add_bootstages_devicetree(struct fdt_header *blob)
 			return -EINVAL;
 	}
 
+#ifdef CONFIG_BOOTSTAGE_SPANS
+	if (add_spans_devicetree(blob, bootstage))
+		return -EINVAL;
+#endif
+
 	return 0;
 }
 
@@ -314,7 +533,13 @@ void bootstage_report(void)
 
 	printf("Timer summary in microseconds (%d records):\n",
 	       data->rec_count);
+#ifdef CONFIG_BOOTSTAGE_PMU
+	memset(&pmu_prev, '\0', sizeof(pmu_prev));
+	printf("%11s%11s%15s%15s  %s\n", "Mark", "Elapsed", "Cycles",
+	       "Instructions", "Stage");
+#else
 	printf("%11s%11s  %s\n", "Mark", "Elapsed", "Stage");
+#endif
 
 	prev = print_time_record(rec, 0);
 
@@ -335,6 +560,9 @@ void bootstage_report(void)
 		if (rec->start_us)
 			prev = print_time_record(rec, -1);
 	}
+#ifdef CONFIG_BOOTSTAGE_SPANS
+	print_spans(data);
+#endif
 }
 
 /**
@@ -359,6 +587,94 @@ static void append_data(char **ptrp, char *end, const void *data, int size)
 	memcpy(ptr, data, size);
 }
 
+#ifdef CONFIG_BOOTSTAGE_SPANS
+/**
+ * Append formatted text to a memory buffer
+ *
+ * Like append_data(), the buffer pointer is incremented by the full length
+ * of the text even if it does not fit.
+ *
+ * @param ptrp	Pointer to buffer, updated by this function
+ * @param end	Pointer to end of buffer
+ * @param fmt	printf() format string
+ */
+static void append_printf(char **ptrp, char *end, const char *fmt, ...)
+{
+	char *ptr = *ptrp;
+	va_list args;
+	int len;
+
+	va_start(args, fmt);
+	len = vsnprintf(ptr, ptr < end ? end - ptr : 0, fmt, args);
+	va_end(args);
+	*ptrp += len;
+}
+
+/* Write the stack of span names leading to a span, outermost first */
+static void append_span_stack(char **ptrp, char *end,
+			      const struct bootstage_data *data, int id)
+{
+	int stack[SPAN_MAX_DEPTH];
+	int depth = 0;
+
+	for (; id >= 0 && depth < SPAN_MAX_DEPTH; id = data->span[id].parent)
+		stack[depth++] = id;
+	while (depth--)
+		append_printf(ptrp, end, "%s%s", data->span[stack[depth]].name,
+			      depth ? ";" : "");
+}
+
+int bootstage_export(enum bootstage_export_fmt fmt, char *buf, int size)
+{
+	const struct bootstage_data *data = gd->bootstage;
+	uint32_t now = timer_get_boot_us();
+	char *ptr = buf, *end = buf + size;
+	char name[20];
+	int i;
+
+	switch (fmt) {
+	case BOOTSTAGE_EXPORT_CHROME:
+		/* Spans are complete events, marks are instant events */
+		append_printf(&ptr, end, "{\"traceEvents\":[\n");
+		for (i = 0; i < data->span_count; i++) {
+			const struct bootstage_span *span = &data->span[i];
+
+			append_printf(&ptr, end,
+				      "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%u,\"dur\":%u,\"pid\":1,\"tid\":1},\n",
+				      span->name, span->start_us,
+				      span_duration(span, now));
+		}
+		for (i = 0; i < data->rec_count; i++) {
+			const struct bootstage_record *rec = &data->record[i];
+
+			if (rec->start_us)
+				continue;
+			append_printf(&ptr, end,
+				      "{\"name\":\"%s\",\"ph\":\"i\",\"ts\":%lu,\"pid\":1,\"tid\":1,\"s\":\"g\"},\n",
+				      get_record_name(name, sizeof(name), rec),
+				      rec->time_us);
+		}
+		/* Close with an event so that the last comma is valid JSON */
+		append_printf(&ptr, end,
+			      "{\"name\":\"export\",\"ph\":\"i\",\"ts\":%u,\"pid\":1,\"tid\":1,\"s\":\"g\"}\n]}\n",
+			      now);
+		break;
+	case BOOTSTAGE_EXPORT_FOLDED:
+		/* One line per span with its self time, as flamegraph.pl wants */
+		for (i = 0; i < data->span_count; i++) {
+			append_span_stack(&ptr, end, data, i);
+			append_printf(&ptr, end, " %u\n",
+				      span_self_time(data, i, now));
+		}
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return ptr - buf;
+}
+#endif
+
 int bootstage_stash(void *base, int size)
 {
 	const struct bootstage_data *data = gd->bootstage;
@@ -499,6 +815,9 @@ int bootstage_init(bool first)
 		return -ENOMEM;
 	data = gd->bootstage;
 	memset(data, '\0', size);
+#ifdef CONFIG_BOOTSTAGE_SPANS
+	data->span_cur = -1;
+#endif
 	if (first) {
 		data->next_id = BOOTSTAGE_ID_USER;
 		bootstage_add_record(BOOTSTAGE_ID_AWAKE, "reset", 0, 0);
@@ -35,6 +35,7 @@ int run_usb_dnl_gadget(int usbctrl_index, char *usb_dnl_gadget)
 		error("g_dnl_register failed");
 		return CMD_RET_FAILURE;
 	}
+	dfu_enable_write_queue(true);
 
 	while (1) {
 		if (g_dnl_detach()) {
@@ -82,8 +83,10 @@ int run_usb_dnl_gadget(int usbctrl_index, char *usb_dnl_gadget)
 
 		WATCHDOG_RESET();
 		usb_gadget_handle_interrupts(usbctrl_index);
+		dfu_poll();
 	}
 exit:
+	dfu_enable_write_queue(false);
 	g_dnl_unregister();
 	board_usb_cleanup(usbctrl_index, USB_INIT_DEVICE);
 
@@ -72,6 +72,15 @@ static lbaint_t fb_mmc_sparse_reserve(struct sparse_storage *info,
 	return blkcnt;
 }
 
+static lbaint_t fb_mmc_sparse_erase(struct sparse_storage *info,
+		lbaint_t blk, lbaint_t blkcnt)
+{
+	struct fb_mmc_sparse *sparse = info->priv;
+	struct blk_desc *dev_desc = sparse->dev_desc;
+
+	return blk_derase(dev_desc, blk, blkcnt);
+}
+
 static void write_raw_image(struct blk_desc *dev_desc, disk_partition_t *info,
 		const char *part_name, void *buffer,
 		unsigned int download_bytes)
@@ -330,7 +339,9 @@ void fb_mmc_flash_write(const char *cmd, void *download_buffer,
 	if (is_sparse_image(download_buffer)) {
 		struct fb_mmc_sparse sparse_priv;
 		struct sparse_storage sparse;
+		struct mmc *mmc;
 
+		mmc = find_mmc_device(CONFIG_FASTBOOT_FLASH_MMC_DEV);
 		sparse_priv.dev_desc = dev_desc;
 
 		sparse.blksz = info.blksz;
@@ -338,6 +349,15 @@ void fb_mmc_flash_write(const char *cmd, void *download_buffer,
 		sparse.size = info.size;
 		sparse.write = fb_mmc_sparse_write;
 		sparse.reserve = fb_mmc_sparse_reserve;
+		sparse.erase = NULL;
+		sparse.erase_blks = 0;
+
+		/* zero FILL chunks can be erased if erased sectors read 0 */
+		if (mmc && !mmc->erased_byte) {
+			sparse.erase = fb_mmc_sparse_erase;
+			sparse.erase_blks = mmc->erase_grp_size *
+					    MMC_MAX_BLOCK_LEN / info.blksz;
+		}
 
 		printf("Flashing sparse image at offset " LBAFU "\n",
 		       sparse.start);
@@ -175,6 +175,8 @@ void fb_nand_flash_write(const char *cmd, void *download_buffer,
 		sparse.size = part->size / sparse.blksz;
 		sparse.write = fb_nand_sparse_write;
 		sparse.reserve = fb_nand_sparse_reserve;
+		sparse.erase = NULL;
+		sparse.erase_blks = 0;
 
 		printf("Flashing sparse image at offset " LBAFU "\n",
 		       sparse.start);
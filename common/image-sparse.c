@@ -49,6 +49,74 @@
 #define CONFIG_FASTBOOT_FLASH_FILLBUF_SIZE (1024 * 512)
 #endif
 
+static lbaint_t write_sparse_fill(struct sparse_storage *info, lbaint_t blk,
+				  lbaint_t blkcnt, uint32_t *fill_buf,
+				  int fill_buf_num_blks)
+{
+	lbaint_t blks;
+	lbaint_t i;
+	lbaint_t j;
+
+	for (i = 0; i < blkcnt;) {
+		j = blkcnt - i;
+		if (j > fill_buf_num_blks)
+			j = fill_buf_num_blks;
+		blks = info->write(info, blk, j, fill_buf);
+		/* blks might be > j (eg. NAND bad-blocks) */
+		if (blks < j) {
+			printf("%s: %s " LBAFU " [" LBAFU "]\n", __func__,
+			       "Write failed, block #", blk, j);
+			return 0;
+		}
+		blk += blks;
+		i += j;
+	}
+
+	return blkcnt;
+}
+
+/*
+ * Zero-fill a range by erasing the erase-group aligned middle part and
+ * only writing the unaligned head and tail from the fill buffer.
+ */
+static lbaint_t write_sparse_zero(struct sparse_storage *info, lbaint_t blk,
+				  lbaint_t blkcnt, uint32_t *fill_buf,
+				  int fill_buf_num_blks)
+{
+	lbaint_t head, mid, tail;
+	u32 rem;
+
+	div_u64_rem(blk, info->erase_blks, &rem);
+	head = rem ? info->erase_blks - rem : 0;
+	if (head > blkcnt)
+		head = blkcnt;
+	div_u64_rem(blkcnt - head, info->erase_blks, &rem);
+	mid = blkcnt - head - rem;
+	tail = rem;
+
+	if (head && write_sparse_fill(info, blk, head, fill_buf,
+				      fill_buf_num_blks) < head)
+		return 0;
+	blk += head;
+
+	if (mid) {
+		debug("%s: erasing " LBAFU " blocks at " LBAFU "\n",
+		      __func__, mid, blk);
+		if (info->erase(info, blk, mid) < mid) {
+			printf("%s: %s " LBAFU " [" LBAFU "]\n", __func__,
+			       "Erase failed, block #", blk, mid);
+			return 0;
+		}
+		blk += mid;
+	}
+
+	if (tail && write_sparse_fill(info, blk, tail, fill_buf,
+				      fill_buf_num_blks) < tail)
+		return 0;
+
+	return blkcnt;
+}
+
 void write_sparse_image(
 		struct sparse_storage *info, const char *part_name,
 		void *data, unsigned sz)
@@ -62,12 +130,14 @@ void write_sparse_image(
 	unsigned int chunk_data_sz;
 	uint32_t *fill_buf = NULL;
 	uint32_t fill_val;
+	uint32_t fill_buf_val = 0;
+	void *raw_buf = NULL;
+	lbaint_t raw_blkcnt = 0;
 	sparse_header_t *sparse_header;
 	chunk_header_t *chunk_header;
 	uint32_t total_blocks = 0;
 	int fill_buf_num_blks;
 	int i;
-	int j;
 
 	fill_buf_num_blks = CONFIG_FASTBOOT_FLASH_FILLBUF_SIZE / info->blksz;
 
@@ -130,6 +200,26 @@ void write_sparse_image(
 				 sizeof(chunk_header_t));
 		}
 
+		/*
+		 * Flush the pending RAW run before anything that moves the
+		 * write position (CRC32 chunks do not).
+		 */
+		if (raw_blkcnt &&
+		    chunk_header->chunk_type != CHUNK_TYPE_RAW &&
+		    chunk_header->chunk_type != CHUNK_TYPE_CRC32) {
+			blks = info->write(info, blk, raw_blkcnt, raw_buf);
+			/* blks might be > raw_blkcnt (eg. NAND bad-blocks) */
+			if (blks < raw_blkcnt) {
+				printf("%s: %s" LBAFU " [" LBAFU "]\n",
+				       __func__, "Write failed, block #",
+				       blk, blks);
+				fastboot_fail("flash write failure");
+				goto out;
+			}
+			blk += blks;
+			raw_blkcnt = 0;
+		}
+
 		chunk_data_sz = sparse_header->blk_sz * chunk_header->chunk_sz;
 		blkcnt = chunk_data_sz / info->blksz;
 		switch (chunk_header->chunk_type) {
@@ -138,29 +228,30 @@ void write_sparse_image(
 			    (sparse_header->chunk_hdr_sz + chunk_data_sz)) {
 				fastboot_fail(
 					"Bogus chunk size for chunk type Raw");
-				return;
+				goto out;
 			}
 
-			if (blk + blkcnt > info->start + info->size) {
+			if (blk + raw_blkcnt + blkcnt >
+			    info->start + info->size) {
 				printf(
 				    "%s: Request would exceed partition size!\n",
 				    __func__);
 				fastboot_fail(
 				    "Request would exceed partition size!");
-				return;
+				goto out;
 			}
 
-			blks = info->write(info, blk, blkcnt, data);
-			/* blks might be > blkcnt (eg. NAND bad-blocks) */
-			if (blks < blkcnt) {
-				printf("%s: %s" LBAFU " [" LBAFU "]\n",
-				       __func__, "Write failed, block #",
-				       blk, blks);
-				fastboot_fail(
-					      "flash write failure");
-				return;
-			}
-			blk += blks;
+			/*
+			 * Coalesce adjacent RAW chunks into a single write by
+			 * moving this chunk's data down over the chunk
+			 * header(s) separating it from the pending run.
+			 */
+			if (!raw_blkcnt)
+				raw_buf = data;
+			else if (raw_buf + raw_blkcnt * info->blksz != data)
+				memmove(raw_buf + raw_blkcnt * info->blksz,
+					data, chunk_data_sz);
+			raw_blkcnt += blkcnt;
 			bytes_written += blkcnt * info->blksz;
 			total_blocks += chunk_header->chunk_sz;
 			data += chunk_data_sz;
@@ -171,28 +262,34 @@ void write_sparse_image(
 			    (sparse_header->chunk_hdr_sz + sizeof(uint32_t))) {
 				fastboot_fail(
 					"Bogus chunk size for chunk type FILL");
-				return;
+				goto out;
 			}
 
-			fill_buf = (uint32_t *)
-				   memalign(ARCH_DMA_MINALIGN,
-					    ROUNDUP(
+			if (!fill_buf) {
+				fill_buf = (uint32_t *)
+					   memalign(ARCH_DMA_MINALIGN,
+						    ROUNDUP(
 						info->blksz * fill_buf_num_blks,
 						ARCH_DMA_MINALIGN));
-			if (!fill_buf) {
-				fastboot_fail(
+				if (!fill_buf) {
+					fastboot_fail(
 					"Malloc failed for: CHUNK_TYPE_FILL");
-				return;
+					goto out;
+				}
+				fill_buf_val = ~*(uint32_t *)data;
 			}
 
 			fill_val = *(uint32_t *)data;
 			data = (char *)data + sizeof(uint32_t);
 
-			for (i = 0;
-			     i < (info->blksz * fill_buf_num_blks /
-				  sizeof(fill_val));
-			     i++)
-				fill_buf[i] = fill_val;
+			if (fill_val != fill_buf_val) {
+				for (i = 0;
+				     i < (info->blksz * fill_buf_num_blks /
+					  sizeof(fill_val));
+				     i++)
+					fill_buf[i] = fill_val;
+				fill_buf_val = fill_val;
+			}
 
 			if (blk + blkcnt > info->start + info->size) {
 				printf(
@@ -200,31 +297,24 @@ void write_sparse_image(
 				    __func__);
 				fastboot_fail(
 				    "Request would exceed partition size!");
-				return;
+				goto out;
 			}
 
-			for (i = 0; i < blkcnt;) {
-				j = blkcnt - i;
-				if (j > fill_buf_num_blks)
-					j = fill_buf_num_blks;
-				blks = info->write(info, blk, j, fill_buf);
-				/* blks might be > j (eg. NAND bad-blocks) */
-				if (blks < j) {
-					printf("%s: %s " LBAFU " [%d]\n",
-					       __func__,
-					       "Write failed, block #",
-					       blk, j);
-					fastboot_fail(
-						      "flash write failure");
-					free(fill_buf);
-					return;
-				}
-				blk += blks;
-				i += j;
+			if (!fill_val && info->erase && info->erase_blks)
+				blks = write_sparse_zero(info, blk, blkcnt,
+							 fill_buf,
+							 fill_buf_num_blks);
+			else
+				blks = write_sparse_fill(info, blk, blkcnt,
+							 fill_buf,
+							 fill_buf_num_blks);
+			if (blks < blkcnt) {
+				fastboot_fail("flash write failure");
+				goto out;
 			}
+			blk += blks;
 			bytes_written += blkcnt * info->blksz;
 			total_blocks += chunk_data_sz / sparse_header->blk_sz;
-			free(fill_buf);
 			break;
 
 		case CHUNK_TYPE_DONT_CARE:
@@ -237,7 +327,7 @@ void write_sparse_image(
 			    sparse_header->chunk_hdr_sz) {
 				fastboot_fail(
 					"Bogus chunk size for chunk type Dont Care");
-				return;
+				goto out;
 			}
 			total_blocks += chunk_header->chunk_sz;
 			data += chunk_data_sz;
@@ -247,7 +337,17 @@ void write_sparse_image(
 			printf("%s: Unknown chunk type: %x\n", __func__,
 			       chunk_header->chunk_type);
 			fastboot_fail("Unknown chunk type");
-			return;
+			goto out;
+		}
+	}
+
+	if (raw_blkcnt) {
+		blks = info->write(info, blk, raw_blkcnt, raw_buf);
+		if (blks < raw_blkcnt) {
+			printf("%s: %s" LBAFU " [" LBAFU "]\n",
+			       __func__, "Write failed, block #", blk, blks);
+			fastboot_fail("flash write failure");
+			goto out;
 		}
 	}
 
@@ -260,5 +360,6 @@ void write_sparse_image(
 	else
 		fastboot_okay("");
 
-	return;
+out:
+	free(fill_buf);
 }
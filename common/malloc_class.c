@@ -0,0 +1,204 @@
+/*
+ * Size-class allocator for small, frequent allocations
+ *
+ * Driver model makes a lot of small allocations of a handful of sizes
+ * while binding and probing devices. Serving them from slabs of equal
+ * sized objects saves dlmalloc's chunk overhead and bin search for each
+ * one. Slabs come from malloc() and go back to it as soon as they are empty.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <malloc_class.h>
+#include <linux/list.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define SLAB_SIZE	4096
+
+struct mc_slab {
+	struct list_head link;	/* in the class's list of slabs */
+	void *free;		/* first free object, each links to the next */
+	uint used;		/* number of allocated objects */
+	char obj[] __aligned(16);
+};
+
+/*
+ * Slabs with free objects are kept at the head of the list and full ones
+ * at the tail, so allocation only looks at the first slab.
+ */
+struct mc_class {
+	struct list_head slabs;
+	uint per_slab;
+	struct malloc_class_stats stats;
+};
+
+static const uint mc_sizes[MALLOC_CLASS_COUNT] = MALLOC_CLASS_SIZES;
+static struct mc_class mc_classes[MALLOC_CLASS_COUNT];
+static bool mc_inited;
+static bool mc_disabled;
+static ulong mc_malloc_calls;
+
+static struct mc_class *mc_get_class(size_t size)
+{
+	int i;
+
+	if (!mc_inited) {
+		for (i = 0; i < MALLOC_CLASS_COUNT; i++) {
+			INIT_LIST_HEAD(&mc_classes[i].slabs);
+			mc_classes[i].stats.size = mc_sizes[i];
+			mc_classes[i].per_slab = (SLAB_SIZE -
+				sizeof(struct mc_slab)) / mc_sizes[i];
+		}
+		mc_inited = true;
+	}
+
+	for (i = 0; i < MALLOC_CLASS_COUNT; i++) {
+		if (size <= mc_sizes[i])
+			return &mc_classes[i];
+	}
+
+	return NULL;
+}
+
+static struct mc_slab *mc_new_slab(struct mc_class *cls)
+{
+	struct mc_slab *slab;
+	char *obj;
+	uint i;
+
+	slab = malloc(SLAB_SIZE);
+	mc_malloc_calls++;
+	if (!slab)
+		return NULL;
+
+	slab->used = 0;
+	slab->free = NULL;
+	for (i = cls->per_slab, obj = slab->obj + i * cls->stats.size; i--; ) {
+		obj -= cls->stats.size;
+		*(void **)obj = slab->free;
+		slab->free = obj;
+	}
+	list_add(&slab->link, &cls->slabs);
+	cls->stats.slabs++;
+
+	return slab;
+}
+
+void *malloc_class_zalloc(size_t size)
+{
+	struct mc_class *cls;
+	struct mc_slab *slab;
+	void *ptr;
+
+	/* Before relocation there is nowhere to keep our state */
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		return calloc(1, size);
+
+	cls = mc_disabled ? NULL : mc_get_class(size);
+	if (!cls) {
+		mc_malloc_calls++;
+		return calloc(1, size);
+	}
+
+	slab = list_empty(&cls->slabs) ? NULL :
+		list_first_entry(&cls->slabs, struct mc_slab, link);
+	if (!slab || !slab->free) {
+		slab = mc_new_slab(cls);
+		if (!slab)
+			return NULL;
+	}
+
+	ptr = slab->free;
+	slab->free = *(void **)ptr;
+	slab->used++;
+	cls->stats.allocs++;
+	if (!slab->free)
+		list_move_tail(&slab->link, &cls->slabs);
+	memset(ptr, '\0', size);
+
+	return ptr;
+}
+
+void malloc_class_free(void *ptr, size_t size)
+{
+	struct mc_class *cls;
+	struct mc_slab *slab;
+
+	if (!ptr)
+		return;
+	cls = (gd->flags & GD_FLG_FULL_MALLOC_INIT) && mc_inited ?
+		mc_get_class(size) : NULL;
+	if (!cls) {
+		free(ptr);
+		return;
+	}
+
+	list_for_each_entry(slab, &cls->slabs, link) {
+		if ((char *)ptr >= slab->obj &&
+		    (char *)ptr < (char *)slab + SLAB_SIZE)
+			break;
+	}
+	/* Allocated before relocation or while disabled */
+	if (&slab->link == &cls->slabs) {
+		free(ptr);
+		return;
+	}
+
+	*(void **)ptr = slab->free;
+	slab->free = ptr;
+	slab->used--;
+	cls->stats.frees++;
+
+	if (!slab->used) {
+		/* Return it now, so that the dm leak checks still work */
+		list_del(&slab->link);
+		free(slab);
+		cls->stats.slabs--;
+	} else {
+		list_move(&slab->link, &cls->slabs);
+	}
+}
+
+void malloc_class_set_enabled(bool enabled)
+{
+	mc_disabled = !enabled;
+}
+
+bool malloc_class_enabled(void)
+{
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		return true;
+
+	return !mc_disabled;
+}
+
+ulong malloc_class_get_stats(struct malloc_class_stats *stats)
+{
+	int i;
+
+	mc_get_class(0);
+	for (i = 0; i < MALLOC_CLASS_COUNT; i++)
+		stats[i] = mc_classes[i].stats;
+
+	return mc_malloc_calls;
+}
+
+void malloc_class_report(void)
+{
+	struct malloc_class_stats stats[MALLOC_CLASS_COUNT];
+	ulong calls;
+	int i;
+
+	calls = malloc_class_get_stats(stats);
+	printf("%6s %10s %10s %10s %6s\n", "Size", "Allocs", "Frees", "Live",
+	       "Slabs");
+	for (i = 0; i < MALLOC_CLASS_COUNT; i++) {
+		printf("%6u %10lu %10lu %10lu %6u\n", stats[i].size,
+		       stats[i].allocs, stats[i].frees,
+		       stats[i].allocs - stats[i].frees, stats[i].slabs);
+	}
+	printf("%lu calls to malloc()%s\n", calls,
+	       mc_disabled ? ", size classes disabled" : "");
+}
@@ -0,0 +1,473 @@
+/*
+ * Recording of malloc() use by each caller
+ *
+ * This wraps malloc() and friends, recording the caller, size and lifetime
+ * of each allocation. Before relocation only the number and size of the
+ * allocations of each caller are kept, in a small table taken from the
+ * pre-relocation pool. After relocation each allocation is recorded in a
+ * table from the full pool until it is freed.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <malloc.h>
+#include <malloc_track.h>
+#include <mapmem.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#ifndef CONFIG_MALLOC_TRACK_F_SITES
+#define CONFIG_MALLOC_TRACK_F_SITES	0
+#endif
+
+/* Number of hash chains used to find the record of an allocation */
+#define MT_BUCKETS	1024
+
+/* A caller of malloc() before relocation */
+struct mt_early_site {
+	ulong caller;
+	uint allocs;
+	uint bytes;
+};
+
+/* Callers of malloc() before relocation, pointed to by gd->malloc_track */
+struct mt_early {
+	uint count;			/* number of sites in use */
+	uint lost_allocs;		/* allocations by callers not in site[] */
+	uint lost_bytes;
+	struct mt_early_site site[CONFIG_MALLOC_TRACK_F_SITES];
+};
+
+/* An allocation which has not been freed */
+struct mt_rec {
+	struct mt_rec *next;		/* in hash chain or free list */
+	const void *ptr;
+	struct malloc_track_site *site;
+	ulong size;
+	ulong start_ms;			/* get_timer() when allocated */
+	enum malloc_track_phase phase;
+};
+
+struct mt_state {
+	enum malloc_track_phase phase;
+	bool in_timer;			/* reading the timer, which may allocate */
+	ulong live;			/* bytes in recorded allocations */
+	ulong untracked;		/* allocations made with no record free */
+	struct malloc_track_usage usage[MALLOC_PHASE_COUNT];
+	struct mt_rec *free_recs;
+	struct mt_rec *bucket[MT_BUCKETS];
+	/* The last site collects callers which do not fit in the table */
+	struct malloc_track_site site[CONFIG_MALLOC_TRACK_SITES + 1];
+	struct mt_rec rec[CONFIG_MALLOC_TRACK_COUNT];
+	struct mt_early early;
+};
+
+static struct mt_state *mt;
+
+static const char *const mt_phase_name[MALLOC_PHASE_COUNT] = {
+	"pre-reloc",
+	"init",
+	"command",
+	"handoff",
+};
+
+static uint mt_hash(ulong val, uint size)
+{
+	return (val >> 3) * 2654435761U % size;
+}
+
+#if CONFIG_VAL(SYS_MALLOC_F_LEN)
+static void mt_early_alloc(size_t size, ulong caller)
+{
+	struct mt_early *early = gd->malloc_track;
+	uint i;
+
+	if (!early) {
+		early = malloc_simple(sizeof(*early));
+		if (!early)
+			return;
+		memset(early, '\0', sizeof(*early));
+		gd->malloc_track = early;
+	}
+
+	for (i = 0; i < early->count; i++) {
+		if (early->site[i].caller == caller)
+			break;
+	}
+	if (i == early->count) {
+		if (i == CONFIG_MALLOC_TRACK_F_SITES) {
+			early->lost_allocs++;
+			early->lost_bytes += size;
+			return;
+		}
+		early->site[early->count++].caller = caller;
+	}
+	early->site[i].allocs++;
+	early->site[i].bytes += size;
+}
+#endif
+
+/*
+ * Reading the timer may probe it on first use, which allocates memory.
+ * Allocations made while doing so get a start time of 0.
+ */
+static ulong mt_get_time(void)
+{
+	ulong now;
+
+	if (mt->in_timer)
+		return 0;
+	mt->in_timer = true;
+	now = get_timer(0);
+	mt->in_timer = false;
+
+	return now;
+}
+
+static struct malloc_track_site *mt_find_site(ulong caller)
+{
+	struct malloc_track_site *site;
+	uint i, start;
+
+	i = start = mt_hash(caller, CONFIG_MALLOC_TRACK_SITES);
+	do {
+		site = &mt->site[i];
+		if (site->caller == caller)
+			return site;
+		if (!site->caller) {
+			site->caller = caller;
+			return site;
+		}
+		i = (i + 1) % CONFIG_MALLOC_TRACK_SITES;
+	} while (i != start);
+
+	return &mt->site[CONFIG_MALLOC_TRACK_SITES];
+}
+
+static void mt_alloc(const void *ptr, size_t size, ulong caller)
+{
+	struct malloc_track_usage *usage;
+	struct malloc_track_site *site;
+	struct mt_rec *rec, **bucket;
+	ulong now;
+
+	if (!ptr)
+		return;
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT)) {
+#if CONFIG_VAL(SYS_MALLOC_F_LEN)
+		mt_early_alloc(size, caller);
+#endif
+		return;
+	}
+	if (!mt)
+		return;
+
+	/* This may allocate, so do it before changing anything */
+	now = mt_get_time();
+
+	site = mt_find_site(caller);
+	site->allocs++;
+	site->bytes += size;
+	usage = &mt->usage[mt->phase];
+	usage->allocs++;
+	usage->bytes += size;
+
+	rec = mt->free_recs;
+	if (!rec) {
+		mt->untracked++;
+		return;
+	}
+	mt->free_recs = rec->next;
+	rec->ptr = ptr;
+	rec->site = site;
+	rec->size = size;
+	rec->start_ms = now;
+	rec->phase = mt->phase;
+	bucket = &mt->bucket[mt_hash((ulong)ptr, MT_BUCKETS)];
+	rec->next = *bucket;
+	*bucket = rec;
+
+	site->live += size;
+	site->peak = max(site->peak, site->live);
+	mt->live += size;
+	usage->peak = max(usage->peak, mt->live);
+}
+
+static struct mt_rec **mt_find_rec(const void *ptr)
+{
+	struct mt_rec **recp;
+
+	for (recp = &mt->bucket[mt_hash((ulong)ptr, MT_BUCKETS)]; *recp;
+	     recp = &(*recp)->next) {
+		if ((*recp)->ptr == ptr)
+			return recp;
+	}
+
+	return NULL;
+}
+
+static void mt_free(const void *ptr)
+{
+	struct mt_rec **recp, *rec;
+	ulong now;
+
+	if (!ptr || !mt || !(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		return;
+
+	now = mt_get_time();
+	recp = mt_find_rec(ptr);
+	if (!recp)
+		return;
+	rec = *recp;
+	*recp = rec->next;
+
+	rec->site->frees++;
+	rec->site->live -= rec->size;
+	rec->site->lifetime_ms += now - rec->start_ms;
+	mt->live -= rec->size;
+
+	rec->next = mt->free_recs;
+	mt->free_recs = rec;
+}
+
+void *malloc(size_t bytes)
+{
+	void *ptr = dlmalloc(bytes);
+
+	mt_alloc(ptr, bytes, (ulong)__builtin_return_address(0));
+
+	return ptr;
+}
+
+void *calloc(size_t n, size_t elem_size)
+{
+	void *ptr = dlcalloc(n, elem_size);
+
+	mt_alloc(ptr, n * elem_size, (ulong)__builtin_return_address(0));
+
+	return ptr;
+}
+
+void *memalign(size_t alignment, size_t bytes)
+{
+	void *ptr = dlmemalign(alignment, bytes);
+
+	mt_alloc(ptr, bytes, (ulong)__builtin_return_address(0));
+
+	return ptr;
+}
+
+void *realloc(void *oldmem, size_t bytes)
+{
+	void *ptr = dlrealloc(oldmem, bytes);
+
+	/* If this fails the old memory is still allocated */
+	if (ptr) {
+		mt_free(oldmem);
+		mt_alloc(ptr, bytes, (ulong)__builtin_return_address(0));
+	}
+
+	return ptr;
+}
+
+void free(void *mem)
+{
+	mt_free(mem);
+	dlfree(mem);
+}
+
+int malloc_track_init(void)
+{
+	struct mt_early *early = NULL;
+	struct mt_state *state;
+	int i;
+
+	/* The tables are not tracked themselves */
+	state = dlmalloc(sizeof(*state));
+	if (!state)
+		return -ENOMEM;
+	memset(state, '\0', sizeof(*state));
+	for (i = CONFIG_MALLOC_TRACK_COUNT - 1; i >= 0; i--) {
+		state->rec[i].next = state->free_recs;
+		state->free_recs = &state->rec[i];
+	}
+
+#if CONFIG_VAL(SYS_MALLOC_F_LEN)
+	/* Keep the pre-relocation records, since that pool may go away */
+	early = gd->malloc_track;
+	gd->malloc_track = NULL;
+	state->usage[MALLOC_PHASE_F].peak = gd->malloc_ptr;
+#endif
+	if (early) {
+		state->early = *early;
+		for (i = 0; i < early->count; i++) {
+			state->usage[MALLOC_PHASE_F].allocs +=
+				early->site[i].allocs;
+			state->usage[MALLOC_PHASE_F].bytes +=
+				early->site[i].bytes;
+		}
+		state->usage[MALLOC_PHASE_F].allocs += early->lost_allocs;
+		state->usage[MALLOC_PHASE_F].bytes += early->lost_bytes;
+	}
+	state->phase = MALLOC_PHASE_INIT;
+	mt = state;
+
+	return 0;
+}
+
+void malloc_track_set_phase(enum malloc_track_phase phase)
+{
+	if (!mt || phase == mt->phase)
+		return;
+	mt->phase = phase;
+	mt->usage[phase].start = mt->live;
+	mt->usage[phase].peak = max(mt->usage[phase].peak, mt->live);
+}
+
+int malloc_track_get_site(const void *ptr, struct malloc_track_site *site)
+{
+	struct mt_rec **recp;
+
+	recp = mt ? mt_find_rec(ptr) : NULL;
+	if (!recp)
+		return -ENOENT;
+	*site = *(*recp)->site;
+
+	return 0;
+}
+
+void malloc_track_get_usage(enum malloc_track_phase phase,
+			    struct malloc_track_usage *usage)
+{
+	if (mt)
+		*usage = mt->usage[phase];
+	else
+		memset(usage, '\0', sizeof(*usage));
+}
+
+/* Print a caller's link-time address, and its function if known */
+static void mt_print_caller(ulong caller, ulong reloc_off)
+{
+	ulong addr = caller - reloc_off;
+	const char *name = NULL;
+	ulong start = addr;
+
+	if (!caller) {
+		printf("%8s  (other callers)\n", "-");
+		return;
+	}
+#ifdef CONFIG_KALLSYMS
+	name = symbol_lookup(addr, &start);
+#endif
+	if (name)
+		printf("%08lx  %s+%#lx\n", addr, name, addr - start);
+	else
+		printf("%08lx  ?\n", addr);
+}
+
+static int mt_site_cmp(const void *a, const void *b)
+{
+	const struct malloc_track_site *sa = *(const void **)a;
+	const struct malloc_track_site *sb = *(const void **)b;
+
+	return sa->bytes > sb->bytes ? -1 : sa->bytes < sb->bytes;
+}
+
+void malloc_track_print_top(uint count)
+{
+	struct malloc_track_site **order, *site;
+	uint nsites, i;
+
+	if (!mt) {
+		printf("Not tracking\n");
+		return;
+	}
+	order = dlmalloc(sizeof(*order) * (CONFIG_MALLOC_TRACK_SITES + 1));
+	if (!order) {
+		printf("Out of memory\n");
+		return;
+	}
+	for (i = nsites = 0; i <= CONFIG_MALLOC_TRACK_SITES; i++) {
+		if (mt->site[i].allocs)
+			order[nsites++] = &mt->site[i];
+	}
+	qsort(order, nsites, sizeof(*order), mt_site_cmp);
+
+	printf("%u callers", nsites);
+	if (mt->untracked)
+		printf(", %lu allocations not tracked (table full)",
+		       mt->untracked);
+	printf("\n    Allocs     Frees      Bytes       Live       Peak");
+	printf("  Life ms  Caller\n");
+	for (i = 0; i < nsites && i < count; i++) {
+		site = order[i];
+		printf("%10lu%10lu %10lu %10lu %10lu %8lu  ", site->allocs,
+		       site->frees, site->bytes, site->live, site->peak,
+		       site->frees ? site->lifetime_ms / site->frees : 0);
+		mt_print_caller(site->caller, gd->reloc_off);
+	}
+	dlfree(order);
+}
+
+void malloc_track_print_live(void)
+{
+	struct malloc_track_usage *handoff;
+	struct mt_rec *rec;
+	ulong now, count = 0;
+	int i;
+
+	if (!mt) {
+		printf("Not tracking\n");
+		return;
+	}
+	now = get_timer(0);
+	printf("Address        Size   Age ms  Phase     Caller\n");
+	for (i = 0; i < MT_BUCKETS; i++) {
+		for (rec = mt->bucket[i]; rec; rec = rec->next) {
+			printf("%08lx %10lu %8lu  %-8s  ",
+			       (ulong)map_to_sysmem(rec->ptr), rec->size,
+			       now - rec->start_ms, mt_phase_name[rec->phase]);
+			mt_print_caller(rec->site->caller, gd->reloc_off);
+			count++;
+		}
+	}
+	printf("%lu allocations live, %lu bytes\n", count, mt->live);
+	handoff = &mt->usage[MALLOC_PHASE_HANDOFF];
+	if (mt->phase == MALLOC_PHASE_HANDOFF)
+		printf("%lu bytes were live at boot handoff\n", handoff->start);
+}
+
+void malloc_track_print_phases(void)
+{
+	struct malloc_track_usage *usage;
+	struct mt_early *early;
+	int i;
+
+	if (!mt) {
+		printf("Not tracking\n");
+		return;
+	}
+	printf("Phase         Allocs      Bytes      Start       Peak\n");
+	for (i = 0; i < MALLOC_PHASE_COUNT; i++) {
+		usage = &mt->usage[i];
+		printf("%-9s %10lu %10lu %10lu %10lu%s\n", mt_phase_name[i],
+		       usage->allocs, usage->bytes, usage->start, usage->peak,
+		       i == mt->phase ? "  <" : "");
+	}
+
+	early = &mt->early;
+	if (!early->count)
+		return;
+	printf("\nBefore relocation:\n    Allocs      Bytes  Caller\n");
+	for (i = 0; i < early->count; i++) {
+		printf("%10u %10u  ", early->site[i].allocs,
+		       early->site[i].bytes);
+		mt_print_caller(early->site[i].caller, 0);
+	}
+	if (early->lost_allocs) {
+		printf("%10u %10u  ", early->lost_allocs, early->lost_bytes);
+		mt_print_caller(0, 0);
+	}
+}
@@ -12,6 +12,7 @@
 #include <common.h>
 #include <errno.h>
 #include <malloc.h>
+#include <malloc_class.h>
 #include <dm/device.h>
 #include <dm/device-internal.h>
 #include <dm/uclass.h>
@@ -68,6 +69,7 @@ static int device_chld_remove(struct udevice *dev, uint flags)
 int device_unbind(struct udevice *dev)
 {
 	const struct driver *drv;
+	int sizes[3], size;
 	int ret;
 
 	if (!dev)
@@ -92,17 +94,22 @@ int device_unbind(struct udevice *dev)
 	if (ret)
 		return ret;
 
-	if (dev->flags & DM_FLAG_ALLOC_PDATA) {
-		free(dev->platdata);
-		dev->platdata = NULL;
-	}
-	if (dev->flags & DM_FLAG_ALLOC_UCLASS_PDATA) {
-		free(dev->uclass_platdata);
-		dev->uclass_platdata = NULL;
-	}
-	if (dev->flags & DM_FLAG_ALLOC_PARENT_PDATA) {
-		free(dev->parent_platdata);
-		dev->parent_platdata = NULL;
+	size = device_pdata_size(drv, dev->uclass, dev->parent, dev->flags,
+				 sizes);
+	if (!(dev->flags & DM_FLAG_BATCH_PDATA)) {
+		if (dev->flags & DM_FLAG_ALLOC_PDATA) {
+			malloc_class_free(dev->platdata, sizes[0]);
+			dev->platdata = NULL;
+		}
+		if (dev->flags & DM_FLAG_ALLOC_UCLASS_PDATA) {
+			malloc_class_free(dev->uclass_platdata, sizes[1]);
+			dev->uclass_platdata = NULL;
+		}
+		if (dev->flags & DM_FLAG_ALLOC_PARENT_PDATA) {
+			malloc_class_free(dev->parent_platdata, sizes[2]);
+			dev->parent_platdata = NULL;
+		}
+		size = sizeof(struct udevice);
 	}
 	ret = uclass_unbind_device(dev);
 	if (ret)
@@ -115,7 +122,7 @@ int device_unbind(struct udevice *dev)
 
 	if (dev->flags & DM_FLAG_NAME_ALLOCED)
 		free((char *)dev->name);
-	free(dev);
+	malloc_class_free(dev, size);
 
 	return 0;
 }
@@ -126,25 +133,38 @@ int device_unbind(struct udevice *dev)
  */
 void device_free(struct udevice *dev)
 {
-	int size;
-
-	if (dev->driver->priv_auto_alloc_size) {
-		free(dev->priv);
-		dev->priv = NULL;
-	}
-	size = dev->uclass->uc_drv->per_device_auto_alloc_size;
-	if (size) {
-		free(dev->uclass_priv);
-		dev->uclass_priv = NULL;
-	}
-	if (dev->parent) {
-		size = dev->parent->driver->per_child_auto_alloc_size;
-		if (!size) {
-			size = dev->parent->uclass->uc_drv->
-					per_child_auto_alloc_size;
+	bool dma = dev->driver->flags & DM_FLAG_ALLOC_PRIV_DMA;
+	int sizes[3], size;
+
+	size = device_priv_size(dev, sizes);
+	if (dev->flags & DM_FLAG_BATCH_PRIV) {
+		/* The block starts with the first structure that is needed */
+		malloc_class_free(sizes[0] ? dev->priv : sizes[1] ?
+				  dev->uclass_priv : dev->parent_priv, size);
+		dev->flags &= ~DM_FLAG_BATCH_PRIV;
+		if (sizes[0])
+			dev->priv = NULL;
+		if (sizes[1])
+			dev->uclass_priv = NULL;
+		if (sizes[2])
+			dev->parent_priv = NULL;
+	} else {
+		if (sizes[0]) {
+			if (dma)
+				free(dev->priv);
+			else
+				malloc_class_free(dev->priv, sizes[0]);
+			dev->priv = NULL;
+		}
+		if (sizes[1]) {
+			malloc_class_free(dev->uclass_priv, sizes[1]);
+			dev->uclass_priv = NULL;
 		}
-		if (size) {
-			free(dev->parent_priv);
+		if (sizes[2]) {
+			if (dma)
+				free(dev->parent_priv);
+			else
+				malloc_class_free(dev->parent_priv, sizes[2]);
 			dev->parent_priv = NULL;
 		}
 	}
@@ -14,6 +14,7 @@
 #include <fdtdec.h>
 #include <fdt_support.h>
 #include <malloc.h>
+#include <malloc_class.h>
 #include <dm/device.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
@@ -28,6 +29,19 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+static int device_parent_pdata_size(struct udevice *parent)
+{
+	int size;
+
+	size = parent->driver->per_child_platdata_auto_alloc_size;
+	if (!size) {
+		size = parent->uclass->uc_drv->
+				per_child_platdata_auto_alloc_size;
+	}
+
+	return size;
+}
+
 static int device_bind_common(struct udevice *parent, const struct driver *drv,
 			      const char *name, void *platdata,
 			      ulong driver_data, ofnode node,
@@ -35,7 +49,9 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 {
 	struct udevice *dev;
 	struct uclass *uc;
-	int size, ret = 0;
+	int sizes[3], size;
+	uint flags = 0;
+	int ret = 0;
 
 	if (devp)
 		*devp = NULL;
@@ -48,9 +64,36 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 		return ret;
 	}
 
-	dev = calloc(1, sizeof(struct udevice));
+	if (drv->platdata_auto_alloc_size) {
+		bool alloc = !platdata;
+
+		if (CONFIG_IS_ENABLED(OF_PLATDATA)) {
+			if (of_platdata_size) {
+				flags |= DM_FLAG_OF_PLATDATA;
+				if (of_platdata_size <
+						drv->platdata_auto_alloc_size)
+					alloc = true;
+			}
+		}
+		if (alloc)
+			flags |= DM_FLAG_ALLOC_PDATA;
+	}
+	if (uc->uc_drv->per_device_platdata_auto_alloc_size)
+		flags |= DM_FLAG_ALLOC_UCLASS_PDATA;
+	if (parent && device_parent_pdata_size(parent))
+		flags |= DM_FLAG_ALLOC_PARENT_PDATA;
+
+	/* Allocate the device and its platdata together if we can */
+	if (malloc_class_enabled() &&
+	    (flags & (DM_FLAG_ALLOC_PDATA | DM_FLAG_ALLOC_UCLASS_PDATA |
+		      DM_FLAG_ALLOC_PARENT_PDATA)))
+		flags |= DM_FLAG_BATCH_PDATA;
+	size = device_pdata_size(drv, uc, parent, flags, sizes);
+	dev = malloc_class_zalloc(flags & DM_FLAG_BATCH_PDATA ? size :
+				  sizeof(struct udevice));
 	if (!dev)
 		return -ENOMEM;
+	dev->flags = flags;
 
 	INIT_LIST_HEAD(&dev->sibling_node);
 	INIT_LIST_HEAD(&dev->child_head);
@@ -83,57 +126,45 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 		}
 	}
 
-	if (drv->platdata_auto_alloc_size) {
-		bool alloc = !platdata;
+	if (flags & DM_FLAG_BATCH_PDATA) {
+		char *ptr = (char *)dev + ALIGN(sizeof(*dev), DM_BATCH_ALIGN);
 
-		if (CONFIG_IS_ENABLED(OF_PLATDATA)) {
-			if (of_platdata_size) {
-				dev->flags |= DM_FLAG_OF_PLATDATA;
-				if (of_platdata_size <
-						drv->platdata_auto_alloc_size)
-					alloc = true;
-			}
+		if (sizes[0]) {
+			dev->platdata = ptr;
+			ptr += ALIGN(sizes[0], DM_BATCH_ALIGN);
+		}
+		if (sizes[1]) {
+			dev->uclass_platdata = ptr;
+			ptr += ALIGN(sizes[1], DM_BATCH_ALIGN);
 		}
-		if (alloc) {
-			dev->flags |= DM_FLAG_ALLOC_PDATA;
-			dev->platdata = calloc(1,
-					       drv->platdata_auto_alloc_size);
+		if (sizes[2])
+			dev->parent_platdata = ptr;
+	} else {
+		if (sizes[0]) {
+			dev->platdata = malloc_class_zalloc(sizes[0]);
 			if (!dev->platdata) {
 				ret = -ENOMEM;
 				goto fail_alloc1;
 			}
-			if (CONFIG_IS_ENABLED(OF_PLATDATA) && platdata) {
-				memcpy(dev->platdata, platdata,
-				       of_platdata_size);
-			}
-		}
-	}
-
-	size = uc->uc_drv->per_device_platdata_auto_alloc_size;
-	if (size) {
-		dev->flags |= DM_FLAG_ALLOC_UCLASS_PDATA;
-		dev->uclass_platdata = calloc(1, size);
-		if (!dev->uclass_platdata) {
-			ret = -ENOMEM;
-			goto fail_alloc2;
 		}
-	}
-
-	if (parent) {
-		size = parent->driver->per_child_platdata_auto_alloc_size;
-		if (!size) {
-			size = parent->uclass->uc_drv->
-					per_child_platdata_auto_alloc_size;
+		if (sizes[1]) {
+			dev->uclass_platdata = malloc_class_zalloc(sizes[1]);
+			if (!dev->uclass_platdata) {
+				ret = -ENOMEM;
+				goto fail_alloc2;
+			}
 		}
-		if (size) {
-			dev->flags |= DM_FLAG_ALLOC_PARENT_PDATA;
-			dev->parent_platdata = calloc(1, size);
+		if (sizes[2]) {
+			dev->parent_platdata = malloc_class_zalloc(sizes[2]);
 			if (!dev->parent_platdata) {
 				ret = -ENOMEM;
 				goto fail_alloc3;
 			}
 		}
 	}
+	if (CONFIG_IS_ENABLED(OF_PLATDATA) && platdata &&
+	    (flags & DM_FLAG_ALLOC_PDATA))
+		memcpy(dev->platdata, platdata, of_platdata_size);
 
 	/* put dev into parent's successor list */
 	if (parent)
@@ -189,25 +220,26 @@ fail_bind:
 fail_uclass_bind:
 	if (CONFIG_IS_ENABLED(DM_DEVICE_REMOVE)) {
 		list_del(&dev->sibling_node);
-		if (dev->flags & DM_FLAG_ALLOC_PARENT_PDATA) {
-			free(dev->parent_platdata);
+		if (!(flags & DM_FLAG_BATCH_PDATA)) {
+			malloc_class_free(dev->parent_platdata, sizes[2]);
 			dev->parent_platdata = NULL;
 		}
 	}
 fail_alloc3:
-	if (dev->flags & DM_FLAG_ALLOC_UCLASS_PDATA) {
-		free(dev->uclass_platdata);
+	if (!(flags & DM_FLAG_BATCH_PDATA)) {
+		malloc_class_free(dev->uclass_platdata, sizes[1]);
 		dev->uclass_platdata = NULL;
 	}
 fail_alloc2:
-	if (dev->flags & DM_FLAG_ALLOC_PDATA) {
-		free(dev->platdata);
+	if (!(flags & DM_FLAG_BATCH_PDATA) && sizes[0]) {
+		malloc_class_free(dev->platdata, sizes[0]);
 		dev->platdata = NULL;
 	}
 fail_alloc1:
 	devres_release_all(dev);
 
-	free(dev);
+	malloc_class_free(dev, flags & DM_FLAG_BATCH_PDATA ? size :
+			  sizeof(struct udevice));
 
 	return ret;
 }
@@ -286,28 +318,91 @@ static void *alloc_priv(int size, uint flags)
 #endif
 		}
 	} else {
-		priv = calloc(1, size);
+		priv = malloc_class_zalloc(size);
 	}
 
 	return priv;
 }
 
-int device_probe(struct udevice *dev)
+int device_pdata_size(const struct driver *drv, struct uclass *uc,
+		      struct udevice *parent, uint flags, int sizes[3])
+{
+	sizes[0] = flags & DM_FLAG_ALLOC_PDATA ?
+		drv->platdata_auto_alloc_size : 0;
+	sizes[1] = flags & DM_FLAG_ALLOC_UCLASS_PDATA ?
+		uc->uc_drv->per_device_platdata_auto_alloc_size : 0;
+	sizes[2] = parent && (flags & DM_FLAG_ALLOC_PARENT_PDATA) ?
+		device_parent_pdata_size(parent) : 0;
+
+	return ALIGN(sizeof(struct udevice), DM_BATCH_ALIGN) +
+		ALIGN(sizes[0], DM_BATCH_ALIGN) +
+		ALIGN(sizes[1], DM_BATCH_ALIGN) + sizes[2];
+}
+
+int device_priv_size(struct udevice *dev, int sizes[3])
+{
+	sizes[0] = dev->driver->priv_auto_alloc_size;
+	sizes[1] = dev->uclass->uc_drv->per_device_auto_alloc_size;
+	sizes[2] = 0;
+	if (dev->parent) {
+		sizes[2] = dev->parent->driver->per_child_auto_alloc_size;
+		if (!sizes[2]) {
+			sizes[2] = dev->parent->uclass->uc_drv->
+					per_child_auto_alloc_size;
+		}
+	}
+
+	return ALIGN(sizes[0], DM_BATCH_ALIGN) +
+		ALIGN(sizes[1], DM_BATCH_ALIGN) + sizes[2];
+}
+
+/*
+ * Allocate all the private data of a device in one block. This is only
+ * done when none of it is allocated yet and it does not need to be
+ * DMA-aligned.
+ */
+static void device_alloc_priv_batch(struct udevice *dev)
+{
+	int sizes[3], size;
+	char *ptr;
+
+	if (!malloc_class_enabled() ||
+	    (dev->driver->flags & DM_FLAG_ALLOC_PRIV_DMA) ||
+	    dev->priv || dev->uclass_priv || dev->parent_priv)
+		return;
+
+	size = device_priv_size(dev, sizes);
+	if (!size)
+		return;
+	ptr = malloc_class_zalloc(size);
+	if (!ptr)
+		return;
+
+	if (sizes[0]) {
+		dev->priv = ptr;
+		ptr += ALIGN(sizes[0], DM_BATCH_ALIGN);
+	}
+	if (sizes[1]) {
+		dev->uclass_priv = ptr;
+		ptr += ALIGN(sizes[1], DM_BATCH_ALIGN);
+	}
+	if (sizes[2])
+		dev->parent_priv = ptr;
+	dev->flags |= DM_FLAG_BATCH_PRIV;
+}
+
+static int device_do_probe(struct udevice *dev)
 {
 	const struct driver *drv;
 	int size = 0;
 	int ret;
 	int seq;
 
-	if (!dev)
-		return -EINVAL;
-
-	if (dev->flags & DM_FLAG_ACTIVATED)
-		return 0;
-
 	drv = dev->driver;
 	assert(drv);
 
+	device_alloc_priv_batch(dev);
+
 	/* Allocate private data if requested and not reentered */
 	if (drv->priv_auto_alloc_size && !dev->priv) {
 		dev->priv = alloc_priv(drv->priv_auto_alloc_size, drv->flags);
@@ -319,7 +414,7 @@ int device_probe(struct udevice *dev)
 	/* Allocate private data if requested and not reentered */
 	size = dev->uclass->uc_drv->per_device_auto_alloc_size;
 	if (size && !dev->uclass_priv) {
-		dev->uclass_priv = calloc(1, size);
+		dev->uclass_priv = malloc_class_zalloc(size);
 		if (!dev->uclass_priv) {
 			ret = -ENOMEM;
 			goto fail;
@@ -419,6 +514,24 @@ fail:
 	return ret;
 }
 
+int device_probe(struct udevice *dev)
+{
+	int ret, span;
+
+	if (!dev)
+		return -EINVAL;
+
+	if (dev->flags & DM_FLAG_ACTIVATED)
+		return 0;
+
+	/* Time each probe, nested inside the probe or command causing it */
+	span = bootstage_span_begin(dev->name);
+	ret = device_do_probe(dev);
+	bootstage_span_end(span);
+
+	return ret;
+}
+
 void *dev_get_platdata(struct udevice *dev)
 {
 	if (!dev) {
@@ -8,6 +8,7 @@
  */
 
 #include <common.h>
+#include <div64.h>
 #include <errno.h>
 #include <malloc.h>
 #include <mmc.h>
@@ -82,10 +83,30 @@ int dfu_init_env_entities(char *interface, char *devstr)
 static unsigned char *dfu_buf;
 static unsigned long dfu_buf_size;
 
+/*
+ * Write queue: with CONFIG_DFU_BUF_COUNT > 1 and the queue enabled, filled
+ * buffers are queued here (oldest first) and written to the medium from
+ * dfu_poll() in slices, so that USB reception into the next buffer
+ * interleaves with the storage writes.
+ */
+struct dfu_wq_entry {
+	u8 *buf;
+	long len;
+	long done;
+};
+
+static struct dfu_wq_entry dfu_wq[CONFIG_DFU_BUF_COUNT];
+static int dfu_wq_head;
+static int dfu_wq_cnt;
+static int dfu_wq_err;
+static bool dfu_wq_enabled;
+static struct dfu_entity *dfu_wq_dfu;
+
 unsigned char *dfu_free_buf(void)
 {
 	free(dfu_buf);
 	dfu_buf = NULL;
+	dfu_wq_cnt = 0;
 	return dfu_buf;
 }
 
@@ -111,14 +132,20 @@ unsigned char *dfu_get_buf(struct dfu_entity *dfu)
 	if (dfu->max_buf_size && dfu_buf_size > dfu->max_buf_size)
 		dfu_buf_size = dfu->max_buf_size;
 
-	dfu_buf = memalign(CONFIG_SYS_CACHELINE_SIZE, dfu_buf_size);
+	dfu_buf = memalign(CONFIG_SYS_CACHELINE_SIZE,
+			   dfu_buf_size * CONFIG_DFU_BUF_COUNT);
 	if (dfu_buf == NULL)
 		printf("%s: Could not memalign 0x%lx bytes\n",
-		       __func__, dfu_buf_size);
+		       __func__, dfu_buf_size * CONFIG_DFU_BUF_COUNT);
 
 	return dfu_buf;
 }
 
+void dfu_enable_write_queue(bool enable)
+{
+	dfu_wq_enabled = enable && CONFIG_DFU_BUF_COUNT > 1;
+}
+
 static char *dfu_get_hash_algo(void)
 {
 	char *s;
@@ -136,35 +163,162 @@ static char *dfu_get_hash_algo(void)
 	return NULL;
 }
 
+static int dfu_write_medium_chunk(struct dfu_entity *dfu, u8 *buf, long len)
+{
+	long w_size = len;
+	int ret;
+
+	if (dfu_hash_algo)
+		dfu_hash_algo->hash_update(dfu_hash_algo, &dfu->crc,
+					   buf, w_size, 0);
+
+	ret = dfu->write_medium(dfu, dfu->offset, buf, &w_size);
+	if (ret)
+		debug("%s: Write error!\n", __func__);
+
+	/* update offset */
+	dfu->offset += w_size;
+
+	return ret;
+}
+
+/* write up to @max bytes of the oldest queued buffer */
+static int dfu_wq_write(struct dfu_entity *dfu, long max)
+{
+	struct dfu_wq_entry *e = &dfu_wq[dfu_wq_head];
+	long len = e->len - e->done;
+	int ret;
+
+	/* the medium may only take whole units, e.g. NAND erase blocks */
+	if (max < len && dfu->write_unit)
+		max = roundup(max, dfu->write_unit);
+	len = min(len, max);
+
+	ret = dfu_write_medium_chunk(dfu, e->buf + e->done, len);
+	if (ret)
+		return ret;
+
+	e->done += len;
+	if (e->done == e->len) {
+		dfu_wq_head = (dfu_wq_head + 1) % CONFIG_DFU_BUF_COUNT;
+		dfu_wq_cnt--;
+		puts("#");
+	}
+
+	return 0;
+}
+
+static int dfu_wq_drain(struct dfu_entity *dfu)
+{
+	int ret;
+
+	while (dfu_wq_cnt) {
+		ret = dfu_wq_write(dfu, LONG_MAX);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
 static int dfu_write_buffer_drain(struct dfu_entity *dfu)
 {
 	long w_size;
 	int ret;
 
+	ret = dfu_wq_drain(dfu);
+	if (ret)
+		return ret;
+
 	/* flush size? */
 	w_size = dfu->i_buf - dfu->i_buf_start;
 	if (w_size == 0)
 		return 0;
 
-	if (dfu_hash_algo)
-		dfu_hash_algo->hash_update(dfu_hash_algo, &dfu->crc,
-					   dfu->i_buf_start, w_size, 0);
-
-	ret = dfu->write_medium(dfu, dfu->offset, dfu->i_buf_start, &w_size);
-	if (ret)
-		debug("%s: Write error!\n", __func__);
+	ret = dfu_write_medium_chunk(dfu, dfu->i_buf_start, w_size);
 
 	/* point back */
 	dfu->i_buf = dfu->i_buf_start;
 
-	/* update offset */
-	dfu->offset += w_size;
-
 	puts("#");
 
 	return ret;
 }
 
+/*
+ * Hand over a full buffer: queue it and continue filling the next one, or
+ * write it out right away when the write queue is not in use. When all
+ * buffers are in flight the oldest one is written synchronously, which
+ * stalls the host until a buffer becomes free.
+ */
+static int dfu_write_buffer_full(struct dfu_entity *dfu)
+{
+	u8 *next;
+	int ret;
+
+	if (!dfu_wq_enabled)
+		return dfu_write_buffer_drain(dfu);
+
+	if (dfu->i_buf == dfu->i_buf_start)
+		return 0;
+
+	if (dfu_wq_cnt == CONFIG_DFU_BUF_COUNT - 1) {
+		ret = dfu_wq_write(dfu, LONG_MAX);
+		if (ret)
+			return ret;
+	}
+
+	dfu_wq[(dfu_wq_head + dfu_wq_cnt) % CONFIG_DFU_BUF_COUNT] =
+		(struct dfu_wq_entry) {
+			.buf = dfu->i_buf_start,
+			.len = dfu->i_buf - dfu->i_buf_start,
+		};
+	dfu_wq_cnt++;
+	dfu_wq_dfu = dfu;
+
+	/* buffers are used round-robin, so the next one is free now */
+	next = dfu->i_buf_end;
+	if (next == dfu_buf + dfu_buf_size * CONFIG_DFU_BUF_COUNT)
+		next = dfu_buf;
+	dfu->i_buf_start = next;
+	dfu->i_buf_end = next + dfu_buf_size;
+	dfu->i_buf = next;
+
+	return 0;
+}
+
+int dfu_poll(void)
+{
+	int ret;
+
+	if (!dfu_wq_cnt)
+		return 0;
+
+	ret = dfu_wq_write(dfu_wq_dfu, CONFIG_DFU_WRITE_SLICE);
+	if (ret) {
+		error("DFU queued write failed!");
+		/* reported to the host on the next dfu_write() */
+		dfu_wq_err = ret;
+		dfu_wq_cnt = 0;
+	}
+
+	return ret;
+}
+
+static void dfu_report_stats(struct dfu_entity *dfu)
+{
+	ulong ms = get_timer(dfu->stat_start);
+
+	dfu->stat_bytes = dfu->offset;
+	dfu->stat_time = ms;
+
+	printf("\nDFU alt %d (%s): %llu bytes in %lu ms", dfu->alt, dfu->name,
+	       dfu->stat_bytes, ms);
+	if (ms)
+		printf(" (%llu KiB/s)", lldiv(dfu->stat_bytes * 1000, ms) >> 10);
+	putc('\n');
+}
+
 void dfu_transaction_cleanup(struct dfu_entity *dfu)
 {
 	/* clear everything */
@@ -178,6 +332,9 @@ void dfu_transaction_cleanup(struct dfu_entity *dfu)
 	dfu->b_left = 0;
 	dfu->bad_skip = 0;
 
+	dfu_wq_head = 0;
+	dfu_wq_cnt = 0;
+
 	dfu->inited = 0;
 }
 
@@ -194,6 +351,8 @@ int dfu_transaction_initiate(struct dfu_entity *dfu, bool read)
 		return -ENOMEM;
 
 	dfu->i_buf_end = dfu->i_buf_start + dfu_get_buf_size();
+	dfu->stat_start = get_timer(0);
+	dfu_wq_err = 0;
 
 	if (read) {
 		ret = dfu->get_medium_size(dfu, &dfu->r_left);
@@ -211,6 +370,12 @@ int dfu_flush(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 {
 	int ret = 0;
 
+	if (dfu_wq_err) {
+		ret = dfu_wq_err;
+		dfu_transaction_cleanup(dfu);
+		return ret;
+	}
+
 	ret = dfu_write_buffer_drain(dfu);
 	if (ret)
 		return ret;
@@ -222,6 +387,9 @@ int dfu_flush(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 		printf("\nDFU complete %s: 0x%08x\n", dfu_hash_algo->name,
 		       dfu->crc);
 
+	if (!ret)
+		dfu_report_stats(dfu);
+
 	dfu_transaction_cleanup(dfu);
 
 	return ret;
@@ -246,6 +414,12 @@ int dfu_write(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 		return -1;
 	}
 
+	if (dfu_wq_err) {
+		ret = dfu_wq_err;
+		dfu_transaction_cleanup(dfu);
+		return ret;
+	}
+
 	/* DFU 1.1 standard says:
 	 * The wBlockNum field is a block sequence number. It increments each
 	 * time a block is transferred, wrapping to zero from 65,535. It is used
@@ -264,7 +438,7 @@ int dfu_write(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 
 	/* flush buffer if overflow */
 	if ((dfu->i_buf + size) > dfu->i_buf_end) {
-		ret = dfu_write_buffer_drain(dfu);
+		ret = dfu_write_buffer_full(dfu);
 		if (ret) {
 			dfu_transaction_cleanup(dfu);
 			return ret;
@@ -284,7 +458,8 @@ int dfu_write(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 
 	/* if end or if buffer full flush */
 	if (size == 0 || (dfu->i_buf + size) > dfu->i_buf_end) {
-		ret = dfu_write_buffer_drain(dfu);
+		ret = size ? dfu_write_buffer_full(dfu) :
+			     dfu_write_buffer_drain(dfu);
 		if (ret) {
 			dfu_transaction_cleanup(dfu);
 			return ret;
@@ -375,7 +550,8 @@ int dfu_read(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 		if (dfu_hash_algo)
 			debug("%s: %s %s: 0x%x\n", __func__, dfu->name,
 			      dfu_hash_algo->name, dfu->crc);
-		puts("\nUPLOAD ... done\nCtrl+C to exit ...\n");
+		dfu_report_stats(dfu);
+		puts("UPLOAD ... done\nCtrl+C to exit ...\n");
 
 		dfu_transaction_cleanup(dfu);
 	}
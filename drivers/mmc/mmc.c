@@ -946,6 +946,8 @@ retry_scr:
 	if (mmc->scr[0] & SD_DATA_4BIT)
 		mmc->card_caps |= MMC_MODE_4BIT;
 
+	mmc->erased_byte = (mmc->scr[0] & SD_DATA_STAT_AFTER_ERASE) ? 0xff : 0;
+
 	/* Version 1.0 doesn't support switching */
 	if (mmc->version == SD_VERSION_1_0)
 		return 0;
@@ -1259,6 +1261,7 @@ static int mmc_startup(struct mmc *mmc)
 	 * For SD, its erase group is always one sector
 	 */
 	mmc->erase_grp_size = 1;
+	mmc->erased_byte = 0xff;
 	mmc->part_config = MMCPART_NOAVAILABLE;
 	if (!IS_SD(mmc) && (mmc->version >= MMC_VERSION_4)) {
 		/* check  ext_csd version and capacity */
@@ -1280,6 +1283,10 @@ static int mmc_startup(struct mmc *mmc)
 				mmc->capacity_user = capacity;
 		}
 
+		if (ext_csd[EXT_CSD_REV] >= 3)
+			mmc->erased_byte = ext_csd[EXT_CSD_ERASED_MEM_CONT] ?
+					   0xff : 0;
+
 		switch (ext_csd[EXT_CSD_REV]) {
 		case 1:
 			mmc->version = MMC_VERSION_4_1;
@@ -1097,8 +1097,8 @@ static int nand_read_page_raw_syndrome(struct mtd_info *mtd,
  * @oob_required: caller requires OOB data read to chip->oob_poi
  * @page: page number to read
  */
-static int nand_read_page_swecc(struct mtd_info *mtd, struct nand_chip *chip,
-				uint8_t *buf, int oob_required, int page)
+static int nand_correct_page_swecc(struct mtd_info *mtd,
+				   struct nand_chip *chip, uint8_t *buf)
 {
 	int i, eccsize = chip->ecc.size;
 	int eccbytes = chip->ecc.bytes;
@@ -1109,8 +1109,6 @@ static int nand_read_page_swecc(struct mtd_info *mtd, struct nand_chip *chip,
 	uint32_t *eccpos = chip->ecc.layout->eccpos;
 	unsigned int max_bitflips = 0;
 
-	chip->ecc.read_page_raw(mtd, chip, buf, 1, page);
-
 	for (i = 0; eccsteps; eccsteps--, i += eccbytes, p += eccsize)
 		chip->ecc.calculate(mtd, p, &ecc_calc[i]);
 
@@ -1134,6 +1132,83 @@ static int nand_read_page_swecc(struct mtd_info *mtd, struct nand_chip *chip,
 	return max_bitflips;
 }
 
+/**
+ * nand_read_page_swecc - [REPLACEABLE] software ECC based page read function
+ * @mtd: mtd info structure
+ * @chip: nand chip info structure
+ * @buf: buffer to store read data
+ * @oob_required: caller requires OOB data read to chip->oob_poi
+ * @page: page number to read
+ */
+static int nand_read_page_swecc(struct mtd_info *mtd, struct nand_chip *chip,
+				uint8_t *buf, int oob_required, int page)
+{
+	chip->ecc.read_page_raw(mtd, chip, buf, 1, page);
+
+	return nand_correct_page_swecc(mtd, chip, buf);
+}
+
+/**
+ * nand_read_page_start - [INTERN] start loading a page without waiting
+ * @mtd: mtd info structure
+ * @page: page number to load into the data register
+ *
+ * Same command sequence as nand_command_lp() issues for NAND_CMD_READ0 at
+ * column 0, minus the final ready wait. The caller must call
+ * nand_read_page_finish() before touching the data register again.
+ */
+static void nand_read_page_start(struct mtd_info *mtd, int page)
+{
+	struct nand_chip *chip = mtd_to_nand(mtd);
+	int ctrl = NAND_CTRL_CHANGE | NAND_NCE | NAND_ALE;
+
+	chip->cmd_ctrl(mtd, NAND_CMD_READ0,
+		       NAND_NCE | NAND_CLE | NAND_CTRL_CHANGE);
+	chip->cmd_ctrl(mtd, 0, ctrl);
+	ctrl &= ~NAND_CTRL_CHANGE;
+	chip->cmd_ctrl(mtd, 0, ctrl);
+	chip->cmd_ctrl(mtd, page, ctrl);
+	chip->cmd_ctrl(mtd, page >> 8, NAND_NCE | NAND_ALE);
+	if (chip->chipsize > (128 << 20))
+		chip->cmd_ctrl(mtd, page >> 16, NAND_NCE | NAND_ALE);
+	chip->cmd_ctrl(mtd, NAND_CMD_READSTART,
+		       NAND_NCE | NAND_CLE | NAND_CTRL_CHANGE);
+	chip->cmd_ctrl(mtd, NAND_CMD_NONE, NAND_NCE | NAND_CTRL_CHANGE);
+}
+
+/**
+ * nand_read_page_finish - [INTERN] wait for a load started earlier
+ * @mtd: mtd info structure
+ */
+static void nand_read_page_finish(struct mtd_info *mtd)
+{
+	ndelay(100);
+	nand_wait_ready(mtd);
+}
+
+/**
+ * nand_can_read_ahead - [INTERN] check if page loads may overlap ECC work
+ * @mtd: mtd info structure
+ * @chip: nand chip info structure
+ * @ops: oob ops structure of the read
+ *
+ * Read-ahead is only done where we know the exact command sequence
+ * (nand_command_lp) and can tell when the load has finished (dev_ready),
+ * and where ECC correction is done in software after the transfer.
+ */
+static bool nand_can_read_ahead(struct mtd_info *mtd, struct nand_chip *chip,
+				struct mtd_oob_ops *ops)
+{
+	if (!IS_ENABLED(CONFIG_NAND_READ_AHEAD))
+		return false;
+
+	return chip->cmdfunc == nand_command_lp && chip->dev_ready &&
+	       chip->ecc.read_page == nand_read_page_swecc &&
+	       !chip->setup_read_retry &&
+	       !(chip->options & NAND_NEED_READRDY) &&
+	       ops->mode != MTD_OPS_RAW && !ops->oobbuf;
+}
+
 /**
  * nand_read_subpage - [REPLACEABLE] ECC based sub-page read function
  * @mtd: mtd info structure
@@ -1521,6 +1596,8 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 	unsigned int max_bitflips = 0;
 	int retry_mode = 0;
 	bool ecc_fail = false;
+	bool read_ahead = nand_can_read_ahead(mtd, chip, ops);
+	int ahead_page = -1;
 
 	chipnr = (int)(from >> chip->chip_shift);
 	chip->select_chip(mtd, chipnr);
@@ -1555,13 +1632,27 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 						 __func__, buf);
 
 read_retry:
-			chip->cmdfunc(mtd, NAND_CMD_READ0, 0x00, page);
+			if (page == ahead_page)
+				/* Issued while correcting the previous page */
+				nand_read_page_finish(mtd);
+			else
+				chip->cmdfunc(mtd, NAND_CMD_READ0, 0x00, page);
+			ahead_page = -1;
 
 			/*
 			 * Now read the page into the buffer.  Absent an error,
 			 * the read methods return max bitflips per ecc step.
 			 */
-			if (unlikely(ops->mode == MTD_OPS_RAW))
+			if (read_ahead && aligned && readlen > bytes &&
+			    ((realpage + 1) & chip->pagemask) &&
+			    realpage + 1 != chip->pagebuf) {
+				chip->ecc.read_page_raw(mtd, chip, bufpoi, 1,
+							page);
+				ahead_page = page + 1;
+				nand_read_page_start(mtd, ahead_page);
+				ret = nand_correct_page_swecc(mtd, chip,
+							      bufpoi);
+			} else if (unlikely(ops->mode == MTD_OPS_RAW))
 				ret = chip->ecc.read_page_raw(mtd, chip, bufpoi,
 							      oob_required,
 							      page);
@@ -1665,6 +1756,9 @@ read_retry:
 			chip->select_chip(mtd, chipnr);
 		}
 	}
+	/* Don't deselect the chip in the middle of a load we started */
+	if (ahead_page != -1)
+		nand_read_page_finish(mtd);
 	chip->select_chip(mtd, -1);
 
 	ops->retlen = ops->len - (size_t) readlen;
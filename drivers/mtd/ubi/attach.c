@@ -829,6 +829,11 @@ static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
 		return 0;
 	}
 
+	ubi->attach_stats.scanned++;
+	err = ubi_io_prefetch_hdrs(ubi, pnum);
+	if (err)
+		return err;
+
 	err = ubi_io_read_ec_hdr(ubi, pnum, ech, 0);
 	if (err < 0)
 		return err;
@@ -1399,11 +1404,22 @@ int ubi_attach(struct ubi_device *ubi, int force_scan)
 {
 	int err;
 	struct ubi_attach_info *ai;
+	unsigned long start = get_timer(0);
 
 	ai = alloc_ai();
 	if (!ai)
 		return -ENOMEM;
 
+	memset(&ubi->attach_stats, 0, sizeof(ubi->attach_stats));
+
+	/*
+	 * Both headers are fetched with one read; without this buffer each
+	 * header is read separately.
+	 */
+	ubi->hdr_buf_pnum = -1;
+	ubi->hdr_buf_len = ubi->vid_hdr_aloffset + ubi->vid_hdr_alsize;
+	ubi->hdr_buf = kmalloc(ubi->hdr_buf_len, GFP_KERNEL);
+
 #ifdef CONFIG_MTD_UBI_FASTMAP
 	/* On small flash devices we disable fastmap in any case. */
 	if ((int)mtd_div_by_eb(ubi->mtd->size, ubi->mtd) <= UBI_FM_MAX_START) {
@@ -1478,6 +1494,10 @@ int ubi_attach(struct ubi_device *ubi, int force_scan)
 #endif
 
 	destroy_ai(ai);
+	kfree(ubi->hdr_buf);
+	ubi->hdr_buf = NULL;
+	ubi->attach_stats.fastmap = !!ubi->fm;
+	ubi->attach_stats.time = get_timer(start);
 	return 0;
 
 out_wl:
@@ -1487,6 +1507,8 @@ out_vtbl:
 	vfree(ubi->vtbl);
 out_ai:
 	destroy_ai(ai);
+	kfree(ubi->hdr_buf);
+	ubi->hdr_buf = NULL;
 	return err;
 }
 
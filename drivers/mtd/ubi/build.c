@@ -1073,6 +1073,21 @@ int ubi_attach_mtd_dev(struct mtd_info *mtd, int ubi_num,
 
 	spin_unlock(&ubi->wl_lock);
 
+#if defined(__UBOOT__) && defined(CONFIG_MTD_UBI_FASTMAP)
+	/*
+	 * U-Boot special: there is normally no detach before the OS is
+	 * booted, so write the fastmap right away after attaching by
+	 * scanning. The next attach can then use it instead of scanning.
+	 */
+	if (!ubi->fm_disabled && !ubi->fm && !ubi->ro_mode) {
+		err = ubi_update_fastmap(ubi);
+		if (err)
+			ubi_warn(ubi, "cannot write fastmap, error %d", err);
+		else
+			ubi->attach_stats.fm_written = 1;
+	}
+#endif
+
 	ubi_devices[ubi_num] = ubi;
 	ubi_notify_all(ubi, UBI_VOLUME_ADDED, NULL);
 	return ubi_num;
@@ -132,6 +132,13 @@ int ubi_io_read(const struct ubi_device *ubi, void *buf, int pnum, int offset,
 	if (err)
 		return err;
 
+	/* Served from the headers prefetched while attaching */
+	if (ubi->hdr_buf && pnum == ubi->hdr_buf_pnum &&
+	    offset + len <= ubi->hdr_buf_len) {
+		memcpy(buf, ubi->hdr_buf + offset, len);
+		return ubi->hdr_buf_err;
+	}
+
 	/*
 	 * Deliberately corrupt the buffer to improve robustness. Indeed, if we
 	 * do not do this, the following may happen:
@@ -207,6 +214,44 @@ retry:
 	return err;
 }
 
+/**
+ * ubi_io_prefetch_hdrs - read both headers of a PEB with one MTD read.
+ * @ubi: UBI device description object
+ * @pnum: physical eraseblock number to read from
+ *
+ * While attaching, the EC and VID headers of every PEB are read. This
+ * function fetches the area holding both of them into @ubi->hdr_buf with a
+ * single (multi-page) MTD read, so that the following header reads for
+ * @pnum are served from memory by 'ubi_io_read()'.
+ *
+ * If the read reports an uncorrectable ECC error the buffer is not used, so
+ * that each header read reports its own status. Returns zero or a negative
+ * error code in case of an I/O failure.
+ */
+int ubi_io_prefetch_hdrs(struct ubi_device *ubi, int pnum)
+{
+	size_t read;
+	loff_t addr;
+	int err;
+
+	ubi->hdr_buf_pnum = -1;
+	if (!ubi->hdr_buf)
+		return 0;
+
+	addr = (loff_t)pnum * ubi->peb_size;
+	err = mtd_read(ubi->mtd, addr, ubi->hdr_buf_len, &read, ubi->hdr_buf);
+	if (err && !mtd_is_bitflip(err))
+		return mtd_is_eccerr(err) ? 0 : err;
+	if (read != ubi->hdr_buf_len)
+		return 0;
+
+	ubi->hdr_buf_pnum = pnum;
+	ubi->hdr_buf_err = err ? UBI_IO_BITFLIPS : 0;
+	ubi->attach_stats.hdr_reads++;
+
+	return 0;
+}
+
 /**
  * ubi_io_write - write data to a physical eraseblock.
  * @ubi: UBI device description object
@@ -238,6 +283,9 @@ int ubi_io_write(struct ubi_device *ubi, const void *buf, int pnum, int offset,
 	ubi_assert(offset % ubi->hdrs_min_io_size == 0);
 	ubi_assert(len > 0 && len % ubi->hdrs_min_io_size == 0);
 
+	if (pnum == ubi->hdr_buf_pnum)
+		ubi->hdr_buf_pnum = -1;
+
 	if (ubi->ro_mode) {
 		ubi_err(ubi, "read-only mode");
 		return -EROFS;
@@ -328,6 +376,9 @@ static int do_sync_erase(struct ubi_device *ubi, int pnum)
 	wait_queue_head_t wq;
 
 	dbg_io("erase PEB %d", pnum);
+
+	if (pnum == ubi->hdr_buf_pnum)
+		ubi->hdr_buf_pnum = -1;
 	ubi_assert(pnum >= 0 && pnum < ubi->peb_count);
 
 	if (ubi->ro_mode) {
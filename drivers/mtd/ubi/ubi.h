@@ -412,6 +412,23 @@ struct ubi_debug_info {
 	struct dentry *dfs_power_cut_max;
 };
 
+/**
+ * struct ubi_attach_stats - statistics of the last attach.
+ * @time: time spent in ubi_attach() in milliseconds
+ * @fastmap: non-zero if the device was attached from a fastmap
+ * @fm_written: non-zero if a fastmap was written after attaching by scanning
+ * @scanned: number of PEBs whose headers were read
+ * @hdr_reads: number of PEBs whose EC and VID headers were fetched with a
+ *             single MTD read
+ */
+struct ubi_attach_stats {
+	unsigned long time;
+	int fastmap;
+	int fm_written;
+	int scanned;
+	int hdr_reads;
+};
+
 /**
  * struct ubi_device - UBI device description structure
  * @dev: UBI device object to use the the Linux device model
@@ -517,6 +534,11 @@ struct ubi_debug_info {
  * @bad_allowed: whether the MTD device admits of bad physical eraseblocks or
  *               not
  * @nor_flash: non-zero if working on top of NOR flash
+ * @hdr_buf: EC and VID headers of PEB @hdr_buf_pnum, read with a single MTD
+ *           read while attaching (%NULL if not in use)
+ * @hdr_buf_len: number of valid bytes in @hdr_buf
+ * @hdr_buf_pnum: PEB whose headers are in @hdr_buf (-1 if none)
+ * @hdr_buf_err: return code of the MTD read which filled @hdr_buf
  * @max_write_size: maximum amount of bytes the underlying flash can write at a
  *                  time (MTD write buffer size)
  * @mtd: MTD device descriptor
@@ -526,6 +548,8 @@ struct ubi_debug_info {
  * @ckvol_mutex: serializes static volume checking when opening
  *
  * @dbg: debugging information for this UBI device
+ *
+ * @attach_stats: statistics of the last attach
  */
 struct ubi_device {
 	struct cdev cdev;
@@ -620,11 +644,18 @@ struct ubi_device {
 	int max_write_size;
 	struct mtd_info *mtd;
 
+	void *hdr_buf;
+	int hdr_buf_len;
+	int hdr_buf_pnum;
+	int hdr_buf_err;
+
 	void *peb_buf;
 	struct mutex buf_mutex;
 	struct mutex ckvol_mutex;
 
 	struct ubi_debug_info dbg;
+
+	struct ubi_attach_stats attach_stats;
 };
 
 /**
@@ -882,6 +913,7 @@ int ubi_ensure_anchor_pebs(struct ubi_device *ubi);
 /* io.c */
 int ubi_io_read(const struct ubi_device *ubi, void *buf, int pnum, int offset,
 		int len);
+int ubi_io_prefetch_hdrs(struct ubi_device *ubi, int pnum);
 int ubi_io_write(struct ubi_device *ubi, const void *buf, int pnum, int offset,
 		 int len);
 int ubi_io_sync_erase(struct ubi_device *ubi, int pnum, int torture);
@@ -86,7 +86,8 @@ static void nic_send_msg_to_vf(struct nicpf *nic, int vf, union nic_mbx *mbx)
 static void nic_mbx_send_ready(struct nicpf *nic, int vf)
 {
 	union nic_mbx mbx = {};
-	int bgx_idx, lmac, timeout = 5, link = -1;
+	int bgx_idx, lmac, link;
+	ulong start;
 	const u8 *mac;
 
 	mbx.nic_cfg.msg = NIC_MBOX_MSG_READY;
@@ -105,12 +106,18 @@ static void nic_mbx_send_ready(struct nicpf *nic, int vf)
 		if (mac)
 			memcpy((u8 *)&mbx.nic_cfg.mac_addr, mac, 6);
 
-		while (timeout-- && (link <= 0)){
-			link = bgx_poll_for_link(nic->node, bgx_idx, lmac);
-			debug("Link status: %d\n", link);
-			if (link <= 0)
-				mdelay(2000);
+		/* Training started at probe, so this is often already done */
+		start = get_timer(0);
+		while ((link = bgx_poll_for_link(nic->node, bgx_idx,
+						 lmac)) <= 0) {
+			if (get_timer(start) > CONFIG_BGX_LINK_TIMEOUT) {
+				printf("BGX%d:LMAC %u link down\n", bgx_idx,
+				       lmac);
+				break;
+			}
+			mdelay(BGX_LINK_POLL_MS);
 		}
+		debug("Link status: %d\n", link);
 	}
 #ifdef VNIC_MULTI_QSET_SUPPORT
 	mbx.nic_cfg.sqs_mode = (vf >= nic->num_vf_en) ? true : false;
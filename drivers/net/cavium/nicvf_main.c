@@ -228,6 +228,7 @@ static void nicvf_snd_pkt_handler(struct nicvf *nic,
 	struct cqe_send_t *cqe_tx;
 	struct snd_queue *sq;
 	struct sq_hdr_subdesc *hdr;
+	int mask, used, done;
 
 	cqe_tx = (struct cqe_send_t *)cq_desc;
 	sq = &nic->qs->sq[cqe_tx->sq_idx];
@@ -237,7 +238,65 @@ static void nicvf_snd_pkt_handler(struct nicvf *nic,
 		return;
 
 	nicvf_check_cqe_tx_errs(nic, cq, cq_desc);
-	nicvf_put_sq_desc(sq, hdr->subdesc_cnt + 1);
+
+	/*
+	 * Only the last frame of a batch posts a CQE, and the SQ is processed
+	 * in order, so everything up to the end of this frame has been sent.
+	 * Ignore a CQE for frames which were already freed.
+	 */
+	mask = sq->dmem.q_len - 1;
+	used = mask - sq->free_cnt;
+	done = (cqe_tx->sqe_ptr + hdr->subdesc_cnt + 1 - sq->head) & mask;
+	if (done && done <= used)
+		nicvf_put_sq_desc(sq, done);
+}
+
+/*
+ * Free send descriptors whose CQEs are at the head of the CQ, stopping at
+ * the first received packet so that it is left for nicvf_recv()
+ */
+static void nicvf_reap_tx(struct nicvf *nic)
+{
+	struct cmp_queue *cq = &nic->qs->cq[0];
+	unsigned long cqe_count, cqe_head;
+	struct cqe_rx_t *cq_desc;
+	int processed_cqe = 0;
+
+	cqe_count = nicvf_queue_reg_read(nic, NIC_QSET_CQ_0_7_STATUS, 0);
+	cqe_count &= 0xFFFF;
+	cqe_head = nicvf_queue_reg_read(nic, NIC_QSET_CQ_0_7_HEAD, 0) >> 9;
+	cqe_head &= 0xFFFF;
+
+	while (processed_cqe < cqe_count) {
+		cq_desc = (struct cqe_rx_t *)GET_CQ_DESC(cq, cqe_head);
+		if (cq_desc->cqe_type != CQE_TYPE_SEND)
+			break;
+		nicvf_snd_pkt_handler(nic, cq, cq_desc, CQE_TYPE_SEND);
+		cqe_head = (cqe_head + 1) & (cq->dmem.q_len - 1);
+		processed_cqe++;
+	}
+	if (!processed_cqe)
+		return;
+
+	nicvf_queue_reg_write(nic, NIC_QSET_CQ_0_7_DOOR, 0, processed_cqe);
+
+	asm volatile ("dsb sy");
+}
+
+/*
+ * Check whether the hardware found a bad IPv4 header or UDP checksum. Since
+ * the network stack relies on these being dropped here, it is not told about
+ * an L4 error on a fragment; the datagram is checked after reassembly.
+ */
+static bool nicvf_rx_csum_bad(struct cqe_rx_t *cqe_rx, void *pkt)
+{
+	struct ip_udp_hdr *ip = pkt + ETHER_HDR_SIZE;
+
+	if (cqe_rx->err_opcode == CQ_RX_ERROP_IP_CSUM_ERR)
+		return true;
+
+	return cqe_rx->err_opcode == CQ_RX_ERROP_L4_CHK &&
+	       !(ntohs(ip->ip_off) & (IP_OFFS | IP_FLAGS_MFRAG));
 }
 
 static int nicvf_rcv_pkt_handler(struct nicvf *nic,
@@ -261,6 +320,12 @@ static int nicvf_rcv_pkt_handler(struct nicvf *nic,
 		return -1;
 	}
 
+	if (err && nicvf_rx_csum_bad(cqe_rx, pkt)) {
+		/* Give the buffer back, as nicvf_recv() only does for packets */
+		nicvf_refill_rbdr(nic);
+		return 0;
+	}
+
 	if (pkt)
 		*ppkt = pkt;
 
@@ -349,30 +414,71 @@ void nicvf_handle_qs_err(struct nicvf *nic)
 	}
 }
 
-static int nicvf_xmit(struct eth_device *netdev, void *pkt, int pkt_len)
+/* Wait for the hardware to finish with some of the queued frames */
+static bool nicvf_wait_tx(struct nicvf *nic)
 {
-	struct nicvf *nic = netdev->priv;
-	int ret = 0;
-	int rcv_len = 0;
+	struct snd_queue *sq = &nic->qs->sq[0];
 	unsigned int timeout = 5000;
-	void *rpkt = NULL;
 
-	if (!nicvf_sq_append_pkt(nic, pkt, pkt_len)) {
-		printf("VF%d: TX ring full\n", nic->vf_id);
-		return -1;
+	while (timeout--) {
+		nicvf_reap_tx(nic);
+		if (nicvf_sq_pending(sq) < SND_QUEUE_TX_BUFS)
+			return true;
+		udelay(10);
 	}
 
-	/* check and update CQ for pkt sent */
-	while (!ret && timeout--) {
-		ret = nicvf_cq_handler(nic, &rpkt, &rcv_len);
-		if (!ret)
-		{
-			debug("%s: %d, Not sent\n", __FUNCTION__, __LINE__);
-			udelay(10);
+	return false;
+}
+
+/*
+ * Queue the frames and ring the doorbell once. Their completions are
+ * collected by nicvf_recv(), or here when all the send buffers are in use.
+ */
+static int nicvf_xmit_batch(struct eth_device *netdev, struct eth_pkt *pkts,
+			    int count)
+{
+	struct nicvf *nic = netdev->priv;
+	struct snd_queue *sq = &nic->qs->sq[0];
+	int desc_cnt = 0;
+	bool post_cqe;
+	int sent = 0;
+	int ret;
+
+	while (sent < count) {
+		/* Ask for a CQE at the end of the batch and every half ring */
+		post_cqe = sent == count - 1 ||
+			nicvf_sq_pending(sq) % (SND_QUEUE_TX_BUFS / 2) ==
+			SND_QUEUE_TX_BUFS / 2 - 1;
+		ret = nicvf_sq_append_pkt(nic, pkts[sent].packet,
+					  pkts[sent].length, post_cqe);
+		if (ret == -ENOSPC) {
+			if (desc_cnt)
+				nicvf_sq_doorbell(nic, 0, desc_cnt);
+			desc_cnt = 0;
+			if (!nicvf_wait_tx(nic)) {
+				printf("VF%d: TX ring full\n", nic->vf_id);
+				break;
+			}
+			continue;
+		}
+		if (ret < 0) {
+			printf("VF%d: TX packet too long\n", nic->vf_id);
+			break;
 		}
+		desc_cnt += ret;
+		sent++;
 	}
+	if (desc_cnt)
+		nicvf_sq_doorbell(nic, 0, desc_cnt);
 
-	return 0;
+	return sent ? sent : -1;
+}
+
+static int nicvf_xmit(struct eth_device *netdev, void *pkt, int pkt_len)
+{
+	struct eth_pkt one = { .packet = pkt, .length = pkt_len };
+
+	return nicvf_xmit_batch(netdev, &one, 1) == 1 ? 0 : -1;
 }
 
 static int nicvf_recv(struct eth_device *netdev)
@@ -385,7 +491,9 @@ static int nicvf_recv(struct eth_device *netdev)
 	int i, j;
 #endif
 
-	nicvf_cq_handler(nic, &pkt, &pkt_len);
+	/* Skip over send completions to the next received packet */
+	while (nicvf_cq_handler(nic, &pkt, &pkt_len) && !pkt_len)
+		;
 
 	if (pkt_len) {
 #ifdef DEBUG
@@ -501,7 +609,9 @@ int nicvf_initialize(struct udevice *pdev, int vf_num)
 	netdev->halt = nicvf_stop;
 	netdev->init = nicvf_open;
 	netdev->send = nicvf_xmit;
+	netdev->send_batch = nicvf_xmit_batch;
 	netdev->recv = nicvf_recv;
+	netdev->offload = ETH_OFFLOAD_RX_CSUM | ETH_OFFLOAD_TX_IP_CSUM;
 
 	if (!eth_getenv_enetaddr_by_index("eth", nicvf->vf_id, netdev->enetaddr)) {
 		eth_getenv_enetaddr("ethaddr", netdev->enetaddr);
@@ -221,6 +221,11 @@ static int nicvf_init_snd_queue(struct nicvf *nic,
 
 	sq->desc = sq->dmem.base;
 	sq->skbuff = calloc(q_len, sizeof(uint64_t));
+	sq->tx_buf = calloc(SND_QUEUE_TX_BUFS, DMA_BUFFER_LEN);
+	if (!sq->skbuff || !sq->tx_buf) {
+		printf("Unable to allocate memory for send buffers\n");
+		return -1;
+	}
 	sq->head = 0;
 	sq->tail = 0;
 	sq->free_cnt = q_len - 1;
@@ -238,6 +243,7 @@ static void nicvf_free_snd_queue(struct nicvf *nic, struct snd_queue *sq)
 
 	debug("%s: %d\n", __FUNCTION__, __LINE__);
 	free(sq->skbuff);
+	free(sq->tx_buf);
 
 	nicvf_free_q_desc_mem(nic, &sq->dmem);
 }
@@ -727,6 +733,12 @@ void nicvf_sq_free_used_descs(struct eth_device *netdev, struct snd_queue *sq,
 	}
 }
 
+/* Get the number of frames queued and not yet known to be sent */
+int nicvf_sq_pending(struct snd_queue *sq)
+{
+	return (sq->dmem.q_len - 1 - sq->free_cnt) / MIN_SQ_DESC_PER_PKT_XMIT;
+}
+
 /* Get the number of SQ descriptors needed to xmit this skb */
 static int nicvf_sq_subdesc_required(struct nicvf *nic)
 {
@@ -740,8 +752,10 @@ static int nicvf_sq_subdesc_required(struct nicvf *nic)
  */
 static inline void
 nicvf_sq_add_hdr_subdesc(struct nicvf *nic, struct snd_queue *sq, int qentry,
-			 int subdesc_cnt, void *pkt, size_t pkt_len)
+			 int subdesc_cnt, void *pkt, size_t pkt_len,
+			 bool post_cqe)
 {
+	struct ethernet_hdr *et = pkt;
 	struct sq_hdr_subdesc *hdr;
 
 	hdr = (struct sq_hdr_subdesc *)GET_SQ_DESC(sq, qentry);
@@ -750,10 +764,16 @@ nicvf_sq_add_hdr_subdesc(struct nicvf *nic, struct snd_queue *sq, int qentry,
 	memset(hdr, 0, SND_QUEUE_DESC_SIZE);
 	hdr->subdesc_type = SQ_DESC_TYPE_HEADER;
 	/* Enable notification via CQE after processing SQE */
-	hdr->post_cqe = 1;
+	hdr->post_cqe = post_cqe;
 	/* No of subdescriptors following this */
 	hdr->subdesc_cnt = subdesc_cnt;
 	hdr->tot_len = pkt_len;
+	/* Fill in the IPv4 header checksum (ETH_OFFLOAD_TX_IP_CSUM) */
+	if (pkt_len >= ETHER_HDR_SIZE + IP_HDR_SIZE &&
+	    et->et_protlen == htons(PROT_IP)) {
+		hdr->csum_l3 = 1;
+		hdr->l3_offset = ETHER_HDR_SIZE;
+	}
 
 	flush_dcache_range((uintptr_t)hdr,
 			   (uintptr_t)hdr + sizeof(struct sq_hdr_subdesc));
@@ -780,45 +800,64 @@ static inline void nicvf_sq_add_gather_subdesc(struct snd_queue *sq, int qentry,
 			   (uintptr_t)gather + sizeof(struct sq_hdr_subdesc));
 }
 
-/* Append an skb to a SQ for packet transfer. */
-int nicvf_sq_append_pkt(struct nicvf *nic, void *pkt, size_t pkt_size)
+/*
+ * Append a packet to a SQ, copying it to a send buffer. The hardware is not
+ * told until nicvf_sq_doorbell(), and only posts a CQE for the frame if
+ * @post_cqe; that CQE then completes all the frames queued before it too.
+ *
+ * Returns the number of descriptors used, or -ve on error
+ */
+int nicvf_sq_append_pkt(struct nicvf *nic, void *pkt, size_t pkt_size,
+			bool post_cqe)
 {
 	int subdesc_cnt;
-	int sq_num = 0, qentry;
+	int sq_num = 0, qentry, buf_idx;
 	struct queue_set *qs;
 	struct snd_queue *sq;
+	void *buf;
 
 	qs = nic->qs;
 	sq = &qs->sq[sq_num];
 
+	if (pkt_size > DMA_BUFFER_LEN)
+		return -EINVAL;
 	subdesc_cnt = nicvf_sq_subdesc_required(nic);
-	if (subdesc_cnt > sq->free_cnt)
-		goto append_fail;
+	if (subdesc_cnt > sq->free_cnt ||
+	    nicvf_sq_pending(sq) >= SND_QUEUE_TX_BUFS)
+		return -ENOSPC;
 
 	qentry = nicvf_get_sq_desc(sq, subdesc_cnt);
 
+	/*
+	 * Frames are queued and completed in order, so the SND_QUEUE_TX_BUFS
+	 * in flight always have different buffers
+	 */
+	buf_idx = (qentry / MIN_SQ_DESC_PER_PKT_XMIT) % SND_QUEUE_TX_BUFS;
+	buf = sq->tx_buf + buf_idx * DMA_BUFFER_LEN;
+	memcpy(buf, pkt, pkt_size);
+
 	/* Add SQ header subdesc */
 	nicvf_sq_add_hdr_subdesc(nic, sq, qentry, subdesc_cnt - 1,
-				 pkt, pkt_size);
+				 buf, pkt_size, post_cqe);
 
 	/* Add SQ gather subdescs */
 	qentry = nicvf_get_nxt_sqentry(sq, qentry);
-	nicvf_sq_add_gather_subdesc(sq, qentry, pkt_size, (uintptr_t)(pkt));
+	nicvf_sq_add_gather_subdesc(sq, qentry, pkt_size, (uintptr_t)(buf));
+
+	flush_dcache_range((uintptr_t)buf,
+			   (uintptr_t)buf + pkt_size);
 
-	flush_dcache_range((uintptr_t)pkt,
-			   (uintptr_t)pkt + pkt_size);
+	return subdesc_cnt;
+}
 
+/* Tell the hardware about descriptors added with nicvf_sq_append_pkt() */
+void nicvf_sq_doorbell(struct nicvf *nic, int qidx, int desc_cnt)
+{
 	/* make sure all memory stores are done before ringing doorbell */
 	asm volatile ("dsb sy");
 
-	/* Inform HW to xmit new packet */
-	nicvf_queue_reg_write(nic, NIC_QSET_SQ_0_7_DOOR,
-			      sq_num, subdesc_cnt);
-	return 1;
-
-append_fail:
-	printf("Not enough SQ descriptors to xmit pkt\n");
-	return 0;
+	/* Inform HW to xmit new packets */
+	nicvf_queue_reg_write(nic, NIC_QSET_SQ_0_7_DOOR, qidx, desc_cnt);
 }
 
 static unsigned frag_num(unsigned i)
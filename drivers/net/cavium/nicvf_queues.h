@@ -66,6 +66,12 @@
 #define SND_QUEUE_THRESH	2ULL
 #define MIN_SQ_DESC_PER_PKT_XMIT	2
 #define MAX_CQE_PER_PKT_XMIT		2
+/*
+ * Frames in flight, each copied to its own buffer so the caller can reuse
+ * the packet at once. A completion is asked for at least every half of
+ * these, so the ring always drains.
+ */
+#define SND_QUEUE_TX_BUFS		32
 
 #define CMP_QSIZE		CMP_QUEUE_SIZE0
 #define CMP_QUEUE_LEN		(1ULL << (CMP_QSIZE + 10))
@@ -290,6 +296,7 @@ struct snd_queue {
 	uint32_t	head;
 	uint32_t	tail;
 	uint64_t	*skbuff;
+	void		*tx_buf;	/* SND_QUEUE_TX_BUFS frames */
 	void		*desc;
 	struct q_desc_mem   dmem;
 	struct rx_tx_queue_stats stats;
@@ -338,7 +345,10 @@ void nicvf_sq_disable(struct nicvf *nic, int qidx);
 void nicvf_put_sq_desc(struct snd_queue *sq, int desc_cnt);
 void nicvf_sq_free_used_descs(struct eth_device *netdev,
 								struct snd_queue *sq, int qidx);
-int nicvf_sq_append_pkt(struct nicvf *nic, void *pkt, size_t pkt_len);
+int nicvf_sq_append_pkt(struct nicvf *nic, void *pkt, size_t pkt_len,
+			bool post_cqe);
+void nicvf_sq_doorbell(struct nicvf *nic, int qidx, int desc_cnt);
+int nicvf_sq_pending(struct snd_queue *sq);
 
 void *nicvf_get_rcv_pkt(struct nicvf *nic, void *cq_desc, size_t *pkt_len);
 void nicvf_refill_rbdr(struct nicvf *nic);
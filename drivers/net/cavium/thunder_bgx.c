@@ -45,6 +45,9 @@ struct lmac {
 	int			lmac_type;
 	u8			qlm_mode;
 	int			qlm;
+	ulong			link_start;	/* get_timer() at enable */
+	ulong			link_restart;	/* ... at last AN/training restart */
+	bool			link_reported;
 };
 
 struct bgx {
@@ -109,6 +112,18 @@ static int bgx_poll_reg(struct bgx *bgx, uint8_t lmac,
 	return 1;
 }
 
+/* Check a register once, without waiting */
+static int bgx_check_reg(struct bgx *bgx, uint8_t lmac,
+			 uint64_t reg, uint64_t mask, bool zero)
+{
+	uint64_t reg_val = bgx_reg_read(bgx, lmac, reg);
+
+	if (zero)
+		return (reg_val & mask) ? 1 : 0;
+
+	return (reg_val & mask) ? 0 : 1;
+}
+
 static int gser_poll_reg(uint64_t reg, int bit, uint64_t mask, uint64_t expected_val, int timeout)
 {
 	uint64_t reg_val;
@@ -343,14 +358,10 @@ static int bgx_lmac_sgmii_init(struct bgx *bgx, int lmacid)
 		return 0; /* Skip checking AN_CPT */
 	}
 
-	if (lmac->qlm_mode == QLM_MODE_SGMII) {
-		if (bgx_poll_reg(bgx, lmacid, BGX_GMP_PCS_MRX_STATUS,
-			 PCS_MRX_STATUS_AN_CPT, false)) {
-			printf("BGX AN_CPT not completed\n");
-			return -1;
-		}
-	}
-
+	/*
+	 * Autonegotiation completes in the background; bgx_poll_for_link()
+	 * checks it when the port is used
+	 */
 	return 0;
 }
 
@@ -621,6 +632,19 @@ int __rx_equalization(int qlm, int lane)
 	return (fail) ? -1 : 0;
 }
 
+/*
+ * Restarting autonegotiation or training too often stops it completing, so
+ * only allow it every BGX_LINK_RESTART_MS
+ */
+static bool bgx_link_restart_due(struct lmac *lmac)
+{
+	if (get_timer(lmac->link_restart) < BGX_LINK_RESTART_MS)
+		return false;
+	lmac->link_restart = get_timer(0);
+
+	return true;
+}
+
 static int bgx_xaui_check_link(struct lmac *lmac)
 {
 	struct bgx *bgx = lmac->bgx;
@@ -635,6 +659,8 @@ static int bgx_xaui_check_link(struct lmac *lmac)
 	if (cfg & SPU_AN_CTL_AN_EN) {
 		cfg = bgx_reg_read(bgx, lmacid, BGX_SPUX_AN_STATUS);
 		if (!(cfg & SPU_AN_STS_AN_COMPLETE)) {
+			if (!bgx_link_restart_due(lmac))
+				return -1;
 			/* Restart autonegotiation */
 			debug("restarting auto-neg\n");
 			bgx_reg_modify(bgx, lmacid, BGX_SPUX_AN_CONTROL, SPU_AN_CTL_AN_RESTART);
@@ -647,6 +673,8 @@ static int bgx_xaui_check_link(struct lmac *lmac)
 		cfg = bgx_reg_read(bgx, lmacid, BGX_SPUX_INT);
 		if (!(cfg & (1ull << 13))) {
 			debug("waiting for link training\n");
+			if (!bgx_link_restart_due(lmac))
+				return -1;
 			/* Clear the training interrupts (W1C) */
 			cfg = (1ull << 13) | (1ull << 14);
 			bgx_reg_write(bgx, lmacid, BGX_SPUX_INT, cfg);
@@ -679,13 +707,13 @@ static int bgx_xaui_check_link(struct lmac *lmac)
 			if (use_dlm) {
 				if (__rx_equalization(lmac->qlm, -1) ||
 					__rx_equalization(lmac->qlm+1, -1)) {
-					printf("BGX%d:%d: Waiting for RX Equalization on DLM%d/DLM%d\n",
+					debug("BGX%d:%d: Waiting for RX Equalization on DLM%d/DLM%d\n",
 						bgx->bgx_id, lmacid, lmac->qlm, lmac->qlm+1);
 					return -1;
 				}
 			} else {
 				if (__rx_equalization(lmac->qlm, -1)) {
-					printf("BGX%d:%d: Waiting for RX Equalization on QLM%d:\n",
+					debug("BGX%d:%d: Waiting for RX Equalization on QLM%d:\n",
 						bgx->bgx_id, lmacid, lmac->qlm);
 					return -1;
 				}
@@ -696,12 +724,12 @@ static int bgx_xaui_check_link(struct lmac *lmac)
 			   RXAUI requires 2 lanes for each interface */
 			qlm = lmac->qlm;
 			if (__rx_equalization(qlm, 0)) {
-				printf("BGX%d:%d: Waiting for RX Equalization on QLM%d, Lane0\n",
+				debug("BGX%d:%d: Waiting for RX Equalization on QLM%d, Lane0\n",
 					bgx->bgx_id, lmacid, qlm);
 				return -1;
 			}
 			if (__rx_equalization(qlm, 1)) {
-				printf("BGX%d:%d: Waiting for RX Equalization on QLM%d, Lane1\n",
+				debug("BGX%d:%d: Waiting for RX Equalization on QLM%d, Lane1\n",
 					bgx->bgx_id, lmacid, qlm);
 				return -1;
 			}
@@ -717,7 +745,7 @@ static int bgx_xaui_check_link(struct lmac *lmac)
 					lid = lmacid;
 
 				if (__rx_equalization(lmac->qlm, lid))
-					printf("BGX%d:%d: Waiting for RX Equalization on QLM%d\n",
+					debug("BGX%d:%d: Waiting for RX Equalization on QLM%d\n",
 						bgx->bgx_id, lid, lmac->qlm);
 			}
 			break;
@@ -730,16 +758,17 @@ static int bgx_xaui_check_link(struct lmac *lmac)
 		return -1;
 	}
 
+	/* No lock yet means the link partner is still training; try later */
 	if ((lmac_type == 3) || (lmac_type == 4)) {
-		if (bgx_poll_reg(bgx, lmacid, BGX_SPUX_BR_STATUS1,
-				 SPU_BR_STATUS_BLK_LOCK, false)) {
-			printf("SPU_BR_STATUS_BLK_LOCK not completed\n");
+		if (bgx_check_reg(bgx, lmacid, BGX_SPUX_BR_STATUS1,
+				  SPU_BR_STATUS_BLK_LOCK, false)) {
+			debug("SPU_BR_STATUS_BLK_LOCK not completed\n");
 			return -1;
 		}
 	} else {
-		if (bgx_poll_reg(bgx, lmacid, BGX_SPUX_BX_STATUS,
-				 SPU_BX_STATUS_RX_ALIGN, false)) {
-			printf("SPU_BX_STATUS_RX_ALIGN not completed\n");
+		if (bgx_check_reg(bgx, lmacid, BGX_SPUX_BX_STATUS,
+				  SPU_BX_STATUS_RX_ALIGN, false)) {
+			debug("SPU_BX_STATUS_RX_ALIGN not completed\n");
 			return -1;
 		}
 	}
@@ -747,8 +776,8 @@ static int bgx_xaui_check_link(struct lmac *lmac)
 	/* Clear rcvflt bit (latching high) and read it back */
 	bgx_reg_modify(bgx, lmacid, BGX_SPUX_STATUS2, SPU_STATUS2_RCVFLT);
 	if (bgx_reg_read(bgx, lmacid, BGX_SPUX_STATUS2) & SPU_STATUS2_RCVFLT) {
-		printf("Receive fault, retry training\n");
-		if (lmac->use_training) {
+		debug("Receive fault, retry training\n");
+		if (lmac->use_training && bgx_link_restart_due(lmac)) {
 			cfg = bgx_reg_read(bgx, lmacid, BGX_SPUX_INT);
 			if (!(cfg & (1ull << 13))) {
 				cfg = (1ull << 13) | (1ull << 14);
@@ -803,6 +832,25 @@ static int bgx_xaui_check_link(struct lmac *lmac)
 	return 0;
 }
 
+/* Report the time from enable to link up, once for each time it comes up */
+static void bgx_report_link(struct lmac *lmac, int bgx_idx)
+{
+	if (!lmac->link_up) {
+		lmac->link_reported = false;
+		return;
+	}
+	if (lmac->link_reported)
+		return;
+	lmac->link_reported = true;
+	printf("BGX%d:LMAC %u link up, %lu ms after enable\n", bgx_idx,
+	       lmac->lmacid, get_timer(lmac->link_start));
+}
+
+/*
+ * Check the link without waiting for training or autonegotiation to finish.
+ * Returns 1 if the link is up, 0 (or -ve) if not yet; the caller retries
+ * until CONFIG_BGX_LINK_TIMEOUT.
+ */
 int bgx_poll_for_link(int node, int bgx_idx, int lmacid)
 {
 	int ret;
@@ -824,10 +872,15 @@ int bgx_poll_for_link(int node, int bgx_idx, int lmacid)
 	    (lmac->qlm_mode == QLM_MODE_QSGMII)) {
 
 		if (bgx_board_info[bgx_idx].phy_info[lmacid].phy_addr == -1) {
+			if (lmac->qlm_mode == QLM_MODE_SGMII &&
+			    bgx_check_reg(lmac->bgx, lmacid,
+					  BGX_GMP_PCS_MRX_STATUS,
+					  PCS_MRX_STATUS_AN_CPT, false))
+				return 0;
 			lmac->link_up = 1;
 			lmac->last_speed = 1000;
 			lmac->last_duplex = 1;
-			printf("BGX%d:LMAC %u link up\n", bgx_idx, lmacid);
+			bgx_report_link(lmac, bgx_idx);
 			return lmac->link_up;
 		}
 		snprintf(mii_name, sizeof(mii_name), "smi%d",
@@ -846,21 +899,26 @@ int bgx_poll_for_link(int node, int bgx_idx, int lmacid)
 			return ret;
 		}
 
-		lmac->phydev = phy_connect(lmac->mii_bus, lmac->phy_addr,
-					   &lmac->netdev,
-					   if_mode[lmac->qlm_mode]);
-
+		/* Connect once; later polls only check the link */
 		if (!lmac->phydev) {
-			printf("%s: No PHY device\n",
-				lmac->netdev.name);
-			return -1;
-		}
+			lmac->phydev = phy_connect(lmac->mii_bus,
+						   lmac->phy_addr,
+						   &lmac->netdev,
+						   if_mode[lmac->qlm_mode]);
+
+			if (!lmac->phydev) {
+				printf("%s: No PHY device\n",
+					lmac->netdev.name);
+				return -1;
+			}
 
-		ret = phy_config(lmac->phydev);
-		if (ret) {
-			printf("%s: Could not initialize PHY %s\n",
-				lmac->netdev.name, lmac->phydev->dev->name);
-			return ret;
+			ret = phy_config(lmac->phydev);
+			if (ret) {
+				printf("%s: Could not initialize PHY %s\n",
+					lmac->netdev.name,
+					lmac->phydev->dev->name);
+				return ret;
+			}
 		}
 
 		ret = phy_startup(lmac->phydev);
@@ -920,13 +978,14 @@ int bgx_poll_for_link(int node, int bgx_idx, int lmacid)
 			lmac->link_up = 0;
 			lmac->last_speed = 0;
 			lmac->last_duplex = 0;
+			lmac->link_reported = false;
 			return bgx_xaui_check_link(lmac);
 		}
 
 		lmac->last_link = lmac->link_up;
 	}
 
-	printf("BGX%d:LMAC %u link %s\n", bgx_idx, lmacid,  (lmac->link_up) ? "up" : "down");
+	bgx_report_link(lmac, bgx_idx);
 
 	return lmac->link_up;
 }
@@ -939,6 +998,8 @@ static int bgx_lmac_enable(struct bgx *bgx, int8_t lmacid)
 
 	lmac = &bgx->lmac[lmacid];
 	lmac->bgx = bgx;
+	lmac->link_start = get_timer(0);
+	lmac->link_restart = lmac->link_start;
 
 	debug("bgx_lmac_enable: lmac: %p, lmacid = %d\n", lmac, lmacid);
 
@@ -1448,7 +1509,10 @@ skip_qlm_config:
 
 	bgx_init_hw(bgx);
 
-	/* Enable all LMACs */
+	/*
+	 * Enable all LMACs. This starts autonegotiation and link training
+	 * without waiting for them, so all ports train in parallel
+	 */
 	for (lmac = 0; lmac < bgx->lmac_count; lmac++) {
 		snprintf(bgx->lmac[lmac].netdev.name,
 			 sizeof(bgx->lmac[lmac].netdev.name),
@@ -19,6 +19,15 @@
 
 #define    MAX_LMAC	(CONFIG_MAX_BGX_PER_NODE * MAX_LMAC_PER_BGX)
 
+/*
+ * Link training starts on every LMAC when the BGX is probed; the result is
+ * only waited for when a port is first used, for up to
+ * CONFIG_BGX_LINK_TIMEOUT. The interval between checks, and the least time
+ * between restarts of autonegotiation or training, in ms.
+ */
+#define    BGX_LINK_POLL_MS			10
+#define    BGX_LINK_RESTART_MS			2000
+
 #define    NODE_ID_MASK				0x300000000000
 #define    NODE_ID(x)				((x & NODE_ID_MASK) >> 44)
 
@@ -16,6 +16,9 @@ DECLARE_GLOBAL_DATA_PTR;
 #define CONFIG_NETCONSOLE_BUFFER_SIZE 512
 #endif
 
+/* Number of packets of output handed to the driver at once */
+#define NC_BATCH 4
+
 static char input_buffer[CONFIG_NETCONSOLE_BUFFER_SIZE];
 static int input_size; /* char count in input buffer */
 static int input_offset; /* offset to valid chars in input buffer */
@@ -28,6 +31,7 @@ static short nc_out_port; /* target output port */
 static short nc_in_port; /* source input port */
 static const char *output_packet; /* used by first send udp */
 static int output_packet_len;
+static uchar nc_frames[NC_BATCH][PKTSIZE_ALIGN] __aligned(PKTALIGN);
 /*
  * Start with a default last protocol.
  * We are only interested in NETCONS or not.
@@ -168,6 +172,19 @@ int nc_input_packet(uchar *pkt, struct in_addr src_ip, unsigned dest_port,
 	return 1;
 }
 
+/* Fill in a frame for the output in @buf, returning its length */
+static int nc_make_frame(uchar *frame, const char *buf, int len)
+{
+	int eth_hdr_size = net_set_ether(frame, nc_ether, PROT_IP);
+
+	memcpy(frame + eth_hdr_size + IP_UDP_HDR_SIZE, buf, len);
+	net_set_udp_header(frame + eth_hdr_size, nc_ip, nc_out_port,
+			   nc_in_port, len);
+
+	return eth_hdr_size + IP_UDP_HDR_SIZE + len;
+}
+
+/* Send @len bytes of output, split into packets of up to a buffer's worth */
 static void nc_send_packet(const char *buf, int len)
 {
 #ifdef CONFIG_DM_ETH
@@ -175,10 +192,10 @@ static void nc_send_packet(const char *buf, int len)
 #else
 	struct eth_device *eth;
 #endif
+	struct eth_pkt pkts[NC_BATCH];
 	int inited = 0;
-	uchar *pkt;
-	uchar *ether;
-	struct in_addr ip;
+	int send_len;
+	int n;
 
 	debug_cond(DEBUG_DEV_PKT, "output: \"%*.*s\"\n", len, len, buf);
 
@@ -189,13 +206,19 @@ static void nc_send_packet(const char *buf, int len)
 	if (!memcmp(nc_ether, net_null_ethaddr, 6)) {
 		if (eth_is_active(eth))
 			return;	/* inside net loop */
+		send_len = min(len, (int)sizeof(input_buffer));
 		output_packet = buf;
-		output_packet_len = len;
+		output_packet_len = send_len;
 		input_recursion = 1;
 		net_loop(NETCONS); /* wait for arp reply and send packet */
 		input_recursion = 0;
 		output_packet_len = 0;
-		return;
+		if (!memcmp(nc_ether, net_null_ethaddr, 6))
+			return;
+		buf += send_len;
+		len -= send_len;
+		if (!len)
+			return;
 	}
 
 	if (!eth_is_active(eth)) {
@@ -209,11 +232,20 @@ static void nc_send_packet(const char *buf, int len)
 
 		inited = 1;
 	}
-	pkt = (uchar *)net_tx_packet + net_eth_hdr_size() + IP_UDP_HDR_SIZE;
-	memcpy(pkt, buf, len);
-	ether = nc_ether;
-	ip = nc_ip;
-	net_send_udp_packet(ether, ip, nc_out_port, nc_in_port, len);
+
+	/* A long string goes to the driver a batch of packets at a time */
+	while (len) {
+		for (n = 0; n < NC_BATCH && len; n++) {
+			send_len = min(len, (int)sizeof(input_buffer));
+			pkts[n].packet = nc_frames[n];
+			pkts[n].length = nc_make_frame(nc_frames[n], buf,
+						       send_len);
+			buf += send_len;
+			len -= send_len;
+		}
+		if (eth_send_batch(pkts, n) < n)
+			break;
+	}
 
 	if (inited) {
 		if (eth_is_on_demand_init())
@@ -263,12 +295,8 @@ static void nc_stdio_puts(struct stdio_dev *dev, const char *s)
 	output_recursion = 1;
 
 	len = strlen(s);
-	while (len) {
-		int send_len = min(len, (int)sizeof(input_buffer));
-		nc_send_packet(s, send_len);
-		len -= send_len;
-		s += send_len;
-	}
+	if (len)
+		nc_send_packet(s, len);
 
 	output_recursion = 0;
 }
@@ -11,6 +11,7 @@
 #include <dm.h>
 #include <malloc.h>
 #include <net.h>
+#include <asm/eth.h>
 #include <asm/test.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -22,15 +23,26 @@ DECLARE_GLOBAL_DATA_PTR;
  * fake_host_ipaddr: IP address of mocked machine
  * recv_packet_buffer: buffer of the packet returned as received
  * recv_packet_length: length of the packet returned as received
+ * recv_queue: packets queued by sandbox_eth_queue_recv()
+ * recv_queue_length: length of each queued packet
+ * recv_queue_head: index of the next queued packet to return
+ * recv_queue_count: number of packets queued
+ * recv_queue_out: copy of the queued packet last returned
  */
 struct eth_sandbox_priv {
 	uchar fake_host_hwaddr[ARP_HLEN];
 	struct in_addr fake_host_ipaddr;
 	uchar *recv_packet_buffer;
 	int recv_packet_length;
+	uchar recv_queue[SANDBOX_ETH_QUEUE][PKTSIZE];
+	int recv_queue_length[SANDBOX_ETH_QUEUE];
+	int recv_queue_head;
+	int recv_queue_count;
+	uchar recv_queue_out[PKTSIZE];
 };
 
 static bool disabled[8] = {false};
+static sandbox_eth_tx_hand_f *tx_handler[8];
 static bool skip_timeout;
 
 /*
@@ -44,6 +56,44 @@ void sandbox_eth_disable_response(int index, bool disable)
 	disabled[index] = disable;
 }
 
+/*
+ * sandbox_eth_set_tx_handler()
+ *
+ * index - The alias index (also DM seq number)
+ * handler - Called with each sent packet, after the mock responses; NULL to
+ *	     remove it
+ */
+void sandbox_eth_set_tx_handler(int index, sandbox_eth_tx_hand_f *handler)
+{
+	tx_handler[index] = handler;
+}
+
+/*
+ * sandbox_eth_queue_recv()
+ *
+ * dev - Ethernet device
+ * packet - Packet to return as received, which is copied
+ * length - Length of the packet
+ */
+int sandbox_eth_queue_recv(struct udevice *dev, const void *packet,
+			   int length)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	int tail;
+
+	if (priv->recv_queue_count == SANDBOX_ETH_QUEUE)
+		return -ENOSPC;
+	if (length > PKTSIZE)
+		return -EINVAL;
+	tail = (priv->recv_queue_head + priv->recv_queue_count) %
+		SANDBOX_ETH_QUEUE;
+	memcpy(priv->recv_queue[tail], packet, length);
+	priv->recv_queue_length[tail] = length;
+	priv->recv_queue_count++;
+
+	return 0;
+}
+
 /*
  * sandbox_eth_skip_timeout()
  *
@@ -150,6 +200,10 @@ static int sb_eth_send(struct udevice *dev, void *packet, int length)
 		}
 	}
 
+	if (dev->seq >= 0 && dev->seq < ARRAY_SIZE(tx_handler) &&
+	    tx_handler[dev->seq])
+		return tx_handler[dev->seq](dev, packet, length);
+
 	return 0;
 }
 
@@ -171,6 +225,17 @@ static int sb_eth_recv(struct udevice *dev, int flags, uchar **packetp)
 		*packetp = priv->recv_packet_buffer;
 		return lcl_recv_packet_length;
 	}
+	if (priv->recv_queue_count) {
+		int head = priv->recv_queue_head;
+		int length = priv->recv_queue_length[head];
+
+		/* copy it out, since handling it may queue more packets */
+		memcpy(priv->recv_queue_out, priv->recv_queue[head], length);
+		priv->recv_queue_head = (head + 1) % SANDBOX_ETH_QUEUE;
+		priv->recv_queue_count--;
+		*packetp = priv->recv_queue_out;
+		return length;
+	}
 	return 0;
 }
 
@@ -90,11 +90,19 @@ void ubifs_ro_mode(struct ubifs_info *c, int err)
  * for more information.
  */
 
+#ifdef __UBOOT__
+/* Number of LEB reads, reported by ubifsload */
+unsigned long ubifs_leb_read_cnt;
+#endif
+
 int ubifs_leb_read(const struct ubifs_info *c, int lnum, void *buf, int offs,
 		   int len, int even_ebadmsg)
 {
 	int err;
 
+#ifdef __UBOOT__
+	ubifs_leb_read_cnt++;
+#endif
 	err = ubi_read(c->ubi, lnum, buf, offs, len);
 	/*
 	 * In case of %-EBADMSG print the error message only if the
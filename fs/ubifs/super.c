@@ -1398,6 +1398,10 @@ static int mount_ubifs(struct ubifs_info *c)
 	}
 #endif
 
+#ifdef __UBOOT__
+	/* There are no mount options in U-Boot */
+	c->bulk_read = IS_ENABLED(CONFIG_UBIFS_BULK_READ);
+#endif
 	if (c->bulk_read == 1)
 		bu_init(c);
 
@@ -839,6 +839,76 @@ error:
 	return err;
 }
 
+/*
+ * Read up to @count pages starting at @page using bulk-read: data nodes that
+ * sit back to back in one LEB are fetched with a single read. Returns the
+ * number of pages filled in, 0 if bulk-read cannot be used for @page (the
+ * caller then falls back to do_readpage()), or a negative error code.
+ */
+static int do_bulk_read(struct ubifs_info *c, struct inode *inode,
+			struct page *page, int count)
+{
+	struct bu_info *bu = &c->bu;
+	unsigned int block = page->index << UBIFS_BLOCKS_PER_PAGE_SHIFT;
+	void *addr = kmap(page);
+	int err, i, nn = 0, offs;
+
+	if (!c->bulk_read || count < 2)
+		return 0;
+
+	data_key_init(c, &bu->key, inode->i_ino, block);
+	bu->buf_len = c->max_bu_buf_len;
+	err = ubifs_tnc_get_bu_keys(c, bu);
+	if (err)
+		return err;
+
+	/* Holes at the start are left to do_readpage() */
+	if (bu->cnt < 2 || key_block(c, &bu->zbranch[0].key) != block)
+		return 0;
+
+	err = ubifs_tnc_bulk_read(c, bu);
+	if (err)
+		return err == -EAGAIN ? 0 : err;
+
+	offs = bu->zbranch[0].offs;
+	count = min(count, bu->blk_cnt);
+	for (i = 0; i < count; i++, block++, addr += UBIFS_BLOCK_SIZE) {
+		struct ubifs_data_node *dn;
+		int len, dlen, out_len;
+
+		if (nn >= bu->cnt ||
+		    key_block(c, &bu->zbranch[nn].key) != block) {
+			/* Not found, so it must be a hole */
+			memset(addr, 0, UBIFS_BLOCK_SIZE);
+			continue;
+		}
+
+		dn = bu->buf + (bu->zbranch[nn].offs - offs);
+		len = le32_to_cpu(dn->size);
+		if (len <= 0 || len > UBIFS_BLOCK_SIZE)
+			goto dump;
+
+		dlen = le32_to_cpu(dn->ch.len) - UBIFS_DATA_NODE_SZ;
+		out_len = UBIFS_BLOCK_SIZE;
+		err = ubifs_decompress(c, &dn->data, dlen, addr, &out_len,
+				       le16_to_cpu(dn->compr_type));
+		if (err || len != out_len)
+			goto dump;
+
+		if (len < UBIFS_BLOCK_SIZE)
+			memset(addr + len, 0, UBIFS_BLOCK_SIZE - len);
+		nn++;
+	}
+
+	return count;
+
+dump:
+	ubifs_err(c, "bad data node (block %u, inode %lu)",
+		  block, inode->i_ino);
+	ubifs_dump_node(c, bu->buf + (bu->zbranch[nn].offs - offs));
+	return -EINVAL;
+}
+
 int ubifs_read(const char *filename, void *buf, loff_t offset,
 	       loff_t size, loff_t *actread)
 {
@@ -898,6 +968,21 @@ int ubifs_read(const char *filename, void *buf, loff_t offset,
 	page.index = offset / PAGE_SIZE;
 	page.inode = inode;
 	for (i = 0; i < count; i++) {
+		/*
+		 * The last page is never bulk-read, as it must not be
+		 * written beyond the requested size.
+		 */
+		err = do_bulk_read(c, inode, &page, count - 1 - i);
+		if (err > 0) {
+			i += err - 1;
+			page.addr += err * PAGE_SIZE;
+			page.index += err;
+			err = 0;
+			continue;
+		}
+		if (err)
+			break;
+
 		/*
 		 * Make sure to not read beyond the requested size
 		 */
@@ -935,14 +1020,18 @@ void ubifs_close(void)
 int ubifs_load(char *filename, u32 addr, u32 size)
 {
 	loff_t actread;
+	unsigned long start, reads;
 	int err;
 
 	printf("Loading file '%s' to addr 0x%08x...\n", filename, addr);
 
+	start = get_timer(0);
+	reads = ubifs_leb_read_cnt;
 	err = ubifs_read(filename, (void *)(uintptr_t)addr, 0, size, &actread);
 	if (err == 0) {
 		setenv_hex("filesize", actread);
-		printf("Done\n");
+		printf("Done: %lld bytes in %lu ms, %lu flash reads\n",
+		       actread, get_timer(start), ubifs_leb_read_cnt - reads);
 	}
 
 	return err;
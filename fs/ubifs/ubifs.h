@@ -760,7 +760,11 @@ static inline ino_t parent_ino(struct dentry *dentry)
 #define BOTTOM_UP_HEIGHT 64
 
 /* Maximum number of data nodes to bulk-read */
+#ifdef CONFIG_UBIFS_BULK_READ_NODES
+#define UBIFS_MAX_BULK_READ CONFIG_UBIFS_BULK_READ_NODES
+#else
 #define UBIFS_MAX_BULK_READ 32
+#endif
 
 /*
  * Lockdep classes for UBIFS inode @ui_mutex.
@@ -2079,6 +2083,9 @@ extern struct ubifs_compressor *ubifs_compressors[UBIFS_COMPR_TYPES_CNT];
 
 /* io.c */
 void ubifs_ro_mode(struct ubifs_info *c, int err);
+#ifdef __UBOOT__
+extern unsigned long ubifs_leb_read_cnt;
+#endif
 int ubifs_leb_read(const struct ubifs_info *c, int lnum, void *buf, int offs,
 		   int len, int even_ebadmsg);
 int ubifs_leb_write(struct ubifs_info *c, int lnum, const void *buf, int offs,
@@ -92,6 +92,9 @@ typedef struct global_data {
 	unsigned long malloc_base;	/* base address of early malloc() */
 	unsigned long malloc_limit;	/* limit address */
 	unsigned long malloc_ptr;	/* current address */
+#ifdef CONFIG_MALLOC_TRACK
+	void *malloc_track;		/* callers of early malloc() */
+#endif
 #endif
 #ifdef CONFIG_PCI
 	struct pci_controller *hose;	/* PCI hose for early use */
@@ -432,6 +432,69 @@ static inline int bootstage_init(bool first)
 
 #endif /* ENABLE_BOOTSTAGE */
 
+/* Formats for bootstage_export() */
+enum bootstage_export_fmt {
+	BOOTSTAGE_EXPORT_CHROME,	/* Chrome trace event JSON */
+	BOOTSTAGE_EXPORT_FOLDED,	/* folded stacks, for flamegraph.pl */
+};
+
+#if defined(ENABLE_BOOTSTAGE) && defined(CONFIG_BOOTSTAGE_SPANS)
+/**
+ * bootstage_span_begin() - Start timing a span
+ *
+ * Spans nest: a span begun while another is open becomes its child. The
+ * name is copied, so it may be freed once this returns. Before
+ * relocation the copy is only made by bootstage_relocate(), so until then
+ * the name must stay valid.
+ *
+ * @name:	Name of the span, e.g. a device or command name
+ * @return span ID to pass to bootstage_span_end(), or -ve if the span
+ *	could not be recorded
+ */
+int bootstage_span_begin(const char *name);
+
+/**
+ * bootstage_span_end() - Finish timing a span
+ *
+ * Any children of the span which are still open are closed as well.
+ *
+ * @id:		Span ID returned by bootstage_span_begin(), -ve IDs are
+ *		ignored
+ * @return duration of the span in microseconds
+ */
+uint32_t bootstage_span_end(int id);
+
+/**
+ * bootstage_export() - Write the recorded spans to a buffer as text
+ *
+ * Spans which are still open are reported as ending now. The output is
+ * not nul-terminated if it exactly fills the buffer.
+ *
+ * @fmt:	Output format
+ * @buf:	Buffer to write to
+ * @size:	Size of buffer
+ * @return number of bytes needed for the output, which is more than @size
+ *	if it was truncated, or -ve on error
+ */
+int bootstage_export(enum bootstage_export_fmt fmt, char *buf, int size);
+#else
+static inline int bootstage_span_begin(const char *name)
+{
+	return -1;
+}
+
+static inline uint32_t bootstage_span_end(int id)
+{
+	return 0;
+}
+
+static inline int bootstage_export(enum bootstage_export_fmt fmt, char *buf,
+				   int size)
+{
+	return -1;
+}
+#endif
+
 /* Helper macro for adding a bootstage to a line of code */
 #define BOOTSTAGE_MARKER()	\
 		bootstage_mark_code(__FILE__, __func__, __LINE__)
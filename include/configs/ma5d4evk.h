@@ -58,7 +58,6 @@
 #define CONFIG_NET_RETRY_COUNT		20
 #define CONFIG_MACB_SEARCH_PHY
 #define CONFIG_ARP_TIMEOUT		200UL
-#define CONFIG_IP_DEFRAG
 #endif
 
 /*
@@ -25,6 +25,7 @@
 #endif
 
 #define CONFIG_LMB
+#define CONFIG_BCH
 #define CONFIG_ANDROID_BOOT_IMAGE
 
 #define CONFIG_CMD_PCI
@@ -94,7 +95,6 @@
 #define CONFIG_BOOTP_DNS2
 #define CONFIG_BOOTP_SEND_HOSTNAME
 #define CONFIG_BOOTP_SERVERIP
-#define CONFIG_IP_DEFRAG
 
 #define CONFIG_CMD_SANDBOX
 
@@ -109,9 +109,6 @@
 /** Enable ThunderX SMI MDIO driver */
 #define CONFIG_THUNDERX_SMI
 
-/** Enable ThunderX VNIC driver support */
-#define CONFIG_THUNDERX_VNIC
-
 /** Generate a random MAC address if it is not already defined */
 #define CONFIG_RANDOM_MACADDR
 
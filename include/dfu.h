@@ -85,6 +85,12 @@ struct sf_internal_data {
 #ifndef CONFIG_SYS_DFU_DATA_BUF_SIZE
 #define CONFIG_SYS_DFU_DATA_BUF_SIZE		(1024*1024*8)	/* 8 MiB */
 #endif
+#ifndef CONFIG_DFU_BUF_COUNT
+#define CONFIG_DFU_BUF_COUNT		1
+#endif
+#ifndef CONFIG_DFU_WRITE_SLICE
+#define CONFIG_DFU_WRITE_SLICE		(1024*1024)	/* 1 MiB */
+#endif
 #ifndef CONFIG_SYS_DFU_MAX_FILE_SIZE
 #define CONFIG_SYS_DFU_MAX_FILE_SIZE CONFIG_SYS_DFU_DATA_BUF_SIZE
 #endif
@@ -102,6 +108,7 @@ struct dfu_entity {
 	enum dfu_device_type    dev_type;
 	enum dfu_layout         layout;
 	unsigned long           max_buf_size;
+	unsigned long		write_unit;	/* queued writes are multiples */
 
 	union {
 		struct mmc_internal_data mmc;
@@ -137,6 +144,11 @@ struct dfu_entity {
 
 	u32 bad_skip;	/* for nand use */
 
+	/* statistics of the last transfer */
+	ulong stat_start;
+	ulong stat_time;	/* in ms */
+	u64 stat_bytes;
+
 	unsigned int inited:1;
 };
 
@@ -159,6 +171,27 @@ unsigned char *dfu_free_buf(void);
 unsigned long dfu_get_buf_size(void);
 bool dfu_usb_get_reset(void);
 
+/**
+ * dfu_enable_write_queue - queue full buffers instead of writing them
+ *
+ * With CONFIG_DFU_BUF_COUNT > 1, dfu_write() queues full buffers and
+ * continues with the next free one. The queued data is written to the
+ * medium by dfu_poll(), which the caller must then call regularly.
+ *
+ * @param enable - true to enable queueing, false for synchronous writes
+ */
+void dfu_enable_write_queue(bool enable);
+
+/**
+ * dfu_poll - write the next slice of queued data to the medium
+ *
+ * At most CONFIG_DFU_WRITE_SLICE bytes are written per call, so that USB
+ * requests can be serviced in between.
+ *
+ * @return - 0 on success, other value on write failure
+ */
+int dfu_poll(void);
+
 int dfu_read(struct dfu_entity *de, void *buf, int size, int blk_seq_num);
 int dfu_write(struct dfu_entity *de, void *buf, int size, int blk_seq_num);
 int dfu_flush(struct dfu_entity *de, void *buf, int size, int blk_seq_num);
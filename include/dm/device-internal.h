@@ -14,6 +14,7 @@
 #include <dm/ofnode.h>
 
 struct device_node;
+struct uclass;
 struct udevice;
 
 /**
@@ -127,6 +128,41 @@ void device_free(struct udevice *dev);
 static inline void device_free(struct udevice *dev) {}
 #endif
 
+/* Alignment of each structure within a batched allocation */
+#define DM_BATCH_ALIGN		16
+
+/**
+ * device_pdata_size() - Work out the memory which binding a device needs
+ *
+ * This covers the struct udevice and the platform data which driver model
+ * allocates for it, as selected by the DM_FLAG_ALLOC_..._PDATA flags. With
+ * DM_FLAG_BATCH_PDATA they are all allocated in a single block, in that
+ * order.
+ *
+ * @drv:	Driver of the device
+ * @uc:		Uclass of the device
+ * @parent:	Parent device, or NULL if none
+ * @flags:	Device flags
+ * @sizes:	Returns the sizes of the platdata, uclass_platdata and
+ *		parent_platdata, 0 for each which is not allocated
+ * @return total size of a batched block
+ */
+int device_pdata_size(const struct driver *drv, struct uclass *uc,
+		      struct udevice *parent, uint flags, int sizes[3]);
+
+/**
+ * device_priv_size() - Work out the memory which probing a device needs
+ *
+ * With DM_FLAG_BATCH_PRIV the priv, uclass_priv and parent_priv data are
+ * allocated in a single block, in that order.
+ *
+ * @dev:	Device to check
+ * @sizes:	Returns the sizes of the priv, uclass_priv and parent_priv
+ *		data, 0 for each which is not needed
+ * @return total size of a batched block
+ */
+int device_priv_size(struct udevice *dev, int sizes[3]);
+
 /**
  * simple_bus_translate() - translate a bus address to a system address
  *
@@ -61,6 +61,12 @@ struct driver_info;
  */
 #define DM_FLAG_OS_PREPARE		(1 << 10)
 
+/* Device and its platdata were allocated together, see device_pdata_size() */
+#define DM_FLAG_BATCH_PDATA		(1 << 11)
+
+/* Private data was allocated in one block, see device_priv_size() */
+#define DM_FLAG_BATCH_PRIV		(1 << 12)
+
 /*
  * One or multiple of these flags are passed to device_remove() so that
  * a selective device removal as specified by the remove-stage and the
@@ -536,6 +536,38 @@ struct efi_simple_network_mode {
 #define EFI_SIMPLE_NETWORK_RECEIVE_PROMISCUOUS           0x08,
 #define EFI_SIMPLE_NETWORK_RECEIVE_PROMISCUOUS_MULTICAST 0x10,
 
+#define EFI_SIMPLE_NETWORK_RECEIVE_INTERRUPT		0x01
+#define EFI_SIMPLE_NETWORK_TRANSMIT_INTERRUPT		0x02
+
+struct efi_network_statistics {
+	u64 rx_total_frames;
+	u64 rx_good_frames;
+	u64 rx_undersize_frames;
+	u64 rx_oversize_frames;
+	u64 rx_dropped_frames;
+	u64 rx_unicast_frames;
+	u64 rx_broadcast_frames;
+	u64 rx_multicast_frames;
+	u64 rx_crc_error_frames;
+	u64 rx_total_bytes;
+	u64 tx_total_frames;
+	u64 tx_good_frames;
+	u64 tx_undersize_frames;
+	u64 tx_oversize_frames;
+	u64 tx_dropped_frames;
+	u64 tx_unicast_frames;
+	u64 tx_broadcast_frames;
+	u64 tx_multicast_frames;
+	u64 tx_crc_error_frames;
+	u64 tx_total_bytes;
+	u64 collisions;
+	u64 unsupported_protocol;
+	u64 rx_duplicated_frames;
+	u64 rx_decrypt_error_frames;
+	u64 tx_error_frames;
+	u64 tx_retry_frames;
+};
+
 struct efi_simple_network
 {
 	u64 revision;
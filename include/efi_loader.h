@@ -131,6 +131,8 @@ extern struct list_head efi_obj_list;
 int efi_console_register(void);
 /* Called by bootefi to make all disk storage accessible as EFI objects */
 int efi_disk_register(void);
+/* Called by ExitBootServices to report disk read-ahead statistics */
+void efi_disk_report_cache(void);
 /* Called by bootefi to make GOP (graphical) interface available */
 int efi_gop_register(void);
 /* Called by bootefi to make the network interface available */
@@ -178,6 +180,15 @@ efi_status_t efi_allocate_pool(int pool_type, unsigned long size,
 			       void **buffer);
 /* EFI pool memory free function. */
 efi_status_t efi_free_pool(void *buffer);
+
+/* Counters kept by the pool allocator */
+struct efi_pool_stats {
+	unsigned long small_allocs;	/* served from a size class slab */
+	unsigned long page_allocs;	/* too large, served from pages */
+	unsigned long frees;
+	unsigned long arenas;		/* slab arenas added to the map */
+};
+extern struct efi_pool_stats efi_pool_stats;
 /* Returns the EFI memory map */
 efi_status_t efi_get_memory_map(unsigned long *memory_map_size,
 				struct efi_mem_desc *memory_map,
@@ -23,6 +23,16 @@ struct sparse_storage {
 	lbaint_t	(*reserve)(struct sparse_storage *info,
 				 lbaint_t blk,
 				 lbaint_t blkcnt);
+
+	/*
+	 * Optional: erase a range so that it reads back as zeroes. Only
+	 * called for ranges aligned to erase_blks; set to NULL if the
+	 * device does not guarantee zeroes after an erase.
+	 */
+	lbaint_t	(*erase)(struct sparse_storage *info,
+				 lbaint_t blk,
+				 lbaint_t blkcnt);
+	lbaint_t	erase_blks;
 };
 
 static inline int is_sparse_image(void *buf)
@@ -11,6 +11,7 @@
  * SPDX-License-Identifier:	GPL-2.0+
  */
 
+/* Number of regions held before more space is taken from malloc() */
 #define MAX_LMB_REGIONS 8
 
 struct lmb_property {
@@ -18,10 +19,17 @@ struct lmb_property {
 	phys_size_t size;
 };
 
+/*
+ * The regions are sorted by base address and do not overlap or touch, so
+ * they can be looked up with a binary search. @region points to @initial
+ * until more than MAX_LMB_REGIONS + 1 are needed.
+ */
 struct lmb_region {
 	unsigned long cnt;
+	unsigned long max;
 	phys_size_t size;
-	struct lmb_property region[MAX_LMB_REGIONS+1];
+	struct lmb_property *region;
+	struct lmb_property initial[MAX_LMB_REGIONS+1];
 };
 
 struct lmb {
@@ -32,6 +40,7 @@ struct lmb {
 extern struct lmb lmb;
 
 extern void lmb_init(struct lmb *lmb);
+extern void lmb_release(struct lmb *lmb);
 extern long lmb_add(struct lmb *lmb, phys_addr_t base, phys_size_t size);
 extern long lmb_reserve(struct lmb *lmb, phys_addr_t base, phys_size_t size);
 extern phys_addr_t lmb_alloc(struct lmb *lmb, phys_size_t size, ulong align);
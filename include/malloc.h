@@ -893,11 +893,20 @@ void *realloc_simple(void *ptr, size_t size);
 # define mALLINFo	dlmallinfo
 # define mALLOPt		dlmallopt
 # else /* USE_DL_PREFIX */
+# if CONFIG_IS_ENABLED(MALLOC_TRACK)
+/* These are wrapped by common/malloc_track.c to record the caller */
+# define cALLOc		dlcalloc
+# define fREe		dlfree
+# define mALLOc		dlmalloc
+# define mEMALIGn	dlmemalign
+# define rEALLOc		dlrealloc
+# else
 # define cALLOc		calloc
 # define fREe		free
 # define mALLOc		malloc
 # define mEMALIGn	memalign
 # define rEALLOc		realloc
+# endif
 # define vALLOc		valloc
 # define pvALLOc		pvalloc
 # define mALLINFo	mallinfo
@@ -930,6 +939,13 @@ size_t  malloc_usable_size(Void_t*);
 void    malloc_stats(void);
 int     mALLOPt(int, int);
 struct mallinfo mALLINFo(void);
+# if CONFIG_IS_ENABLED(MALLOC_TRACK) && !defined(USE_DL_PREFIX)
+void *malloc(size_t);
+void free(void *);
+void *realloc(void *, size_t);
+void *memalign(size_t, size_t);
+void *calloc(size_t, size_t);
+# endif
 # else
 Void_t* mALLOc();
 void    fREe();
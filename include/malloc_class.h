@@ -0,0 +1,105 @@
+/*
+ * Size-class allocator for small, frequent allocations
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __MALLOC_CLASS_H
+#define __MALLOC_CLASS_H
+
+#include <malloc.h>
+
+/* Size classes, in bytes; larger requests go straight to malloc() */
+#define MALLOC_CLASS_SIZES	{ 16, 32, 64, 128, 256, 512 }
+#define MALLOC_CLASS_COUNT	6
+#define MALLOC_CLASS_MAX	512
+
+/**
+ * struct malloc_class_stats - Statistics for one size class
+ *
+ * @size:	Object size of the class
+ * @allocs:	Number of objects allocated
+ * @frees:	Number of objects freed
+ * @slabs:	Number of slabs currently held by the class
+ */
+struct malloc_class_stats {
+	uint size;
+	ulong allocs;
+	ulong frees;
+	uint slabs;
+};
+
+#if CONFIG_IS_ENABLED(MALLOC_CLASS)
+/**
+ * malloc_class_zalloc() - Allocate zeroed memory
+ *
+ * Once the full malloc() is available, requests of up to MALLOC_CLASS_MAX
+ * bytes are served from slabs of objects of the same size class. This
+ * avoids the per-chunk overhead and bin search of dlmalloc. Before that,
+ * and for larger requests, this is the same as calloc().
+ *
+ * The memory is aligned to 16 bytes if served from a slab, which is not
+ * enough for DMA.
+ *
+ * @size:	Number of bytes to allocate
+ * @return pointer to memory, or NULL if out of memory
+ */
+void *malloc_class_zalloc(size_t size);
+
+/**
+ * malloc_class_free() - Free memory from malloc_class_zalloc()
+ *
+ * @ptr:	Pointer to memory, or NULL to do nothing
+ * @size:	Size which was passed to malloc_class_zalloc()
+ */
+void malloc_class_free(void *ptr, size_t size);
+
+/**
+ * malloc_class_set_enabled() - Enable or disable the size classes
+ *
+ * When disabled all requests go to calloc(), and driver model allocates
+ * each of a device's private structures separately. This is only for
+ * comparing the two. Memory can be freed whichever way it was allocated.
+ *
+ * @enabled:	true to use the size classes (the default)
+ */
+void malloc_class_set_enabled(bool enabled);
+
+/**
+ * malloc_class_enabled() - Check whether the size classes are in use
+ *
+ * @return true if enabled
+ */
+bool malloc_class_enabled(void);
+
+/**
+ * malloc_class_get_stats() - Get allocation statistics
+ *
+ * @stats:	Returns statistics for each of the MALLOC_CLASS_COUNT classes
+ * @return number of calls made to malloc() (for slabs, large requests and
+ *	requests made before relocation or while disabled)
+ */
+ulong malloc_class_get_stats(struct malloc_class_stats *stats);
+
+/**
+ * malloc_class_report() - Print allocation statistics
+ */
+void malloc_class_report(void);
+#else
+static inline void *malloc_class_zalloc(size_t size)
+{
+	return calloc(1, size);
+}
+
+static inline void malloc_class_free(void *ptr, size_t size)
+{
+	free(ptr);
+}
+
+static inline bool malloc_class_enabled(void)
+{
+	return false;
+}
+#endif
+
+#endif /* __MALLOC_CLASS_H */
@@ -0,0 +1,123 @@
+/*
+ * Recording of malloc() use by each caller
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __MALLOC_TRACK_H
+#define __MALLOC_TRACK_H
+
+/* Boot phases for which heap use is recorded separately */
+enum malloc_track_phase {
+	MALLOC_PHASE_F,		/* before relocation, from malloc_simple() */
+	MALLOC_PHASE_INIT,	/* after relocation, until the command line */
+	MALLOC_PHASE_CLI,	/* running commands */
+	MALLOC_PHASE_HANDOFF,	/* after handing off to the OS or EFI app */
+
+	MALLOC_PHASE_COUNT,
+};
+
+/**
+ * struct malloc_track_site - Heap use by one caller of malloc()
+ *
+ * @caller:	Return address of the call, or 0 for callers which did not fit
+ *		in the table
+ * @allocs:	Number of allocations made
+ * @frees:	Number of those which have been freed
+ * @bytes:	Total number of bytes requested
+ * @live:	Number of bytes currently allocated
+ * @peak:	Largest value @live has had
+ * @lifetime_ms: Total lifetime of the allocations which have been freed
+ */
+struct malloc_track_site {
+	ulong caller;
+	ulong allocs;
+	ulong frees;
+	ulong bytes;
+	ulong live;
+	ulong peak;
+	ulong lifetime_ms;
+};
+
+/**
+ * struct malloc_track_usage - Heap use during a boot phase
+ *
+ * @allocs:	Number of allocations made in the phase
+ * @bytes:	Total number of bytes requested in the phase
+ * @start:	Bytes allocated when the phase started
+ * @peak:	Most bytes allocated at once during the phase
+ */
+struct malloc_track_usage {
+	ulong allocs;
+	ulong bytes;
+	ulong start;
+	ulong peak;
+};
+
+#if CONFIG_IS_ENABLED(MALLOC_TRACK)
+/**
+ * malloc_track_init() - Start tracking the full malloc()
+ *
+ * This is called once the malloc() pool is set up after relocation. It
+ * allocates the tracking tables and takes over the callers recorded before
+ * relocation.
+ *
+ * @return 0 if OK, -ENOMEM if there is no space for the tables
+ */
+int malloc_track_init(void);
+
+/**
+ * malloc_track_set_phase() - Move on to a new boot phase
+ *
+ * @phase:	Phase to record further allocations against
+ */
+void malloc_track_set_phase(enum malloc_track_phase phase);
+
+/**
+ * malloc_track_get_site() - Find which caller allocated some memory
+ *
+ * @ptr:	Pointer returned by malloc(), calloc(), realloc() or memalign()
+ * @site:	Returns the statistics of the caller which allocated @ptr
+ * @return 0 if OK, -ENOENT if @ptr is not a tracked allocation
+ */
+int malloc_track_get_site(const void *ptr, struct malloc_track_site *site);
+
+/**
+ * malloc_track_get_usage() - Get the heap use during a boot phase
+ *
+ * @phase:	Phase to check
+ * @usage:	Returns the heap use
+ */
+void malloc_track_get_usage(enum malloc_track_phase phase,
+			    struct malloc_track_usage *usage);
+
+/**
+ * malloc_track_print_top() - Print the callers which allocated most memory
+ *
+ * @count:	Maximum number of callers to print
+ */
+void malloc_track_print_top(uint count);
+
+/**
+ * malloc_track_print_live() - Print allocations which have not been freed
+ *
+ * After boot handoff, this shows what was leaked to the OS.
+ */
+void malloc_track_print_live(void);
+
+/**
+ * malloc_track_print_phases() - Print the heap use in each boot phase
+ */
+void malloc_track_print_phases(void);
+#else
+static inline int malloc_track_init(void)
+{
+	return 0;
+}
+
+static inline void malloc_track_set_phase(enum malloc_track_phase phase)
+{
+}
+#endif
+
+#endif /* __MALLOC_TRACK_H */
@@ -83,6 +83,28 @@ enum eth_state_t {
 	ETH_STATE_ACTIVE
 };
 
+/* Checksum work done by the Ethernet hardware instead of the network stack */
+enum eth_offload_flags {
+	/*
+	 * Received frames with a bad IPv4 header or UDP checksum are dropped
+	 * by the driver, so only reassembled datagrams need checking
+	 */
+	ETH_OFFLOAD_RX_CSUM		= 1 << 0,
+	/* The hardware fills in the IPv4 header checksum of sent frames */
+	ETH_OFFLOAD_TX_IP_CSUM		= 1 << 1,
+};
+
+/**
+ * struct eth_pkt - One frame of a batch passed to eth_send_batch()
+ *
+ * @packet: The frame, starting with the Ethernet header
+ * @length: Length of the frame in bytes
+ */
+struct eth_pkt {
+	void *packet;
+	int length;
+};
+
 #ifdef CONFIG_DM_ETH
 /**
  * struct eth_pdata - Platform data for Ethernet MAC controllers
@@ -91,12 +113,14 @@ enum eth_state_t {
  * @enetaddr: The Ethernet MAC address that is loaded from EEPROM or env
  * @phy_interface: PHY interface to use - see PHY_INTERFACE_MODE_...
  * @max_speed: Maximum speed of Ethernet connection supported by MAC
+ * @offload: Checksum work done by the hardware - see enum eth_offload_flags
  */
 struct eth_pdata {
 	phys_addr_t iobase;
 	unsigned char enetaddr[ARP_HLEN];
 	int phy_interface;
 	int max_speed;
+	int offload;
 };
 
 enum eth_recv_flags {
@@ -112,6 +136,10 @@ enum eth_recv_flags {
  *
  * start: Prepare the hardware to send and receive packets
  * send: Send the bytes passed in "packet" as a packet on the wire
+ * send_batch: Send "count" packets, returning how many were queued or an
+ *	       error. As with send, the packets may be reused once this
+ *	       returns, but the driver may hand the whole batch to the hardware
+ *	       at once and reclaim the sent buffers later - optional
  * recv: Check if the hardware received a packet. If so, set the pointer to the
  *	 packet buffer in the packetp parameter. If not, return an error or 0 to
  *	 indicate that the hardware receive FIFO is empty. If 0 is returned, the
@@ -136,6 +164,7 @@ enum eth_recv_flags {
 struct eth_ops {
 	int (*start)(struct udevice *dev);
 	int (*send)(struct udevice *dev, void *packet, int length);
+	int (*send_batch)(struct udevice *dev, struct eth_pkt *pkts, int count);
 	int (*recv)(struct udevice *dev, int flags, uchar **packetp);
 	int (*free_pkt)(struct udevice *dev, uchar *packet, int length);
 	void (*stop)(struct udevice *dev);
@@ -149,6 +178,7 @@ struct eth_ops {
 #define eth_get_ops(dev) ((struct eth_ops *)(dev)->driver->ops)
 
 struct udevice *eth_get_dev(void); /* get the current device */
+int eth_get_offload(void); /* get the current device's eth_offload_flags */
 /*
  * The devname can be either an exact name given by the driver or device tree
  * or it can be an alias of the form "eth%d"
@@ -172,6 +202,8 @@ struct eth_device {
 
 	int (*init)(struct eth_device *, bd_t *);
 	int (*send)(struct eth_device *, void *packet, int length);
+	/* optional, see send_batch in struct eth_ops */
+	int (*send_batch)(struct eth_device *, struct eth_pkt *pkts, int count);
 	int (*recv)(struct eth_device *);
 	void (*halt)(struct eth_device *);
 #ifdef CONFIG_MCAST_TFTP
@@ -180,6 +212,7 @@ struct eth_device {
 	int (*write_hwaddr)(struct eth_device *);
 	struct eth_device *next;
 	int index;
+	int offload;	/* enum eth_offload_flags */
 	void *priv;
 };
 
@@ -203,6 +236,14 @@ static inline unsigned char *eth_get_ethaddr(void)
 	return NULL;
 }
 
+/* get the current device's eth_offload_flags */
+static inline int eth_get_offload(void)
+{
+	if (eth_current)
+		return eth_current->offload;
+	return 0;
+}
+
 /* Used only when NetConsole is enabled */
 int eth_is_active(struct eth_device *dev); /* Test device for active state */
 /* Set active state */
@@ -281,6 +322,20 @@ int eth_getenv_enetaddr_by_index(const char *base_name, int index,
 int eth_init(void);			/* Initialize the device */
 int eth_send(void *packet, int length);	   /* Send a packet */
 
+/**
+ * eth_send_batch() - Send several packets on the current device
+ *
+ * Drivers which support it queue the whole batch before telling the
+ * hardware, which saves a doorbell write and a wait for each packet. Others
+ * are sent one at a time. The packets may be reused once this returns.
+ *
+ * @pkts:	Packets to send, in order
+ * @count:	Number of packets
+ * @return number of packets sent, which is less than @count if the device
+ * ran out of room, or -ve on error
+ */
+int eth_send_batch(struct eth_pkt *pkts, int count);
+
 #if defined(CONFIG_API) || defined(CONFIG_EFI_LOADER)
 int eth_receive(void *packet, int length); /* Receive a packet*/
 extern void (*push_packet)(void *packet, int length);
@@ -353,6 +408,7 @@ struct vlan_ethernet_hdr {
 #define PROT_PPP_SES	0x8864		/* PPPoE session messages	*/
 
 #define IPPROTO_ICMP	 1	/* Internet Control Message Protocol	*/
+#define IPPROTO_TCP	 6	/* Transmission Control Protocol	*/
 #define IPPROTO_UDP	17	/* User Datagram Protocol		*/
 
 /*
@@ -538,7 +594,7 @@ extern int		net_restart_wrap;	/* Tried all network devices */
 
 enum proto_t {
 	BOOTP, RARP, ARP, TFTPGET, DHCP, PING, DNS, NFS, CDP, NETCONS, SNTP,
-	TFTPSRV, TFTPPUT, LINKLOCAL
+	TFTPSRV, TFTPPUT, LINKLOCAL, WGET
 };
 
 extern char	net_boot_file_name[1024];/* Boot File name */
@@ -588,6 +644,24 @@ int net_loop(enum proto_t);
 /* Load failed.	 Start again. */
 int net_start_again(void);
 
+/**
+ * struct net_defrag_stats - IP reassembly counters for the current net_loop()
+ *
+ * @reassembled:	Datagrams completed
+ * @dropped:	Fragments dropped as duplicates or out of range
+ * @timeouts:	Datagrams abandoned because their fragments stopped arriving
+ * @evictions:	Datagrams abandoned to make room for a newer one
+ */
+struct net_defrag_stats {
+	ulong reassembled;
+	ulong dropped;
+	ulong timeouts;
+	ulong evictions;
+};
+
+/* Get the IP reassembly counters (CONFIG_IP_DEFRAG only) */
+void net_defrag_get_stats(struct net_defrag_stats *stats);
+
 /* Get size of the ethernet header when we send */
 int net_eth_hdr_size(void);
 
@@ -609,6 +683,20 @@ void net_set_udp_header(uchar *pkt, struct in_addr dest, int dport,
  */
 unsigned compute_ip_checksum(const void *addr, unsigned nbytes);
 
+/**
+ * compute_udp_checksum() - Compute the checksum of a UDP datagram
+ *
+ * This covers the IPv4 pseudo-header as well as the UDP header and data.
+ * For a received datagram, including its checksum field, the result is 0
+ * (or 0xffff) if the checksum is correct. The protocol in the pseudo-header
+ * is taken from ip_p, so this works for TCP segments too.
+ *
+ * @ip:		IP and UDP header, followed by the data
+ * @udp_len:	Length of the UDP (or TCP) header and data in bytes
+ * @return 16-bit UDP checksum
+ */
+unsigned compute_udp_checksum(const struct ip_udp_hdr *ip, unsigned udp_len);
+
 /**
  * add_ip_checksums() - add two IP checksums
  *
@@ -673,6 +761,45 @@ static inline void net_send_packet(uchar *pkt, int len)
 int net_send_udp_packet(uchar *ether, struct in_addr dest, int dport,
 			int sport, int payload_len);
 
+/*
+ * Transmit the IP packet in "net_tx_packet", after the Ethernet header,
+ * performing ARP request if needed (ether will be populated)
+ *
+ * @param ether Raw packet buffer
+ * @param dest IP address to send the packet to
+ * @param len Length of the IP packet, including its header
+ */
+int net_send_ip_packet(uchar *ether, struct in_addr dest, int len);
+
+/**
+ * arp_cache_lookup() - Find the MAC address to send to an IP address
+ *
+ * The ARP cache holds addresses resolved on the current network device by
+ * earlier commands. For an address off the local subnet this finds the
+ * gateway's MAC address.
+ *
+ * @ip:		IP address to send to
+ * @ethaddr:	Set to the MAC address if found
+ * @return 0 if found, -ENOENT if the address must be resolved with ARP
+ */
+int arp_cache_lookup(struct in_addr ip, uchar *ethaddr);
+
+/**
+ * arp_prefetch() - Resolve the route to an IP address in the background
+ *
+ * An ARP request is sent, without waiting for the reply, unless the address
+ * (or the gateway used to reach it) is already in the ARP cache.
+ *
+ * @ip:		IP address that will be sent to
+ */
+void arp_prefetch(struct in_addr ip);
+
+/* Empty the ARP cache */
+void arp_cache_flush(void);
+
+/* Print the addresses in the ARP cache */
+void arp_cache_show(void);
+
 /* Processes a received packet */
 void net_process_received_packet(uchar *in_packet, int len);
 
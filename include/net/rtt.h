@@ -0,0 +1,80 @@
+/*
+ * Round trip time estimation for retransmission over UDP
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __RTT_H__
+#define __RTT_H__
+
+/**
+ * struct net_rtt - Round trip time estimate for one transfer
+ *
+ * Following RFC 6298, the retransmit timeout is the smoothed round trip
+ * time plus four times its mean deviation. It is doubled after each timeout
+ * until a reply to a packet which was only sent once gives a new sample.
+ *
+ * @srtt:	Smoothed round trip time in us, 0 before the first sample
+ * @rttvar:	Mean deviation of the round trip time in us
+ * @rto:	Retransmit timeout in ms
+ * @rto_max:	Largest retransmit timeout in ms
+ * @samples:	Number of round trip times measured
+ * @retransmits: Number of timeouts
+ */
+struct net_rtt {
+	ulong srtt;
+	ulong rttvar;
+	ulong rto;
+	ulong rto_max;
+	ulong samples;
+	ulong retransmits;
+};
+
+/**
+ * net_rtt_init() - Start estimating for a new transfer
+ *
+ * @rtt:	Estimate to set up
+ * @rto:	Retransmit timeout in ms until the first sample
+ * @rto_max:	Largest retransmit timeout in ms
+ */
+void net_rtt_init(struct net_rtt *rtt, ulong rto, ulong rto_max);
+
+/**
+ * net_rtt_sample() - Add a measured round trip time
+ *
+ * Only replies to packets which were sent once may be measured, since the
+ * reply to a retransmitted packet may be for either copy (Karn's algorithm).
+ *
+ * @rtt:	Estimate to update
+ * @us:		Time from sending a packet to its reply, in us
+ */
+void net_rtt_sample(struct net_rtt *rtt, ulong us);
+
+/**
+ * net_rtt_backoff() - Record a timeout, doubling the retransmit timeout
+ *
+ * @rtt:	Estimate to update
+ */
+void net_rtt_backoff(struct net_rtt *rtt);
+
+/**
+ * net_rtt_timeout() - Get the time to wait for a reply
+ *
+ * @rtt:	Estimate to use
+ * @return retransmit timeout in ms, for net_set_timeout_handler()
+ */
+static inline ulong net_rtt_timeout(struct net_rtt *rtt)
+{
+	return rtt->rto;
+}
+
+/**
+ * net_rtt_report() - Print the round trip time and retransmits
+ *
+ * This continues a transfer's summary, on a line of its own.
+ *
+ * @rtt:	Estimate to print
+ */
+void net_rtt_report(struct net_rtt *rtt);
+
+#endif /* __RTT_H__ */
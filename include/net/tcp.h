@@ -0,0 +1,145 @@
+/*
+ * Minimal TCP client, for downloading over high-latency links
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __TCP_H__
+#define __TCP_H__
+
+/*
+ * TCP header. This follows the IP header, which is 2-byte aligned in the
+ * packet, so the 32-bit fields are accessed with net_read_u32() and
+ * net_copy_u32().
+ */
+struct tcp_hdr {
+	u16	tcp_src;	/* source port				*/
+	u16	tcp_dst;	/* destination port			*/
+	u32	tcp_seq;	/* sequence number			*/
+	u32	tcp_ack;	/* acknowledgement number		*/
+	u8	tcp_hlen;	/* header length in words, top 4 bits	*/
+	u8	tcp_flags;	/* TCP_FIN etc.				*/
+	u16	tcp_win;	/* receive window			*/
+	u16	tcp_xsum;	/* checksum				*/
+	u16	tcp_urg;	/* urgent pointer			*/
+};
+
+#define TCP_HDR_SIZE		(sizeof(struct tcp_hdr))
+#define IP_TCP_HDR_SIZE		(IP_HDR_SIZE + TCP_HDR_SIZE)
+
+#define TCP_FIN		0x01
+#define TCP_SYN		0x02
+#define TCP_RST		0x04
+#define TCP_PSH		0x08
+#define TCP_ACK		0x10
+
+/* Options sent with SYN */
+#define TCP_OPT_END	0
+#define TCP_OPT_NOP	1
+#define TCP_OPT_MSS	2
+#define TCP_OPT_WSCALE	3
+
+/* Largest segment we accept, for a 1500-byte MTU */
+#define TCP_MSS		(1500 - IP_TCP_HDR_SIZE)
+
+enum tcp_event {
+	TCP_EVENT_CONNECTED,	/* the connection is open */
+	TCP_EVENT_DATA,		/* more of the stream has arrived in order */
+	TCP_EVENT_CLOSED,	/* the peer closed after sending everything */
+	TCP_EVENT_RESET,	/* the peer reset the connection */
+	TCP_EVENT_TIMEOUT,	/* the peer stopped responding */
+};
+
+/**
+ * tcp_rx_f() - Accept received data
+ *
+ * Data may arrive out of order, in which case @offset is beyond the data
+ * received so far. It is stored where it belongs and the gap is filled in
+ * later.
+ *
+ * @data:	Data received
+ * @offset:	Offset of @data in the stream
+ * @len:	Number of bytes
+ * @return 0 if the data was stored, -ve to drop it and have it resent
+ */
+typedef int tcp_rx_f(const uchar *data, u32 offset, unsigned len);
+
+/**
+ * tcp_event_f() - Handle a change in the connection
+ *
+ * @event:	What happened
+ * @stream_len:	Number of bytes of the stream received in order
+ */
+typedef void tcp_event_f(enum tcp_event event, u32 stream_len);
+
+/**
+ * struct tcp_stats - Counters for a connection
+ *
+ * @segments:	Segments received with data
+ * @out_of_order: Segments received beyond a gap
+ * @dropped:	Segments dropped, not fitting the window or the gap table
+ * @dup_acks:	Duplicate ACKs sent to prompt a fast retransmit
+ * @retransmits: Segments we sent again after a timeout
+ * @fast_retransmits: Segments we sent again after three duplicate ACKs
+ */
+struct tcp_stats {
+	ulong segments;
+	ulong out_of_order;
+	ulong dropped;
+	ulong dup_acks;
+	ulong retransmits;
+	ulong fast_retransmits;
+};
+
+/**
+ * tcp_connect() - Open a connection
+ *
+ * The connection timers use net_set_timeout_handler(), so the caller must
+ * not use that while the connection is open.
+ *
+ * @dest:	Server address
+ * @dport:	Server port
+ * @rx:		Called with each part of the stream received
+ * @event:	Called when the connection changes
+ */
+void tcp_connect(struct in_addr dest, int dport, tcp_rx_f *rx,
+		 tcp_event_f *event);
+
+/**
+ * tcp_send() - Send data on an open connection
+ *
+ * The data is sent in segments of up to the peer's MSS and resent until
+ * acknowledged, so it must stay valid until the connection is closed.
+ * Only one buffer can be outstanding.
+ *
+ * @data:	Data to send
+ * @len:	Number of bytes
+ * @return 0 if OK, -EBUSY if earlier data is still unacknowledged,
+ *	-ENOTCONN if the connection is not open
+ */
+int tcp_send(const void *data, unsigned len);
+
+/**
+ * tcp_close() - Close the connection
+ *
+ * This sends FIN and forgets the connection; the caller is expected to stop
+ * the net_loop() afterwards.
+ */
+void tcp_close(void);
+
+/**
+ * tcp_get_stats() - Get the counters for the current connection
+ *
+ * @stats:	Returns the counters
+ */
+void tcp_get_stats(struct tcp_stats *stats);
+
+/**
+ * tcp_receive() - Handle a received TCP segment
+ *
+ * @ip:		IP header, followed by the segment
+ * @len:	Length of the IP packet
+ */
+void tcp_receive(struct ip_udp_hdr *ip, unsigned len);
+
+#endif /* __TCP_H__ */
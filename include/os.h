@@ -170,6 +170,27 @@ void os_usleep(unsigned long usec);
  */
 uint64_t os_get_nsec(void);
 
+/**
+ * os_perf_open() - Open a host performance counter for this process
+ *
+ * This uses the Linux perf_event_open() system call. The counter counts
+ * user space only and starts running straight away.
+ *
+ * @type:	Event type (PERF_TYPE_... in linux/perf_event.h)
+ * @config:	Event within the type (PERF_COUNT_...)
+ * @return file descriptor of the counter, or -ve errno on error
+ */
+int os_perf_open(unsigned int type, uint64_t config);
+
+/**
+ * os_perf_read() - Read a host performance counter
+ *
+ * @fd:		File descriptor from os_perf_open()
+ * @count:	Returns the current count
+ * @return 0 if OK, -ve errno on error
+ */
+int os_perf_read(int fd, uint64_t *count);
+
 /**
  * Parse arguments and update sandbox state.
  *
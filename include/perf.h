@@ -0,0 +1,64 @@
+/*
+ * Statistical PC sampling profiler
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __PERF_H
+#define __PERF_H
+
+/**
+ * perf_start() - Start sampling the program counter
+ *
+ * Any samples from an earlier run are discarded.
+ *
+ * @hz:		Samples per second
+ * @return 0 if OK, -ve on error
+ */
+int perf_start(unsigned int hz);
+
+/**
+ * perf_stop() - Stop sampling, keeping the samples taken so far
+ */
+void perf_stop(void);
+
+/**
+ * perf_record_sample() - Record one sample, called from the timer interrupt
+ *
+ * @pc:		Program counter at the time of the interrupt
+ */
+void perf_record_sample(ulong pc);
+
+/**
+ * perf_get_samples() - Get the samples taken in the last run
+ *
+ * The samples are sorted by address, so samples in the same function are
+ * adjacent. Sampling must be stopped.
+ *
+ * @samples:	Returns a pointer to the samples (runtime addresses)
+ * @lost:	Returns the number of samples overwritten because the
+ *		buffer was full
+ * @return number of samples
+ */
+unsigned int perf_get_samples(ulong **samples, ulong *lost);
+
+/**
+ * perf_list_samples() - Write a sample histogram for tools/proftool
+ *
+ * This writes a TRACE_CHUNK_SAMPLES chunk with one record per sampled
+ * address, holding its offset from the start of U-Boot's text and the
+ * number of samples taken there.
+ *
+ * @buff:	Buffer to place the chunk into
+ * @buff_size:	Size of buffer
+ * @needed:	Returns size of buffer needed, which may be greater than
+ *		buff_size if we ran out of space
+ * @return 0 if ok, -1 if space was exhausted
+ */
+int perf_list_samples(void *buff, int buff_size, unsigned int *needed);
+
+/* Architecture hooks, provided by the generic timer code */
+int arch_perf_timer_start(unsigned int hz);
+void arch_perf_timer_stop(void);
+
+#endif /* __PERF_H */
@@ -0,0 +1,80 @@
+/*
+ * Hardware performance counters
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __PMU_H
+#define __PMU_H
+
+/* The events counted, each by its own counter */
+enum pmu_event {
+	PMU_CYCLES,
+	PMU_INSTRUCTIONS,
+	PMU_L1D_MISSES,
+	PMU_L2D_MISSES,
+	PMU_TLB_MISSES,
+
+	PMU_EVENT_COUNT,
+};
+
+/* A reading of all counters */
+struct pmu_snapshot {
+	u64 count[PMU_EVENT_COUNT];
+};
+
+/**
+ * pmu_init() - Set up and start the counters
+ *
+ * This can be called before relocation and again later, in which case the
+ * counters keep running.
+ *
+ * @return 0 if OK, -ENODEV if there is no usable PMU
+ */
+int pmu_init(void);
+
+/**
+ * pmu_read() - Read all counters
+ *
+ * Events that the PMU cannot count read as 0.
+ *
+ * @snap:	Returns the counter values
+ * @return 0 if OK, -ENODEV if the counters are not running
+ */
+int pmu_read(struct pmu_snapshot *snap);
+
+/**
+ * pmu_event_name() - Get the name of an event
+ *
+ * @event:	Event to look up
+ * @return name, e.g. "cycles"
+ */
+const char *pmu_event_name(enum pmu_event event);
+
+/**
+ * pmu_print() - Print counter values, one per line
+ *
+ * The instructions per cycle are shown as well if both are counted.
+ *
+ * @snap:	Counter values, usually from pmu_diff()
+ */
+void pmu_print(const struct pmu_snapshot *snap);
+
+/**
+ * pmu_diff() - Work out the counts between two snapshots
+ *
+ * @diff:	Returns @end - @start for each counter
+ * @start:	Earlier snapshot
+ * @end:	Later snapshot
+ */
+static inline void pmu_diff(struct pmu_snapshot *diff,
+			    const struct pmu_snapshot *start,
+			    const struct pmu_snapshot *end)
+{
+	int i;
+
+	for (i = 0; i < PMU_EVENT_COUNT; i++)
+		diff->count[i] = end->count[i] - start->count[i];
+}
+
+#endif /* __PMU_H */
@@ -8,9 +8,18 @@
 #ifndef __TEST_SUITES_H__
 #define __TEST_SUITES_H__
 
+int do_ut_bch(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
+int do_ut_bootstage(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
+int do_ut_checksum(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
 int do_ut_dm(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
+int do_ut_efi_mem(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
+int do_ut_efi_pool(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
 int do_ut_env(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
+int do_ut_lmb(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
+int do_ut_malloc(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
 int do_ut_overlay(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
+int do_ut_pmu(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
+int do_ut_rtt(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
 int do_ut_time(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
 
 #endif /* __TEST_SUITES_H__ */
@@ -29,6 +29,7 @@ enum {
 enum trace_chunk_type {
 	TRACE_CHUNK_FUNCS,
 	TRACE_CHUNK_CALLS,
+	TRACE_CHUNK_SAMPLES,	/* PC samples, as trace_output_func records */
 };
 
 /* A trace record for a function, as written to the profile output file */
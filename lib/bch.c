@@ -378,9 +378,10 @@ static void compute_syndromes(struct bch_control *bch, uint32_t *ecc,
 			      unsigned int *syn)
 {
 	int i, j, s;
-	unsigned int m;
+	unsigned int m, e, step;
 	uint32_t poly;
 	const int t = GF_T(bch);
+	const unsigned int n = GF_N(bch);
 
 	s = bch->ecc_bits;
 
@@ -396,8 +397,19 @@ static void compute_syndromes(struct bch_control *bch, uint32_t *ecc,
 		s -= 32;
 		while (poly) {
 			i = deg(poly);
-			for (j = 0; j < 2*t; j += 2)
-				syn[j] ^= a_pow(bch, (j+1)*(i+s));
+			/*
+			 * walk exponents (j+1)*(i+s) for odd j+1 incrementally,
+			 * stepping by 2*(i+s) mod n instead of reducing a
+			 * product on every iteration
+			 */
+			e = modulo(bch, i+s);
+			step = modulo(bch, 2*(i+s));
+			for (j = 0; j < 2*t; j += 2) {
+				syn[j] ^= bch->a_pow_tab[e];
+				e += step;
+				if (e >= n)
+					e -= n;
+			}
 
 			poly ^= (1 << i);
 		}
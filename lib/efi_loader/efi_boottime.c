@@ -14,6 +14,8 @@
 #include <u-boot/crc.h>
 #include <bootm.h>
 #include <inttypes.h>
+#include <malloc_track.h>
+#include <perf.h>
 #include <watchdog.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -839,6 +841,14 @@ static efi_status_t EFIAPI efi_exit_boot_services(void *image_handle,
 {
 	EFI_ENTRY("%p, %ld", image_handle, map_key);
 
+	efi_disk_report_cache();
+
+#ifdef CONFIG_PERF_SAMPLE
+	/* The OS owns the timers and exception vectors from here on */
+	perf_stop();
+#endif
+	malloc_track_set_phase(MALLOC_PHASE_HANDOFF);
+
 	board_quiesce_devices();
 
 	/* Fix up caches for EFI payloads if necessary */
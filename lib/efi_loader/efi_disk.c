@@ -16,6 +16,26 @@
 
 static const efi_guid_t efi_block_io_guid = BLOCK_IO_GUID;
 
+#define EFI_DISK_RA_SIZE	(CONFIG_EFI_LOADER_DISK_READAHEAD * 1024)
+
+/*
+ * Read-ahead window, one per block device. Partitions exposed as
+ * separate EFI disks share the window of their device, so a write
+ * through any of them invalidates it for all.
+ */
+struct efi_disk_cache {
+	struct list_head link;
+	const struct blk_desc *desc;
+	const char *ifname;
+	void *buf;
+	lbaint_t start;		/* first cached block */
+	lbaint_t count;		/* number of cached blocks, 0 if invalid */
+	ulong hits;
+	ulong misses;
+};
+
+static LIST_HEAD(efi_disk_caches);
+
 struct efi_disk_obj {
 	/* Generic EFI object parent class data */
 	struct efi_object parent;
@@ -33,6 +53,8 @@ struct efi_disk_obj {
 	lbaint_t offset;
 	/* Internal block device */
 	const struct blk_desc *desc;
+	/* Read-ahead window of the block device, NULL if disabled */
+	struct efi_disk_cache *cache;
 };
 
 static efi_status_t EFIAPI efi_disk_reset(struct efi_block_io *this,
@@ -47,6 +69,68 @@ enum efi_disk_direction {
 	EFI_DISK_WRITE,
 };
 
+static struct efi_disk_cache *efi_disk_get_cache(const struct blk_desc *desc,
+						 const char *ifname)
+{
+	struct efi_disk_cache *cache;
+
+	if (!EFI_DISK_RA_SIZE || EFI_DISK_RA_SIZE < desc->blksz)
+		return NULL;
+
+	list_for_each_entry(cache, &efi_disk_caches, link) {
+		if (cache->desc == desc)
+			return cache;
+	}
+
+	cache = calloc(1, sizeof(*cache));
+	if (!cache)
+		return NULL;
+	cache->buf = memalign(ARCH_DMA_MINALIGN, EFI_DISK_RA_SIZE);
+	if (!cache->buf) {
+		free(cache);
+		return NULL;
+	}
+	cache->desc = desc;
+	cache->ifname = ifname;
+	list_add_tail(&cache->link, &efi_disk_caches);
+
+	return cache;
+}
+
+/*
+ * Serve a small read from the read-ahead window, refilling the window
+ * starting at lba if the request is not completely inside it.
+ */
+static unsigned long efi_disk_cached_read(struct efi_disk_cache *cache,
+					  struct blk_desc *desc, lbaint_t lba,
+					  lbaint_t blocks, void *buffer)
+{
+	lbaint_t count;
+
+	if (lba < cache->start || lba + blocks > cache->start + cache->count) {
+		cache->misses++;
+		cache->count = 0;
+		count = min_t(lbaint_t, EFI_DISK_RA_SIZE / desc->blksz,
+			      desc->lba - lba);
+		if (count < blocks)
+			return blk_dread(desc, lba, blocks, buffer);
+
+		count = blk_dread(desc, lba, count, cache->buf);
+		if (count < blocks)
+			return blk_dread(desc, lba, blocks, buffer);
+
+		cache->start = lba;
+		cache->count = count;
+	} else {
+		cache->hits++;
+	}
+
+	memcpy(buffer, cache->buf + (lba - cache->start) * desc->blksz,
+	       blocks * desc->blksz);
+
+	return blocks;
+}
+
 static efi_status_t EFIAPI efi_disk_rw_blocks(struct efi_block_io *this,
 			u32 media_id, u64 lba, unsigned long buffer_size,
 			void *buffer, enum efi_disk_direction direction)
@@ -70,10 +154,17 @@ static efi_status_t EFIAPI efi_disk_rw_blocks(struct efi_block_io *this,
 	if (buffer_size & (blksz - 1))
 		return EFI_DEVICE_ERROR;
 
-	if (direction == EFI_DISK_READ)
+	if (direction == EFI_DISK_READ && diskobj->cache &&
+	    blocks * blksz < EFI_DISK_RA_SIZE) {
+		n = efi_disk_cached_read(diskobj->cache, desc, lba, blocks,
+					 buffer);
+	} else if (direction == EFI_DISK_READ) {
 		n = blk_dread(desc, lba, blocks, buffer);
-	else
+	} else {
+		if (diskobj->cache)
+			diskobj->cache->count = 0;
 		n = blk_dwrite(desc, lba, blocks, buffer);
+	}
 
 	/* We don't do interrupts, so check for timers cooperatively */
 	efi_timer_check();
@@ -198,6 +289,7 @@ static void efi_disk_add_dev(const char *name,
 	diskobj->dev_index = dev_index;
 	diskobj->offset = offset;
 	diskobj->desc = desc;
+	diskobj->cache = efi_disk_get_cache(desc, if_typename);
 
 	/* Fill in EFI IO Media info (for read/write callbacks) */
 	diskobj->media.removable_media = desc->removable;
@@ -262,10 +354,22 @@ static int efi_disk_create_eltorito(struct blk_desc *desc,
  */
 int efi_disk_register(void)
 {
+	struct efi_disk_cache *cache;
 	int disks = 0;
 #ifdef CONFIG_BLK
 	struct udevice *dev;
+#else
+	int i, if_type;
+#endif
+
+	/* U-Boot may have written to the disks since the last payload */
+	list_for_each_entry(cache, &efi_disk_caches, link) {
+		cache->count = 0;
+		cache->hits = 0;
+		cache->misses = 0;
+	}
 
+#ifdef CONFIG_BLK
 	for (uclass_first_device_check(UCLASS_BLK, &dev);
 	     dev;
 	     uclass_next_device_check(&dev)) {
@@ -284,8 +388,6 @@ int efi_disk_register(void)
 						  desc->devnum, dev->name);
 	}
 #else
-	int i, if_type;
-
 	/* Search for all available disk devices */
 	for (if_type = 0; if_type < IF_TYPE_COUNT; if_type++) {
 		const struct blk_driver *cur_drvr;
@@ -325,3 +427,16 @@ int efi_disk_register(void)
 
 	return 0;
 }
+
+void efi_disk_report_cache(void)
+{
+	struct efi_disk_cache *cache;
+
+	list_for_each_entry(cache, &efi_disk_caches, link) {
+		if (!cache->hits && !cache->misses)
+			continue;
+		printf("EFI: disk %s %d read-ahead: %lu hits, %lu misses\n",
+		       cache->ifname, cache->desc->devnum, cache->hits,
+		       cache->misses);
+	}
+}
@@ -11,30 +11,33 @@
 #include <malloc.h>
 #include <asm/global_data.h>
 #include <libfdt_env.h>
-#include <linux/list_sort.h>
+#include <linux/rbtree_augmented.h>
 #include <inttypes.h>
 #include <watchdog.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
 struct efi_mem_list {
-	struct list_head link;
+	struct rb_node node;
+	/* Largest free (conventional) item in this subtree, in pages */
+	u64 free_max;
 	struct efi_mem_desc desc;
 };
 
-#define EFI_CARVE_NO_OVERLAP		-1
-#define EFI_CARVE_LOOP_AGAIN		-2
-#define EFI_CARVE_OVERLAPS_NONRAM	-3
-
-/* This list contains all memory map items */
-LIST_HEAD(efi_mem);
+/*
+ * This tree contains all memory map items, keyed by start address. Items
+ * never overlap. Neighbouring items of the same type are kept apart, as
+ * the list this replaced did, so efi_get_memory_map() output is unchanged.
+ */
+static struct rb_root efi_mem = RB_ROOT;
+static int efi_mem_entries;
 
 #ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
 void *efi_bounce_buffer;
 #endif
 
 /*
- * U-Boot services each EFI AllocatePool request as a separate
+ * U-Boot services large EFI AllocatePool requests as a separate
  * (multiple) page allocation.  We have to track the number of pages
  * to be able to free the correct amount later.
  * EFI requires 8 byte alignment for pool allocations, so we can
@@ -47,113 +50,232 @@ struct efi_pool_allocation {
 };
 
 /*
- * Sorts the memory list from highest address to lowest address
+ * Small pool requests are served from power-of-two size classes. Each
+ * class takes objects from one-page slabs, and slab pages are taken from
+ * per memory type arenas of EFI_POOL_ARENA_PAGES pages. Only the arenas
+ * go through efi_allocate_pages(), so GRUB-style streams of tiny
+ * allocations neither walk nor grow the memory map.
  *
- * When allocating memory we should always start from the highest
- * address chunk, so sort the memory list such that the first list
- * iterator gets the highest address and goes lower from there.
+ * Slab objects never sit right behind a page boundary (the slab header
+ * is there), which is how efi_free_pool() tells them apart from the
+ * page-backed struct efi_pool_allocation.
  */
-static int efi_mem_cmp(void *priv, struct list_head *a, struct list_head *b)
-{
-	struct efi_mem_list *mema = list_entry(a, struct efi_mem_list, link);
-	struct efi_mem_list *memb = list_entry(b, struct efi_mem_list, link);
+#define EFI_POOL_MIN_SHIFT	4
+#define EFI_POOL_MAX_SHIFT	10
+#define EFI_POOL_CLASSES	(EFI_POOL_MAX_SHIFT - EFI_POOL_MIN_SHIFT + 1)
+#define EFI_POOL_ARENA_PAGES	16
+#define EFI_POOL_SLAB_MAGIC	0x4c4f4f50
+
+struct efi_pool_free {
+	struct efi_pool_free *next;
+};
 
-	if (mema->desc.physical_start == memb->desc.physical_start)
+struct efi_pool_slab {
+	u32 magic;
+	u16 class;
+	u16 used;
+	int memory_type;
+	struct list_head link;
+	struct efi_pool_free *free;
+};
+
+#define EFI_POOL_SLAB_HDR	ALIGN(sizeof(struct efi_pool_slab), \
+				      1 << EFI_POOL_MIN_SHIFT)
+
+struct efi_pool {
+	bool initialized;
+	/* Slabs with at least one free object, per size class */
+	struct list_head partial[EFI_POOL_CLASSES];
+	/* Unused slab pages */
+	struct efi_pool_free *pages;
+};
+
+static struct efi_pool efi_pools[EFI_MAX_MEMORY_TYPE];
+struct efi_pool_stats efi_pool_stats;
+
+static u64 efi_mem_free_pages(struct efi_mem_list *mem)
+{
+	if (mem->desc.type != EFI_CONVENTIONAL_MEMORY)
 		return 0;
-	else if (mema->desc.physical_start < memb->desc.physical_start)
-		return 1;
-	else
-		return -1;
+
+	return mem->desc.num_pages;
 }
 
-static void efi_mem_sort(void)
+static u64 efi_mem_compute_free_max(struct efi_mem_list *mem)
 {
-	list_sort(NULL, &efi_mem, efi_mem_cmp);
+	u64 free_max = efi_mem_free_pages(mem);
+	struct efi_mem_list *child;
+
+	if (mem->node.rb_left) {
+		child = rb_entry(mem->node.rb_left, struct efi_mem_list, node);
+		free_max = max(free_max, child->free_max);
+	}
+	if (mem->node.rb_right) {
+		child = rb_entry(mem->node.rb_right, struct efi_mem_list, node);
+		free_max = max(free_max, child->free_max);
+	}
+
+	return free_max;
 }
 
-/*
- * Unmaps all memory occupied by the carve_desc region from the
- * list entry pointed to by map.
- *
- * Returns EFI_CARVE_NO_OVERLAP if the regions don't overlap.
- * Returns EFI_CARVE_OVERLAPS_NONRAM if the carve and map overlap,
- *    and the map contains anything but free ram.
- *    (only when overlap_only_ram is true)
- * Returns EFI_CARVE_LOOP_AGAIN if the mapping list should be traversed
- *    again, as it has been altered
- * Returns the number of overlapping pages. The pages are removed from
- *     the mapping list.
- *
- * In case of EFI_CARVE_OVERLAPS_NONRAM it is the callers responsibility
- * to readd the already carved out pages to the mapping.
- */
-static int efi_mem_carve_out(struct efi_mem_list *map,
-			     struct efi_mem_desc *carve_desc,
-			     bool overlap_only_ram)
+RB_DECLARE_CALLBACKS(static, efi_mem_cb, struct efi_mem_list, node, u64,
+		     free_max, efi_mem_compute_free_max)
+
+static uint64_t efi_mem_end(struct efi_mem_desc *desc)
+{
+	return desc->physical_start + (desc->num_pages << EFI_PAGE_SHIFT);
+}
+
+static struct efi_mem_list *efi_mem_next(struct efi_mem_list *mem)
+{
+	struct rb_node *node = rb_next(&mem->node);
+
+	return node ? rb_entry(node, struct efi_mem_list, node) : NULL;
+}
+
+static void efi_mem_insert(struct efi_mem_list *mem)
+{
+	struct rb_node **link = &efi_mem.rb_node, *parent = NULL;
+	uint64_t start = mem->desc.physical_start;
+
+	mem->free_max = efi_mem_free_pages(mem);
+	while (*link) {
+		struct efi_mem_list *cur;
+
+		parent = *link;
+		cur = rb_entry(parent, struct efi_mem_list, node);
+		cur->free_max = max(cur->free_max, mem->free_max);
+		if (start < cur->desc.physical_start)
+			link = &parent->rb_left;
+		else
+			link = &parent->rb_right;
+	}
+
+	rb_link_node(&mem->node, parent, link);
+	rb_insert_augmented(&mem->node, &efi_mem, &efi_mem_cb);
+	efi_mem_entries++;
+}
+
+static void efi_mem_remove(struct efi_mem_list *mem)
 {
-	struct efi_mem_list *newmap;
-	struct efi_mem_desc *map_desc = &map->desc;
-	uint64_t map_start = map_desc->physical_start;
-	uint64_t map_end = map_start + (map_desc->num_pages << EFI_PAGE_SHIFT);
-	uint64_t carve_start = carve_desc->physical_start;
-	uint64_t carve_end = carve_start +
-			     (carve_desc->num_pages << EFI_PAGE_SHIFT);
-
-	/* check whether we're overlapping */
-	if ((carve_end <= map_start) || (carve_start >= map_end))
-		return EFI_CARVE_NO_OVERLAP;
-
-	/* We're overlapping with non-RAM, warn the caller if desired */
-	if (overlap_only_ram && (map_desc->type != EFI_CONVENTIONAL_MEMORY))
-		return EFI_CARVE_OVERLAPS_NONRAM;
-
-	/* Sanitize carve_start and carve_end to lie within our bounds */
-	carve_start = max(carve_start, map_start);
-	carve_end = min(carve_end, map_end);
-
-	/* Carving at the beginning of our map? Just move it! */
-	if (carve_start == map_start) {
-		if (map_end == carve_end) {
-			/* Full overlap, just remove map */
-			list_del(&map->link);
-			free(map);
+	rb_erase_augmented(&mem->node, &efi_mem, &efi_mem_cb);
+	efi_mem_entries--;
+	free(mem);
+}
+
+/* Call after changing the size of an item in place */
+static void efi_mem_update(struct efi_mem_list *mem)
+{
+	efi_mem_cb_propagate(&mem->node, NULL);
+}
+
+/* Returns the first item ending above addr, or NULL */
+static struct efi_mem_list *efi_mem_first_overlap(uint64_t addr)
+{
+	struct rb_node *node = efi_mem.rb_node;
+	struct efi_mem_list *found = NULL;
+
+	/* Find the last item starting at or below addr */
+	while (node) {
+		struct efi_mem_list *cur;
+
+		cur = rb_entry(node, struct efi_mem_list, node);
+		if (addr < cur->desc.physical_start) {
+			node = node->rb_left;
 		} else {
-			map->desc.physical_start = carve_end;
-			map->desc.num_pages = (map_end - carve_end)
-					      >> EFI_PAGE_SHIFT;
+			found = cur;
+			node = node->rb_right;
 		}
+	}
 
-		return (carve_end - carve_start) >> EFI_PAGE_SHIFT;
+	if (!found) {
+		node = rb_first(&efi_mem);
+		return node ? rb_entry(node, struct efi_mem_list, node) : NULL;
 	}
+	if (efi_mem_end(&found->desc) > addr)
+		return found;
 
-	/*
-	 * Overlapping maps, just split the list map at carve_start,
-	 * it will get moved or removed in the next iteration.
-	 *
-	 * [ map_desc |__carve_start__| newmap ]
-	 */
+	return efi_mem_next(found);
+}
 
-	/* Create a new map from [ carve_start ... map_end ] */
-	newmap = calloc(1, sizeof(*newmap));
-	newmap->desc = map->desc;
-	newmap->desc.physical_start = carve_start;
-	newmap->desc.num_pages = (map_end - carve_start) >> EFI_PAGE_SHIFT;
-	/* Insert before current entry (descending address order) */
-	list_add_tail(&newmap->link, &map->link);
+/* Check that [start, end) is completely covered by free RAM */
+static bool efi_mem_is_free_ram(uint64_t start, uint64_t end)
+{
+	struct efi_mem_list *mem;
+	uint64_t pos = start;
+
+	for (mem = efi_mem_first_overlap(start); mem && pos < end;
+	     mem = efi_mem_next(mem)) {
+		if (mem->desc.physical_start > pos)
+			return false;
+		if (mem->desc.type != EFI_CONVENTIONAL_MEMORY)
+			return false;
+		pos = efi_mem_end(&mem->desc);
+	}
 
-	/* Shrink the map to [ map_start ... carve_start ] */
-	map_desc->num_pages = (carve_start - map_start) >> EFI_PAGE_SHIFT;
+	return pos >= end;
+}
 
-	return EFI_CARVE_LOOP_AGAIN;
+/*
+ * Unmaps all memory in [start, end) from the map, trimming, splitting or
+ * removing the items it overlaps.
+ *
+ * Returns 0 on success or -ENOMEM if an item could not be split, in which
+ * case the map is unchanged.
+ */
+static int efi_mem_carve_out(uint64_t start, uint64_t end)
+{
+	struct efi_mem_list *mem, *next, *newmem;
+
+	for (mem = efi_mem_first_overlap(start);
+	     mem && mem->desc.physical_start < end; mem = next) {
+		struct efi_mem_desc *desc = &mem->desc;
+		uint64_t mem_start = desc->physical_start;
+		uint64_t mem_end = efi_mem_end(desc);
+
+		next = efi_mem_next(mem);
+
+		if (mem_start < start && mem_end > end) {
+			/*
+			 * Carving out of the middle, split the item:
+			 * [ mem | carve | newmem ]
+			 */
+			newmem = calloc(1, sizeof(*newmem));
+			if (!newmem)
+				return -ENOMEM;
+			newmem->desc = *desc;
+			newmem->desc.physical_start = end;
+			newmem->desc.virtual_start += end - mem_start;
+			newmem->desc.num_pages = (mem_end - end) >>
+						 EFI_PAGE_SHIFT;
+			desc->num_pages = (start - mem_start) >> EFI_PAGE_SHIFT;
+			efi_mem_update(mem);
+			efi_mem_insert(newmem);
+			return 0;
+		} else if (mem_start < start) {
+			/* Carving the end of the item, shrink it */
+			desc->num_pages = (start - mem_start) >> EFI_PAGE_SHIFT;
+			efi_mem_update(mem);
+		} else if (mem_end > end) {
+			/* Carving the beginning of the item, just move it */
+			desc->physical_start = end;
+			desc->virtual_start += end - mem_start;
+			desc->num_pages = (mem_end - end) >> EFI_PAGE_SHIFT;
+			efi_mem_update(mem);
+		} else {
+			/* Full overlap, just remove the item */
+			efi_mem_remove(mem);
+		}
+	}
+
+	return 0;
 }
 
 uint64_t efi_add_memory_map(uint64_t start, uint64_t pages, int memory_type,
 			    bool overlap_only_ram)
 {
-	struct list_head *lhandle;
 	struct efi_mem_list *newlist;
-	bool carve_again;
-	uint64_t carved_pages = 0;
+	uint64_t end = start + (pages << EFI_PAGE_SHIFT);
 
 	debug("%s: 0x%" PRIx64 " 0x%" PRIx64 " %d %s\n", __func__,
 	      start, pages, memory_type, overlap_only_ram ? "yes" : "no");
@@ -161,7 +283,16 @@ uint64_t efi_add_memory_map(uint64_t start, uint64_t pages, int memory_type,
 	if (!pages)
 		return start;
 
+	/*
+	 * The payload wants to have RAM overlaps only, error out before
+	 * touching the map if we would hit a non-RAM or unallocated region.
+	 */
+	if (overlap_only_ram && !efi_mem_is_free_ram(start, end))
+		return 0;
+
 	newlist = calloc(1, sizeof(*newlist));
+	if (!newlist)
+		return 0;
 	newlist->desc.type = memory_type;
 	newlist->desc.physical_start = start;
 	newlist->desc.virtual_start = start;
@@ -181,98 +312,57 @@ uint64_t efi_add_memory_map(uint64_t start, uint64_t pages, int memory_type,
 		break;
 	}
 
-	/* Add our new map */
-	do {
-		carve_again = false;
-		list_for_each(lhandle, &efi_mem) {
-			struct efi_mem_list *lmem;
-			int r;
-
-			lmem = list_entry(lhandle, struct efi_mem_list, link);
-			r = efi_mem_carve_out(lmem, &newlist->desc,
-					      overlap_only_ram);
-			switch (r) {
-			case EFI_CARVE_OVERLAPS_NONRAM:
-				/*
-				 * The user requested to only have RAM overlaps,
-				 * but we hit a non-RAM region. Error out.
-				 */
-				return 0;
-			case EFI_CARVE_NO_OVERLAP:
-				/* Just ignore this list entry */
-				break;
-			case EFI_CARVE_LOOP_AGAIN:
-				/*
-				 * We split an entry, but need to loop through
-				 * the list again to actually carve it.
-				 */
-				carve_again = true;
-				break;
-			default:
-				/* We carved a number of pages */
-				carved_pages += r;
-				carve_again = true;
-				break;
-			}
-
-			if (carve_again) {
-				/* The list changed, we need to start over */
-				break;
-			}
-		}
-	} while (carve_again);
+	if (efi_mem_carve_out(start, end)) {
+		free(newlist);
+		return 0;
+	}
+	efi_mem_insert(newlist);
+
+	return start;
+}
+
+/*
+ * Returns the highest address in free RAM where len bytes fit below
+ * max_addr, searching only the subtree at node. Subtrees without a large
+ * enough free item are skipped using their free_max.
+ */
+static uint64_t efi_find_free_in(struct rb_node *node, uint64_t len,
+				 uint64_t max_addr)
+{
+	struct efi_mem_list *lmem;
+	struct efi_mem_desc *desc;
+	uint64_t ret;
+
+	if (!node)
+		return 0;
 
-	if (overlap_only_ram && (carved_pages != pages)) {
-		/*
-		 * The payload wanted to have RAM overlaps, but we overlapped
-		 * with an unallocated region. Error out.
-		 */
+	lmem = rb_entry(node, struct efi_mem_list, node);
+	if ((lmem->free_max << EFI_PAGE_SHIFT) < len)
 		return 0;
+
+	/* Higher addresses first, unless they are all above max_addr */
+	desc = &lmem->desc;
+	if (desc->physical_start < max_addr) {
+		ret = efi_find_free_in(node->rb_right, len, max_addr);
+		if (ret)
+			return ret;
 	}
 
-	/* Add our new map */
-        list_add_tail(&newlist->link, &efi_mem);
+	/* We only take memory from free RAM */
+	if (desc->type == EFI_CONVENTIONAL_MEMORY) {
+		uint64_t curmax = min(max_addr, efi_mem_end(desc));
 
-	/* And make sure memory is listed in descending order */
-	efi_mem_sort();
+		/* Return the highest address in this item within bounds */
+		if (curmax >= len && curmax - len >= desc->physical_start)
+			return curmax - len;
+	}
 
-	return start;
+	return efi_find_free_in(node->rb_left, len, max_addr);
 }
 
 static uint64_t efi_find_free_memory(uint64_t len, uint64_t max_addr)
 {
-	struct list_head *lhandle;
-
-	list_for_each(lhandle, &efi_mem) {
-		struct efi_mem_list *lmem = list_entry(lhandle,
-			struct efi_mem_list, link);
-		struct efi_mem_desc *desc = &lmem->desc;
-		uint64_t desc_len = desc->num_pages << EFI_PAGE_SHIFT;
-		uint64_t desc_end = desc->physical_start + desc_len;
-		uint64_t curmax = min(max_addr, desc_end);
-		uint64_t ret = curmax - len;
-
-		/* We only take memory from free RAM */
-		if (desc->type != EFI_CONVENTIONAL_MEMORY)
-			continue;
-
-		/* Out of bounds for max_addr */
-		if ((ret + len) > max_addr)
-			continue;
-
-		/* Out of bounds for upper map limit */
-		if ((ret + len) > desc_end)
-			continue;
-
-		/* Out of bounds for lower map limit */
-		if (ret < desc->physical_start)
-			continue;
-
-		/* Return the highest address in this map within bounds */
-		return ret;
-	}
-
-	return 0;
+	return efi_find_free_in(efi_mem.rb_node, len, max_addr);
 }
 
 efi_status_t efi_allocate_pages(int type, int memory_type,
@@ -343,7 +433,6 @@ efi_status_t efi_free_pages(uint64_t memory, unsigned long pages)
 	uint64_t r = 0;
 
 	r = efi_add_memory_map(memory, pages, EFI_CONVENTIONAL_MEMORY, false);
-	/* Merging of adjacent free regions is missing */
 
 	if (r == memory)
 		return EFI_SUCCESS;
@@ -351,6 +440,122 @@ efi_status_t efi_free_pages(uint64_t memory, unsigned long pages)
 	return EFI_NOT_FOUND;
 }
 
+static struct efi_pool *efi_pool_get(int memory_type)
+{
+	struct efi_pool *pool = &efi_pools[memory_type];
+	int i;
+
+	if (!pool->initialized) {
+		for (i = 0; i < EFI_POOL_CLASSES; i++)
+			INIT_LIST_HEAD(&pool->partial[i]);
+		pool->initialized = true;
+	}
+
+	return pool;
+}
+
+/* Turn an unused page of the pool into a slab for the given size class */
+static struct efi_pool_slab *efi_pool_new_slab(struct efi_pool *pool,
+					       int memory_type, int class)
+{
+	unsigned long size = 1UL << (class + EFI_POOL_MIN_SHIFT);
+	struct efi_pool_slab *slab;
+	struct efi_pool_free **next;
+	unsigned long off;
+
+	if (!pool->pages) {
+		uint64_t addr;
+		int i;
+
+		if (efi_allocate_pages(0, memory_type, EFI_POOL_ARENA_PAGES,
+				       &addr) != EFI_SUCCESS)
+			return NULL;
+		efi_pool_stats.arenas++;
+
+		for (i = EFI_POOL_ARENA_PAGES - 1; i >= 0; i--) {
+			struct efi_pool_free *page;
+
+			page = (void *)(uintptr_t)(addr +
+						   (i << EFI_PAGE_SHIFT));
+			page->next = pool->pages;
+			pool->pages = page;
+		}
+	}
+
+	slab = (void *)pool->pages;
+	pool->pages = pool->pages->next;
+
+	slab->magic = EFI_POOL_SLAB_MAGIC;
+	slab->class = class;
+	slab->used = 0;
+	slab->memory_type = memory_type;
+	next = &slab->free;
+	for (off = EFI_POOL_SLAB_HDR; off + size <= EFI_PAGE_SIZE;
+	     off += size) {
+		*next = (void *)slab + off;
+		next = &(*next)->next;
+	}
+	*next = NULL;
+	list_add(&slab->link, &pool->partial[class]);
+
+	return slab;
+}
+
+static void *efi_pool_alloc_small(int memory_type, unsigned long size)
+{
+	struct efi_pool *pool = efi_pool_get(memory_type);
+	struct efi_pool_slab *slab;
+	struct efi_pool_free *obj;
+	int class = 0;
+
+	while ((1UL << (class + EFI_POOL_MIN_SHIFT)) < size)
+		class++;
+
+	if (list_empty(&pool->partial[class]) &&
+	    !efi_pool_new_slab(pool, memory_type, class))
+		return NULL;
+
+	slab = list_first_entry(&pool->partial[class], struct efi_pool_slab,
+				link);
+	obj = slab->free;
+	slab->free = obj->next;
+	slab->used++;
+	/* Full slabs are only found again through their objects */
+	if (!slab->free)
+		list_del(&slab->link);
+
+	return obj;
+}
+
+static efi_status_t efi_pool_free_small(void *buffer)
+{
+	struct efi_pool_slab *slab;
+	struct efi_pool_free *obj = buffer;
+	struct efi_pool *pool;
+
+	slab = (void *)((uintptr_t)buffer & ~EFI_PAGE_MASK);
+	if (slab->magic != EFI_POOL_SLAB_MAGIC || !slab->used ||
+	    ((uintptr_t)buffer & EFI_PAGE_MASK) < EFI_POOL_SLAB_HDR)
+		return EFI_INVALID_PARAMETER;
+
+	pool = &efi_pools[slab->memory_type];
+	if (!slab->free)
+		list_add(&slab->link, &pool->partial[slab->class]);
+	obj->next = slab->free;
+	slab->free = obj;
+
+	if (!--slab->used) {
+		/* Hand the page back for use by any size class */
+		list_del(&slab->link);
+		slab->magic = 0;
+		obj = (void *)slab;
+		obj->next = pool->pages;
+		pool->pages = obj;
+	}
+
+	return EFI_SUCCESS;
+}
+
 efi_status_t efi_allocate_pool(int pool_type, unsigned long size,
 			       void **buffer)
 {
@@ -363,12 +568,22 @@ efi_status_t efi_allocate_pool(int pool_type, unsigned long size,
 		return EFI_SUCCESS;
 	}
 
+	if (pool_type >= 0 && pool_type < EFI_MAX_MEMORY_TYPE &&
+	    size <= (1UL << EFI_POOL_MAX_SHIFT)) {
+		*buffer = efi_pool_alloc_small(pool_type, size);
+		if (!*buffer)
+			return EFI_OUT_OF_RESOURCES;
+		efi_pool_stats.small_allocs++;
+		return EFI_SUCCESS;
+	}
+
 	r = efi_allocate_pages(0, pool_type, num_pages, &t);
 
 	if (r == EFI_SUCCESS) {
 		struct efi_pool_allocation *alloc = (void *)(uintptr_t)t;
 		alloc->num_pages = num_pages;
 		*buffer = alloc->data;
+		efi_pool_stats.page_allocs++;
 	}
 
 	return r;
@@ -383,10 +598,13 @@ efi_status_t efi_free_pool(void *buffer)
 		return EFI_INVALID_PARAMETER;
 
 	alloc = container_of(buffer, struct efi_pool_allocation, data);
-	/* Sanity check, was the supplied address returned by allocate_pool */
-	assert(((uintptr_t)alloc & EFI_PAGE_MASK) == 0);
+	if ((uintptr_t)alloc & EFI_PAGE_MASK)
+		r = efi_pool_free_small(buffer);
+	else
+		r = efi_free_pages((uintptr_t)alloc, alloc->num_pages);
 
-	r = efi_free_pages((uintptr_t)alloc, alloc->num_pages);
+	if (r == EFI_SUCCESS)
+		efi_pool_stats.frees++;
 
 	return r;
 }
@@ -398,13 +616,10 @@ efi_status_t efi_get_memory_map(unsigned long *memory_map_size,
 			       uint32_t *descriptor_version)
 {
 	ulong map_size = 0;
-	int map_entries = 0;
-	struct list_head *lhandle;
+	int map_entries = efi_mem_entries;
+	struct rb_node *node;
 	unsigned long provided_map_size = *memory_map_size;
 
-	list_for_each(lhandle, &efi_mem)
-		map_entries++;
-
 	map_size = map_entries * sizeof(struct efi_mem_desc);
 
 	*memory_map_size = map_size;
@@ -418,16 +633,13 @@ efi_status_t efi_get_memory_map(unsigned long *memory_map_size,
 	if (descriptor_version)
 		*descriptor_version = EFI_MEMORY_DESCRIPTOR_VERSION;
 
-	/* Copy list into array */
+	/* Copy tree into array, in ascending order */
 	if (memory_map) {
-		/* Return the list in ascending order */
-		memory_map = &memory_map[map_entries - 1];
-		list_for_each(lhandle, &efi_mem) {
+		for (node = rb_first(&efi_mem); node; node = rb_next(node)) {
 			struct efi_mem_list *lmem;
 
-			lmem = list_entry(lhandle, struct efi_mem_list, link);
-			*memory_map = lmem->desc;
-			memory_map--;
+			lmem = rb_entry(node, struct efi_mem_list, node);
+			*memory_map++ = lmem->desc;
 		}
 	}
 
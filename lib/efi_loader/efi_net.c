@@ -17,8 +17,26 @@ DECLARE_GLOBAL_DATA_PTR;
 static const efi_guid_t efi_net_guid = EFI_SIMPLE_NETWORK_GUID;
 static const efi_guid_t efi_pxe_guid = EFI_PXE_GUID;
 static struct efi_pxe_packet *dhcp_ack;
-static bool new_rx_packet;
-static void *new_tx_packet;
+
+/*
+ * Frames received while polling the adapter are queued here until the
+ * payload fetches them with Receive(), so a poll that returns several
+ * frames loses none of them.
+ */
+#define EFI_NET_RX_RING_SIZE	32
+/* Transmitted buffers waiting to be handed back by GetStatus() */
+#define EFI_NET_TX_RING_SIZE	32
+
+struct efi_net_rx_frame {
+	int len;
+	u8 data[PKTSIZE_ALIGN];
+};
+
+static struct efi_net_rx_frame *rx_ring;
+static unsigned int rx_head, rx_count;
+static void *tx_ring[EFI_NET_TX_RING_SIZE];
+static unsigned int tx_head, tx_count;
+static struct efi_network_statistics net_stats;
 
 struct efi_net_obj {
 	/* Generic EFI object parent class data */
@@ -95,13 +113,53 @@ static efi_status_t EFIAPI efi_net_station_address(
 	return EFI_EXIT(EFI_INVALID_PARAMETER);
 }
 
+/* Counters we don't keep read as all ones, as the UEFI spec asks */
+static void efi_net_reset_statistics(void)
+{
+	memset(&net_stats, 0xff, sizeof(net_stats));
+	net_stats.rx_total_frames = 0;
+	net_stats.rx_good_frames = 0;
+	net_stats.rx_oversize_frames = 0;
+	net_stats.rx_dropped_frames = 0;
+	net_stats.rx_unicast_frames = 0;
+	net_stats.rx_broadcast_frames = 0;
+	net_stats.rx_multicast_frames = 0;
+	net_stats.rx_total_bytes = 0;
+	net_stats.tx_total_frames = 0;
+	net_stats.tx_good_frames = 0;
+	net_stats.tx_undersize_frames = 0;
+	net_stats.tx_oversize_frames = 0;
+	net_stats.tx_unicast_frames = 0;
+	net_stats.tx_broadcast_frames = 0;
+	net_stats.tx_multicast_frames = 0;
+	net_stats.tx_total_bytes = 0;
+	net_stats.tx_error_frames = 0;
+}
+
 static efi_status_t EFIAPI efi_net_statistics(struct efi_simple_network *this,
 					      int reset, ulong *stat_size,
 					      void *stat_table)
 {
+	efi_status_t r = EFI_SUCCESS;
+
 	EFI_ENTRY("%p, %x, %p, %p", this, reset, stat_size, stat_table);
 
-	return EFI_EXIT(EFI_INVALID_PARAMETER);
+	if (!stat_size && !reset)
+		return EFI_EXIT(EFI_INVALID_PARAMETER);
+
+	if (stat_size) {
+		if (stat_table)
+			memcpy(stat_table, &net_stats,
+			       min_t(ulong, *stat_size, sizeof(net_stats)));
+		if (*stat_size < sizeof(net_stats))
+			r = EFI_BUFFER_TOO_SMALL;
+		*stat_size = sizeof(net_stats);
+	}
+
+	if (reset)
+		efi_net_reset_statistics();
+
+	return EFI_EXIT(r);
 }
 
 static efi_status_t EFIAPI efi_net_mcastiptomac(struct efi_simple_network *this,
@@ -124,18 +182,71 @@ static efi_status_t EFIAPI efi_net_nvdata(struct efi_simple_network *this,
 	return EFI_EXIT(EFI_INVALID_PARAMETER);
 }
 
+static void efi_net_push(void *pkt, int len)
+{
+	struct efi_net_rx_frame *frame;
+	struct ethernet_hdr *eth = pkt;
+
+	net_stats.rx_total_frames++;
+	if (len > PKTSIZE_ALIGN) {
+		net_stats.rx_oversize_frames++;
+		return;
+	}
+	if (rx_count == EFI_NET_RX_RING_SIZE) {
+		net_stats.rx_dropped_frames++;
+		return;
+	}
+
+	frame = &rx_ring[(rx_head + rx_count) % EFI_NET_RX_RING_SIZE];
+	memcpy(frame->data, pkt, len);
+	frame->len = len;
+	rx_count++;
+
+	net_stats.rx_good_frames++;
+	net_stats.rx_total_bytes += len;
+	if (is_broadcast_ethaddr(eth->et_dest))
+		net_stats.rx_broadcast_frames++;
+	else if (is_multicast_ethaddr(eth->et_dest))
+		net_stats.rx_multicast_frames++;
+	else
+		net_stats.rx_unicast_frames++;
+}
+
+/* Drain whatever the adapter has into the RX ring, if there is room */
+static void efi_net_poll(void)
+{
+	if (!rx_ring || rx_count == EFI_NET_RX_RING_SIZE)
+		return;
+
+	push_packet = efi_net_push;
+	eth_rx();
+	push_packet = NULL;
+}
+
 static efi_status_t EFIAPI efi_net_get_status(struct efi_simple_network *this,
 					      u32 *int_status, void **txbuf)
 {
 	EFI_ENTRY("%p, %p, %p", this, int_status, txbuf);
 
-	/* We send packets synchronously, so nothing is outstanding */
-	if (int_status)
+	efi_net_poll();
+
+	if (int_status) {
 		*int_status = 0;
-	if (txbuf)
-		*txbuf = new_tx_packet;
+		if (rx_count)
+			*int_status |= EFI_SIMPLE_NETWORK_RECEIVE_INTERRUPT;
+		if (tx_count)
+			*int_status |= EFI_SIMPLE_NETWORK_TRANSMIT_INTERRUPT;
+	}
 
-	new_tx_packet = NULL;
+	/* Hand back one transmitted buffer per call, oldest first */
+	if (txbuf) {
+		*txbuf = NULL;
+		if (tx_count) {
+			*txbuf = tx_ring[tx_head];
+			tx_head = (tx_head + 1) % EFI_NET_TX_RING_SIZE;
+			tx_count--;
+		}
+	}
 
 	return EFI_EXIT(EFI_SUCCESS);
 }
@@ -145,6 +256,9 @@ static efi_status_t EFIAPI efi_net_transmit(struct efi_simple_network *this,
 		struct efi_mac_address *src_addr,
 		struct efi_mac_address *dest_addr, u16 *protocol)
 {
+	struct ethernet_hdr *eth = buffer;
+	int ret;
+
 	EFI_ENTRY("%p, %lx, %lx, %p, %p, %p, %p", this, header_size,
 		  buffer_size, buffer, src_addr, dest_addr, protocol);
 
@@ -153,22 +267,49 @@ static efi_status_t EFIAPI efi_net_transmit(struct efi_simple_network *this,
 		return EFI_EXIT(EFI_INVALID_PARAMETER);
 	}
 
+	/* The payload has to recycle buffers through GetStatus() first */
+	if (tx_count == EFI_NET_TX_RING_SIZE)
+		return EFI_EXIT(EFI_NOT_READY);
+
+	net_stats.tx_total_frames++;
+	if (buffer_size < ETHER_HDR_SIZE) {
+		net_stats.tx_undersize_frames++;
+		return EFI_EXIT(EFI_BUFFER_TOO_SMALL);
+	}
+	if (buffer_size > PKTSIZE) {
+		net_stats.tx_oversize_frames++;
+		return EFI_EXIT(EFI_INVALID_PARAMETER);
+	}
+
+	/*
+	 * The send itself completes before we return, so the buffer can go
+	 * straight onto the list of buffers GetStatus() reports as recycled.
+	 */
 #ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
 	/* Ethernet packets always fit, just bounce */
 	memcpy(efi_bounce_buffer, buffer, buffer_size);
-	net_send_packet(efi_bounce_buffer, buffer_size);
+	ret = eth_send(efi_bounce_buffer, buffer_size);
 #else
-	net_send_packet(buffer, buffer_size);
+	ret = eth_send(buffer, buffer_size);
 #endif
+	if (ret < 0) {
+		net_stats.tx_error_frames++;
+		return EFI_EXIT(EFI_DEVICE_ERROR);
+	}
 
-	new_tx_packet = buffer;
+	net_stats.tx_good_frames++;
+	net_stats.tx_total_bytes += buffer_size;
+	if (is_broadcast_ethaddr(eth->et_dest))
+		net_stats.tx_broadcast_frames++;
+	else if (is_multicast_ethaddr(eth->et_dest))
+		net_stats.tx_multicast_frames++;
+	else
+		net_stats.tx_unicast_frames++;
 
-	return EFI_EXIT(EFI_SUCCESS);
-}
+	tx_ring[(tx_head + tx_count) % EFI_NET_TX_RING_SIZE] = buffer;
+	tx_count++;
 
-static void efi_net_push(void *pkt, int len)
-{
-	new_rx_packet = true;
+	return EFI_EXIT(EFI_SUCCESS);
 }
 
 static efi_status_t EFIAPI efi_net_receive(struct efi_simple_network *this,
@@ -176,25 +317,42 @@ static efi_status_t EFIAPI efi_net_receive(struct efi_simple_network *this,
 		struct efi_mac_address *src_addr,
 		struct efi_mac_address *dest_addr, u16 *protocol)
 {
+	struct efi_net_rx_frame *frame;
+	struct ethernet_hdr *eth;
+
 	EFI_ENTRY("%p, %p, %p, %p, %p, %p, %p", this, header_size,
 		  buffer_size, buffer, src_addr, dest_addr, protocol);
 
-	push_packet = efi_net_push;
-	eth_rx();
-	push_packet = NULL;
+	if (!rx_count)
+		efi_net_poll();
 
-	if (!new_rx_packet)
+	if (!rx_count)
 		return EFI_EXIT(EFI_NOT_READY);
 
-	if (*buffer_size < net_rx_packet_len) {
+	frame = &rx_ring[rx_head];
+	if (*buffer_size < frame->len) {
 		/* Packet doesn't fit, try again with bigger buf */
-		*buffer_size = net_rx_packet_len;
+		*buffer_size = frame->len;
 		return EFI_EXIT(EFI_BUFFER_TOO_SMALL);
 	}
 
-	memcpy(buffer, net_rx_packet, net_rx_packet_len);
-	*buffer_size = net_rx_packet_len;
-	new_rx_packet = false;
+	memcpy(buffer, frame->data, frame->len);
+	*buffer_size = frame->len;
+
+	if (frame->len >= ETHER_HDR_SIZE) {
+		eth = (struct ethernet_hdr *)frame->data;
+		if (header_size)
+			*header_size = ETHER_HDR_SIZE;
+		if (src_addr)
+			memcpy(src_addr->mac_addr, eth->et_src, ARP_HLEN);
+		if (dest_addr)
+			memcpy(dest_addr->mac_addr, eth->et_dest, ARP_HLEN);
+		if (protocol)
+			*protocol = ntohs(eth->et_protlen);
+	}
+
+	rx_head = (rx_head + 1) % EFI_NET_RX_RING_SIZE;
+	rx_count--;
 
 	return EFI_EXIT(EFI_SUCCESS);
 }
@@ -229,6 +387,17 @@ int efi_net_register(void **handle)
 		return 0;
 	}
 
+	if (!rx_ring) {
+		rx_ring = malloc(EFI_NET_RX_RING_SIZE * sizeof(*rx_ring));
+		if (!rx_ring)
+			return -ENOMEM;
+	}
+	rx_head = 0;
+	rx_count = 0;
+	tx_head = 0;
+	tx_count = 0;
+	efi_net_reset_statistics();
+
 	/* We only expose the "active" eth device, so one is enough */
 	netobj = calloc(1, sizeof(*netobj));
 
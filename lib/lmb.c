@@ -9,6 +9,7 @@
 
 #include <common.h>
 #include <lmb.h>
+#include <malloc.h>
 
 #define LMB_ALLOC_ANYWHERE	0
 
@@ -47,45 +48,59 @@ static long lmb_addrs_overlap(phys_addr_t base1,
 	return ((base1 < (base2+size2)) && (base2 < (base1+size1)));
 }
 
-static long lmb_addrs_adjacent(phys_addr_t base1, phys_size_t size1,
-		phys_addr_t base2, phys_size_t size2)
+/*
+ * Find the first region which ends after @addr. Since the regions are
+ * sorted and do not overlap, this is the only one which can contain @addr.
+ */
+static unsigned long lmb_find_region(struct lmb_region *rgn, phys_addr_t addr)
 {
-	if (base2 == base1 + size1)
-		return 1;
-	else if (base1 == base2 + size2)
-		return -1;
+	unsigned long lo = 0, hi = rgn->cnt, mid;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		/* Compare the last byte, so a region at the top cannot wrap */
+		if (rgn->region[mid].base + rgn->region[mid].size - 1 >= addr)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
 
-	return 0;
+	return lo;
 }
 
-static long lmb_regions_adjacent(struct lmb_region *rgn,
-		unsigned long r1, unsigned long r2)
+static void lmb_remove_region(struct lmb_region *rgn, unsigned long r)
 {
-	phys_addr_t base1 = rgn->region[r1].base;
-	phys_size_t size1 = rgn->region[r1].size;
-	phys_addr_t base2 = rgn->region[r2].base;
-	phys_size_t size2 = rgn->region[r2].size;
-
-	return lmb_addrs_adjacent(base1, size1, base2, size2);
+	memmove(&rgn->region[r], &rgn->region[r + 1],
+		(rgn->cnt - r - 1) * sizeof(*rgn->region));
+	rgn->cnt--;
 }
 
-static void lmb_remove_region(struct lmb_region *rgn, unsigned long r)
+/* Double the space for regions, moving them out of lmb_region.initial */
+static int lmb_grow_region(struct lmb_region *rgn)
 {
-	unsigned long i;
+	struct lmb_property *region;
+	unsigned long max = rgn->max * 2;
 
-	for (i = r; i < rgn->cnt - 1; i++) {
-		rgn->region[i].base = rgn->region[i + 1].base;
-		rgn->region[i].size = rgn->region[i + 1].size;
-	}
-	rgn->cnt--;
+	region = malloc(max * sizeof(*region));
+	if (!region)
+		return -1;
+	memcpy(region, rgn->region, rgn->cnt * sizeof(*region));
+	if (rgn->region != rgn->initial)
+		free(rgn->region);
+	rgn->region = region;
+	rgn->max = max;
+
+	return 0;
 }
 
-/* Assumption: base addr of region 1 < base addr of region 2 */
-static void lmb_coalesce_regions(struct lmb_region *rgn,
-		unsigned long r1, unsigned long r2)
+static void lmb_init_region(struct lmb_region *rgn)
 {
-	rgn->region[r1].size += rgn->region[r2].size;
-	lmb_remove_region(rgn, r2);
+	rgn->region = rgn->initial;
+	rgn->max = ARRAY_SIZE(rgn->initial);
+	rgn->region[0].base = 0;
+	rgn->region[0].size = 0;
+	rgn->cnt = 1;
+	rgn->size = 0;
 }
 
 void lmb_init(struct lmb *lmb)
@@ -93,80 +108,72 @@ void lmb_init(struct lmb *lmb)
 	/* Create a dummy zero size LMB which will get coalesced away later.
 	 * This simplifies the lmb_add() code below...
 	 */
-	lmb->memory.region[0].base = 0;
-	lmb->memory.region[0].size = 0;
-	lmb->memory.cnt = 1;
-	lmb->memory.size = 0;
+	lmb_init_region(&lmb->memory);
 
 	/* Ditto. */
-	lmb->reserved.region[0].base = 0;
-	lmb->reserved.region[0].size = 0;
-	lmb->reserved.cnt = 1;
-	lmb->reserved.size = 0;
+	lmb_init_region(&lmb->reserved);
+}
+
+static void lmb_release_region(struct lmb_region *rgn)
+{
+	if (rgn->region && rgn->region != rgn->initial)
+		free(rgn->region);
+	rgn->region = NULL;
+	rgn->cnt = 0;
+}
+
+void lmb_release(struct lmb *lmb)
+{
+	lmb_release_region(&lmb->memory);
+	lmb_release_region(&lmb->reserved);
 }
 
 /* This routine called with relocation disabled. */
 static long lmb_add_region(struct lmb_region *rgn, phys_addr_t base, phys_size_t size)
 {
-	unsigned long coalesced = 0;
-	long adjacent, i;
+	phys_addr_t end = base + size;
+	unsigned long i, j;
 
 	if ((rgn->cnt == 1) && (rgn->region[0].size == 0)) {
 		rgn->region[0].base = base;
 		rgn->region[0].size = size;
 		return 0;
 	}
+	if (!size)
+		return 0;
+
+	/* Find the regions which this one overlaps or touches */
+	i = base ? lmb_find_region(rgn, base - 1) : 0;
+	for (j = i; j < rgn->cnt && rgn->region[j].base <= end; j++)
+		;
 
-	/* First try and coalesce this LMB with another. */
-	for (i=0; i < rgn->cnt; i++) {
-		phys_addr_t rgnbase = rgn->region[i].base;
-		phys_size_t rgnsize = rgn->region[i].size;
+	if (j > i) {
+		phys_addr_t rgnend = rgn->region[j - 1].base +
+			rgn->region[j - 1].size;
 
-		if ((rgnbase == base) && (rgnsize == size))
+		if ((rgn->region[i].base == base) &&
+		    (rgn->region[i].size == size))
 			/* Already have this region, so we're done */
 			return 0;
 
-		adjacent = lmb_addrs_adjacent(base,size,rgnbase,rgnsize);
-		if ( adjacent > 0 ) {
-			rgn->region[i].base -= size;
-			rgn->region[i].size += size;
-			coalesced++;
-			break;
-		}
-		else if ( adjacent < 0 ) {
-			rgn->region[i].size += size;
-			coalesced++;
-			break;
-		}
-	}
+		/* Coalesce them all into one */
+		rgn->region[i].base = min(base, rgn->region[i].base);
+		rgn->region[i].size = max(end, rgnend) - rgn->region[i].base;
+		memmove(&rgn->region[i + 1], &rgn->region[j],
+			(rgn->cnt - j) * sizeof(*rgn->region));
+		rgn->cnt -= j - i - 1;
 
-	if ((i < rgn->cnt-1) && lmb_regions_adjacent(rgn, i, i+1) ) {
-		lmb_coalesce_regions(rgn, i, i+1);
-		coalesced++;
+		return 1;
 	}
 
-	if (coalesced)
-		return coalesced;
-	if (rgn->cnt >= MAX_LMB_REGIONS)
+	if (rgn->cnt >= rgn->max && lmb_grow_region(rgn))
 		return -1;
 
 	/* Couldn't coalesce the LMB, so add it to the sorted table. */
-	for (i = rgn->cnt-1; i >= 0; i--) {
-		if (base < rgn->region[i].base) {
-			rgn->region[i+1].base = rgn->region[i].base;
-			rgn->region[i+1].size = rgn->region[i].size;
-		} else {
-			rgn->region[i+1].base = base;
-			rgn->region[i+1].size = size;
-			break;
-		}
-	}
-
-	if (base < rgn->region[0].base) {
-		rgn->region[0].base = base;
-		rgn->region[0].size = size;
-	}
-
+	memmove(&rgn->region[i + 1], &rgn->region[i],
+		(rgn->cnt - i) * sizeof(*rgn->region));
+	rgn->region[i].base = base;
+	rgn->region[i].size = size;
 	rgn->cnt++;
 
 	return 0;
@@ -185,21 +192,17 @@ long lmb_free(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 	struct lmb_region *rgn = &(lmb->reserved);
 	phys_addr_t rgnbegin, rgnend;
 	phys_addr_t end = base + size;
-	int i;
-
-	rgnbegin = rgnend = 0; /* supress gcc warnings */
+	unsigned long i;
 
 	/* Find the region where (base, size) belongs to */
-	for (i=0; i < rgn->cnt; i++) {
-		rgnbegin = rgn->region[i].base;
-		rgnend = rgnbegin + rgn->region[i].size;
-
-		if ((rgnbegin <= base) && (end <= rgnend))
-			break;
-	}
+	i = lmb_find_region(rgn, base);
+	if (i == rgn->cnt)
+		return -1;
+	rgnbegin = rgn->region[i].base;
+	rgnend = rgnbegin + rgn->region[i].size;
 
 	/* Didn't find the region */
-	if (i == rgn->cnt)
+	if ((base < rgnbegin) || (rgnend < end))
 		return -1;
 
 	/* Check to see if we are removing entire region */
@@ -236,20 +239,19 @@ long lmb_reserve(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 	return lmb_add_region(_rgn, base, size);
 }
 
+/* Find the lowest region which overlaps (base, size), or return -1 */
 static long lmb_overlaps_region(struct lmb_region *rgn, phys_addr_t base,
 				phys_size_t size)
 {
 	unsigned long i;
 
-	for (i=0; i < rgn->cnt; i++) {
-		phys_addr_t rgnbase = rgn->region[i].base;
-		phys_size_t rgnsize = rgn->region[i].size;
-		if ( lmb_addrs_overlap(base,size,rgnbase,rgnsize) ) {
-			break;
-		}
-	}
+	i = lmb_find_region(rgn, base);
+	if ((i < rgn->cnt) &&
+	    lmb_addrs_overlap(base, size, rgn->region[i].base,
+			      rgn->region[i].size))
+		return i;
 
-	return (i < rgn->cnt) ? i : -1;
+	return -1;
 }
 
 phys_addr_t lmb_alloc(struct lmb *lmb, phys_size_t size, ulong align)
@@ -324,15 +326,13 @@ phys_addr_t __lmb_alloc_base(struct lmb *lmb, phys_size_t size, ulong align, phy
 
 int lmb_is_reserved(struct lmb *lmb, phys_addr_t addr)
 {
-	int i;
+	struct lmb_region *rgn = &lmb->reserved;
+	unsigned long i;
 
-	for (i = 0; i < lmb->reserved.cnt; i++) {
-		phys_addr_t upper = lmb->reserved.region[i].base +
-			lmb->reserved.region[i].size - 1;
-		if ((addr >= lmb->reserved.region[i].base) && (addr <= upper))
-			return 1;
-	}
-	return 0;
+	i = lmb_find_region(rgn, addr);
+
+	return (i < rgn->cnt) && rgn->region[i].size &&
+		(addr >= rgn->region[i].base);
 }
 
 __weak void board_lmb_reserve(struct lmb *lmb)
@@ -0,0 +1,135 @@
+/*
+ * Statistical PC sampling profiler
+ *
+ * A periodic timer interrupt records the interrupted program counter into
+ * a ring buffer. Unlike function tracing this needs no special build of
+ * U-Boot, and costs one short interrupt per sample.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <malloc.h>
+#include <perf.h>
+#include <trace.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+static ulong *perf_buf;
+static unsigned int perf_head;
+static ulong perf_count;
+static bool perf_running;
+
+void perf_record_sample(ulong pc)
+{
+	perf_buf[perf_head] = pc;
+	if (++perf_head == CONFIG_PERF_SAMPLE_COUNT)
+		perf_head = 0;
+	perf_count++;
+}
+
+int perf_start(unsigned int hz)
+{
+	int ret;
+
+	if (perf_running)
+		perf_stop();
+
+	if (!perf_buf) {
+		perf_buf = malloc(CONFIG_PERF_SAMPLE_COUNT * sizeof(*perf_buf));
+		if (!perf_buf)
+			return -ENOMEM;
+	}
+	perf_head = 0;
+	perf_count = 0;
+
+	ret = arch_perf_timer_start(hz);
+	if (ret)
+		return ret;
+	perf_running = true;
+
+	return 0;
+}
+
+void perf_stop(void)
+{
+	if (!perf_running)
+		return;
+
+	arch_perf_timer_stop();
+	perf_running = false;
+}
+
+static int perf_cmp(const void *a, const void *b)
+{
+	ulong pa = *(const ulong *)a, pb = *(const ulong *)b;
+
+	return pa < pb ? -1 : pa > pb;
+}
+
+unsigned int perf_get_samples(ulong **samples, ulong *lost)
+{
+	unsigned int count;
+
+	if (perf_running || !perf_buf) {
+		*lost = 0;
+		return 0;
+	}
+
+	count = min_t(ulong, perf_count, CONFIG_PERF_SAMPLE_COUNT);
+	*lost = perf_count - count;
+	qsort(perf_buf, count, sizeof(*perf_buf), perf_cmp);
+	/* Order no longer matters, the ring restarts with the next run */
+	perf_head = count % CONFIG_PERF_SAMPLE_COUNT;
+	*samples = perf_buf;
+
+	return count;
+}
+
+int perf_list_samples(void *buff, int buff_size, unsigned int *needed)
+{
+	struct trace_output_hdr *output_hdr = NULL;
+	void *end, *ptr = buff;
+	unsigned int count, i, upto;
+	ulong *samples, lost, base;
+
+	end = buff ? buff + buff_size : NULL;
+	count = perf_get_samples(&samples, &lost);
+	base = (gd->flags & GD_FLG_RELOC) ? gd->relocaddr :
+		CONFIG_SYS_TEXT_BASE;
+
+	/* Place some header information */
+	if (ptr + sizeof(struct trace_output_hdr) < end)
+		output_hdr = ptr;
+	ptr += sizeof(struct trace_output_hdr);
+
+	/* Add a record for each sampled address */
+	for (i = upto = 0; i < count; ) {
+		unsigned int first = i;
+
+		while (i < count && samples[i] == samples[first])
+			i++;
+
+		if (ptr + sizeof(struct trace_output_func) < end) {
+			struct trace_output_func *stats = ptr;
+
+			stats->offset = samples[first] - base;
+			stats->call_count = i - first;
+			upto++;
+		}
+		ptr += sizeof(struct trace_output_func);
+	}
+
+	/* Update the header */
+	if (output_hdr) {
+		output_hdr->rec_count = upto;
+		output_hdr->type = TRACE_CHUNK_SAMPLES;
+	}
+
+	/* Work out how much of the buffer we used */
+	*needed = ptr - buff;
+	if (ptr > end)
+		return -1;
+	return 0;
+}
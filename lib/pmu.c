@@ -0,0 +1,42 @@
+/*
+ * Hardware performance counters, common code
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <pmu.h>
+
+static const char *const pmu_event_names[PMU_EVENT_COUNT] = {
+	[PMU_CYCLES]		= "cycles",
+	[PMU_INSTRUCTIONS]	= "instructions",
+	[PMU_L1D_MISSES]	= "L1D misses",
+	[PMU_L2D_MISSES]	= "L2D misses",
+	[PMU_TLB_MISSES]	= "TLB misses",
+};
+
+const char *pmu_event_name(enum pmu_event event)
+{
+	if (event >= PMU_EVENT_COUNT)
+		return "?";
+
+	return pmu_event_names[event];
+}
+
+void pmu_print(const struct pmu_snapshot *snap)
+{
+	u64 cycles = snap->count[PMU_CYCLES];
+	u64 insns = snap->count[PMU_INSTRUCTIONS];
+	int i;
+
+	for (i = 0; i < PMU_EVENT_COUNT; i++) {
+		print_grouped_ull(snap->count[i], 12);
+		printf(" %s\n", pmu_event_name(i));
+	}
+	if (cycles && insns) {
+		unsigned long long ipc = insns * 100 / cycles;
+
+		printf("%12llu.%02llu instructions per cycle\n", ipc / 100,
+		       ipc % 100);
+	}
+}
@@ -6,6 +6,7 @@
 
 #include <common.h>
 #include <mapmem.h>
+#include <pmu.h>
 #include <trace.h>
 #include <asm/io.h>
 #include <asm/sections.h>
@@ -37,6 +38,9 @@ struct trace_hdr {
 	int depth;
 	int depth_limit;
 	int max_depth;
+#ifdef CONFIG_PMU
+	struct pmu_snapshot pmu_start;	/* PMU counters when tracing began */
+#endif
 };
 
 static struct trace_hdr *hdr;	/* Pointer to start of trace buffer */
@@ -235,6 +239,9 @@ int trace_list_calls(void *buff, int buff_size, unsigned *needed)
 /* Print basic information about tracing */
 void trace_print_stats(void)
 {
+#ifdef CONFIG_PMU
+	struct pmu_snapshot now, diff;
+#endif
 	ulong count;
 
 #ifndef FTRACE
@@ -263,6 +270,13 @@ void trace_print_stats(void)
 	printf("%15d call depth limit\n", hdr->depth_limit);
 	print_grouped_ull(hdr->ftrace_too_deep_count, 10);
 	puts(" calls not traced due to depth\n");
+#ifdef CONFIG_PMU
+	if (!pmu_read(&now)) {
+		puts("Performance counters since tracing started:\n");
+		pmu_diff(&diff, &hdr->pmu_start, &now);
+		pmu_print(&diff);
+	}
+#endif
 }
 
 void __attribute__((no_instrument_function)) trace_set_enabled(int enabled)
@@ -314,8 +328,12 @@ int __attribute__((no_instrument_function)) trace_init(void *buff,
 		return -1;
 	}
 
-	if (was_disabled)
+	if (was_disabled) {
 		memset(hdr, '\0', needed);
+#ifdef CONFIG_PMU
+		pmu_read(&hdr->pmu_start);
+#endif
+	}
 	hdr->func_count = func_count;
 	hdr->call_accum = (uintptr_t *)(hdr + 1);
 
@@ -10,6 +10,7 @@
  */
 
 #include <common.h>
+#include <errno.h>
 
 #include "arp.h"
 
@@ -27,6 +28,25 @@
 # define ARP_TIMEOUT_COUNT	CONFIG_NET_RETRY_COUNT
 #endif
 
+/* Resolved addresses kept from one command to the next, and for how long */
+#define ARP_CACHE_SIZE		CONFIG_ARP_CACHE_SIZE
+#define ARP_CACHE_TIMEOUT	((ulong)CONFIG_ARP_CACHE_TIMEOUT)
+
+/**
+ * struct arp_entry - a resolved address in the ARP cache
+ *
+ * @ip:		IP address, or 0 if the entry is free
+ * @ethaddr:	MAC address of @ip
+ * @dev_index:	network device the address was resolved on
+ * @time:	get_timer() value when the address was last heard from
+ */
+static struct arp_entry {
+	struct in_addr	ip;
+	uchar		ethaddr[ARP_HLEN];
+	int		dev_index;
+	ulong		time;
+} arp_cache[ARP_CACHE_SIZE];
+
 struct in_addr net_arp_wait_packet_ip;
 static struct in_addr net_arp_wait_reply_ip;
 /* MAC address of waiting packet's destination */
@@ -79,20 +99,114 @@ void arp_raw_request(struct in_addr source_ip, const uchar *target_ethaddr,
 	net_send_packet(arp_tx_packet, eth_hdr_size + ARP_HDR_SIZE);
 }
 
-void arp_request(void)
+/* Return the address to resolve to reach @ip: itself or the gateway */
+static struct in_addr arp_next_hop(struct in_addr ip)
 {
-	if ((net_arp_wait_packet_ip.s_addr & net_netmask.s_addr) !=
-	    (net_ip.s_addr & net_netmask.s_addr)) {
-		if (net_gateway.s_addr == 0) {
-			puts("## Warning: gatewayip needed but not set\n");
-			net_arp_wait_reply_ip = net_arp_wait_packet_ip;
-		} else {
-			net_arp_wait_reply_ip = net_gateway;
+	if ((ip.s_addr & net_netmask.s_addr) !=
+	    (net_ip.s_addr & net_netmask.s_addr) && net_gateway.s_addr)
+		return net_gateway;
+
+	return ip;
+}
+
+/* Find @ip in the cache for the current device, dropping stale entries */
+static struct arp_entry *arp_cache_find(struct in_addr ip)
+{
+	int dev_index = eth_get_dev_index();
+	struct arp_entry *ent;
+
+	for (ent = arp_cache; ent < arp_cache + ARP_CACHE_SIZE; ent++) {
+		if (!ent->ip.s_addr)
+			continue;
+		if (get_timer(ent->time) > ARP_CACHE_TIMEOUT) {
+			ent->ip.s_addr = 0;
+			continue;
 		}
-	} else {
-		net_arp_wait_reply_ip = net_arp_wait_packet_ip;
+		if (ent->ip.s_addr == ip.s_addr && ent->dev_index == dev_index)
+			return ent;
 	}
 
+	return NULL;
+}
+
+/*
+ * Record that @ip is at @ethaddr. An address not yet in the cache is only
+ * added if @create is set, replacing the oldest entry if the cache is full.
+ */
+static void arp_cache_update(struct in_addr ip, const uchar *ethaddr,
+			     bool create)
+{
+	struct arp_entry *ent, *old;
+
+	ent = arp_cache_find(ip);
+	if (!ent) {
+		if (!create)
+			return;
+		ent = arp_cache;
+		for (old = arp_cache; old < arp_cache + ARP_CACHE_SIZE; old++) {
+			if (!old->ip.s_addr) {
+				ent = old;
+				break;
+			}
+			if (get_timer(old->time) > get_timer(ent->time))
+				ent = old;
+		}
+		ent->ip = ip;
+		ent->dev_index = eth_get_dev_index();
+	}
+	memcpy(ent->ethaddr, ethaddr, ARP_HLEN);
+	ent->time = get_timer(0);
+}
+
+int arp_cache_lookup(struct in_addr ip, uchar *ethaddr)
+{
+	struct arp_entry *ent;
+
+	ent = arp_cache_find(arp_next_hop(ip));
+	if (!ent)
+		return -ENOENT;
+	memcpy(ethaddr, ent->ethaddr, ARP_HLEN);
+
+	return 0;
+}
+
+void arp_cache_flush(void)
+{
+	memset(arp_cache, '\0', sizeof(arp_cache));
+}
+
+void arp_cache_show(void)
+{
+	struct arp_entry *ent;
+
+	puts("IP address       MAC address        Device  Age (s)\n");
+	for (ent = arp_cache; ent < arp_cache + ARP_CACHE_SIZE; ent++) {
+		if (!ent->ip.s_addr)
+			continue;
+		printf("%-15pI4  %pM  %-6d  %lu\n", &ent->ip, ent->ethaddr,
+		       ent->dev_index, get_timer(ent->time) / 1000);
+	}
+}
+
+void arp_prefetch(struct in_addr ip)
+{
+	if (!ip.s_addr || !net_ip.s_addr)
+		return;
+	ip = arp_next_hop(ip);
+	if (arp_cache_find(ip))
+		return;
+
+	debug_cond(DEBUG_DEV_PKT, "ARP prefetch %pI4\n", &ip);
+	arp_raw_request(net_ip, net_null_ethaddr, ip);
+}
+
+void arp_request(void)
+{
+	if ((net_arp_wait_packet_ip.s_addr & net_netmask.s_addr) !=
+	    (net_ip.s_addr & net_netmask.s_addr) && net_gateway.s_addr == 0)
+		puts("## Warning: gatewayip needed but not set\n");
+	net_arp_wait_reply_ip = arp_next_hop(net_arp_wait_packet_ip);
+
 	arp_raw_request(net_ip, net_null_ethaddr, net_arp_wait_reply_ip);
 }
 
@@ -124,7 +238,7 @@ int arp_timeout_check(void)
 void arp_receive(struct ethernet_hdr *et, struct ip_udp_hdr *ip, int len)
 {
 	struct arp_hdr *arp;
-	struct in_addr reply_ip_addr;
+	struct in_addr reply_ip_addr, sender_ip;
 	int eth_hdr_size;
 
 	/*
@@ -155,6 +269,16 @@ void arp_receive(struct ethernet_hdr *et, struct ip_udp_hdr *ip, int len)
 	if (net_ip.s_addr == 0)
 		return;
 
+	/*
+	 * Any ARP packet, including a gratuitous one, refreshes an address
+	 * already in the cache; one sent to us also adds its sender (RFC 826)
+	 */
+	sender_ip = net_read_ip(&arp->ar_spa);
+	if (sender_ip.s_addr && sender_ip.s_addr != net_ip.s_addr)
+		arp_cache_update(sender_ip, &arp->ar_sha,
+				 net_read_ip(&arp->ar_tpa).s_addr ==
+				 net_ip.s_addr);
+
 	if (net_read_ip(&arp->ar_tpa).s_addr != net_ip.s_addr)
 		return;
 
@@ -21,6 +21,10 @@
 #ifdef CONFIG_BOOTP_RANDOM_DELAY
 #include "net_rand.h"
 #endif
+#ifdef CONFIG_DHCP_INIT_REBOOT
+#include <dm.h>
+#include <rtc.h>
+#endif
 
 #define BOOTP_VENDOR_MAGIC	0x63825363	/* RFC1048 Magic Cookie */
 
@@ -70,8 +74,16 @@ static struct in_addr dhcp_server_ip;
 static u8 dhcp_option_overload;
 #define OVERLOAD_FILE 1
 #define OVERLOAD_SNAME 2
+#define DHCP_ARP_WAIT		100	/* ms to wait for prefetched addresses */
+#define DHCP_ARP_POLL		5	/* ms between checks for them */
+static ulong dhcp_arp_wait_start;
 static void dhcp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			unsigned src, unsigned len);
+#ifdef CONFIG_DHCP_INIT_REBOOT
+#define DHCP_REBOOT_TRIES	3	/* REQUESTs before a full exchange */
+static struct in_addr dhcp_reboot_ip;
+static int dhcp_reboot_try;
+#endif
 
 /* For Debug */
 #if 0
@@ -694,6 +706,22 @@ void bootp_reset(void)
 	bootp_timeout = 250;
 }
 
+/* Make a new transaction ID: our MAC address plus the time, in ms */
+static u32 bootp_new_id(void)
+{
+	u32 bootp_id;
+
+	bootp_id = ((u32)net_ethaddr[2] << 24)
+		| ((u32)net_ethaddr[3] << 16)
+		| ((u32)net_ethaddr[4] << 8)
+		| (u32)net_ethaddr[5];
+	bootp_id += get_timer(0);
+	bootp_id = htonl(bootp_id);
+	bootp_add_id(bootp_id);
+
+	return bootp_id;
+}
+
 void bootp_request(void)
 {
 	uchar *pkt, *iphdr;
@@ -782,13 +810,7 @@ void bootp_request(void)
 	 *	Bootp ID is the lower 4 bytes of our ethernet address
 	 *	plus the current time in ms.
 	 */
-	bootp_id = ((u32)net_ethaddr[2] << 24)
-		| ((u32)net_ethaddr[3] << 16)
-		| ((u32)net_ethaddr[4] << 8)
-		| (u32)net_ethaddr[5];
-	bootp_id += get_timer(0);
-	bootp_id = htonl(bootp_id);
-	bootp_add_id(bootp_id);
+	bootp_id = bootp_new_id();
 	net_copy_u32(&bp->bp_id, &bootp_id);
 
 	/*
@@ -950,13 +972,17 @@ static int dhcp_message_type(unsigned char *popt)
 	return -1;
 }
 
-static void dhcp_send_request_packet(struct bootp_hdr *bp_offer)
+/*
+ * Broadcast a DHCPREQUEST for @requested_ip with transaction ID @id, naming
+ * @server_ip unless that is 0
+ */
+static void dhcp_send_request(u32 id, struct in_addr server_ip,
+			      struct in_addr requested_ip)
 {
 	uchar *pkt, *iphdr;
 	struct bootp_hdr *bp;
 	int pktlen, iplen, extlen;
 	int eth_hdr_size;
-	struct in_addr offered_ip;
 	struct in_addr zero_ip;
 	struct in_addr bcast_ip;
 
@@ -989,20 +1015,9 @@ static void dhcp_send_request_packet(struct bootp_hdr *bp_offer)
 	memcpy(bp->bp_chaddr, net_ethaddr, 6);
 	copy_filename(bp->bp_file, net_boot_file_name, sizeof(bp->bp_file));
 
-	/*
-	 * ID is the id of the OFFER packet
-	 */
-
-	net_copy_u32(&bp->bp_id, &bp_offer->bp_id);
-
-	/*
-	 * Copy options from OFFER packet if present
-	 */
-
-	/* Copy offered IP into the parameters request list */
-	net_copy_ip(&offered_ip, &bp_offer->bp_yiaddr);
+	net_copy_u32(&bp->bp_id, &id);
 	extlen = dhcp_extended((u8 *)bp->bp_vend, DHCP_REQUEST,
-		dhcp_server_ip, offered_ip);
+		server_ip, requested_ip);
 
 	iplen = BOOTP_HDR_SIZE - OPT_FIELD_SIZE + extlen;
 	pktlen = eth_hdr_size + IP_UDP_HDR_SIZE + iplen;
@@ -1016,6 +1031,146 @@ static void dhcp_send_request_packet(struct bootp_hdr *bp_offer)
 	net_send_packet(net_tx_packet, pktlen);
 }
 
+static void dhcp_send_request_packet(struct bootp_hdr *bp_offer)
+{
+	struct in_addr offered_ip;
+	u32 id;
+
+	/* ID is the id of the OFFER packet */
+	net_copy_u32(&id, &bp_offer->bp_id);
+
+	/* Copy offered IP into the parameters request list */
+	net_copy_ip(&offered_ip, &bp_offer->bp_yiaddr);
+	dhcp_send_request(id, dhcp_server_ip, offered_ip);
+}
+
+#ifdef CONFIG_DHCP_INIT_REBOOT
+/* Seconds since 1970 from the RTC, or 0 if there is none */
+static ulong dhcp_lease_clock(void)
+{
+#if defined(CONFIG_CMD_DATE)
+	struct rtc_time tm;
+#  ifdef CONFIG_DM_RTC
+	struct udevice *dev;
+
+	if (uclass_get_device(UCLASS_RTC, 0, &dev) || dm_rtc_get(dev, &tm))
+		return 0;
+#  else
+	if (rtc_get(&tm))
+		return 0;
+#  endif
+	return rtc_mktime(&tm);
+#else
+	return 0;
+#endif
+}
+
+/*
+ * The lease is kept in "dhcplease" as "<address> <server> <expiry>", the
+ * expiry being in RTC seconds, or 0 if not known. Return the expiry.
+ */
+static ulong dhcp_lease_expiry(const char *lease)
+{
+	const char *p = strrchr(lease, ' ');
+
+	return p ? simple_strtoul(p + 1, NULL, 10) : 0;
+}
+
+/* Check whether a lease has expired, if the RTC can tell */
+static bool dhcp_lease_expired(const char *lease)
+{
+	ulong expiry = dhcp_lease_expiry(lease);
+	ulong now;
+
+	if (!expiry)
+		return false;
+	now = dhcp_lease_clock();
+
+	return now && now >= expiry;
+}
+
+/* Remember the lease just given, for the next dhcp command */
+static void dhcp_lease_store(void)
+{
+	const char *old = getenv("dhcplease");
+	char lease[48];
+	ulong now, expiry = 0;
+	u32 secs = ntohl(dhcp_leasetime);
+	bool changed;
+	int len;
+
+	now = dhcp_lease_clock();
+	if (now && secs && secs != 0xffffffff)
+		expiry = now + secs;
+	len = snprintf(lease, sizeof(lease), "%pI4 %pI4 ", &net_ip,
+		       &dhcp_server_ip);
+	changed = !old || strncmp(old, lease, len) || dhcp_lease_expired(old);
+	snprintf(lease + len, sizeof(lease) - len, "%lu", expiry);
+	setenv("dhcplease", lease);
+
+#ifdef CONFIG_DHCP_LEASE_SAVEENV
+	if (changed)
+		saveenv();
+#endif
+	debug("DHCP lease %s%s\n", lease, changed ? " (new)" : "");
+}
+
+static void dhcp_reboot_timeout_handler(void);
+
+/* Ask for the address we had last time, without waiting for offers */
+static void dhcp_reboot_request(void)
+{
+	struct in_addr zero_ip;
+
+	printf("DHCP request for %pI4 %d\n", &dhcp_reboot_ip,
+	       ++dhcp_reboot_try);
+	zero_ip.s_addr = 0;
+	dhcp_state = REBOOTING;
+	net_set_timeout_handler(bootp_timeout, dhcp_reboot_timeout_handler);
+	net_set_udp_handler(dhcp_handler);
+	/* The server must not be named in the INIT-REBOOT state */
+	dhcp_send_request(bootp_new_id(), zero_ip, dhcp_reboot_ip);
+}
+
+static void dhcp_reboot_timeout_handler(void)
+{
+	if (dhcp_reboot_try >= DHCP_REBOOT_TRIES) {
+		puts("No reply; asking for a new address\n");
+		bootp_reset();
+		bootp_request();
+		return;
+	}
+	bootp_timeout *= 2;
+	dhcp_reboot_request();
+}
+#endif /* CONFIG_DHCP_INIT_REBOOT */
+
+/* Check whether the ARP requests sent on binding are still unanswered */
+static bool dhcp_arp_pending(void)
+{
+	uchar ethaddr[ARP_HLEN];
+
+	return (net_gateway.s_addr &&
+		arp_cache_lookup(net_gateway, ethaddr)) ||
+	       (net_server_ip.s_addr &&
+		arp_cache_lookup(net_server_ip, ethaddr));
+}
+
+/*
+ * Give the replies to the ARP requests sent on binding a moment to arrive,
+ * so that they are cached for the next command, then carry on
+ */
+static void dhcp_arp_wait_handler(void)
+{
+	if (dhcp_arp_pending() &&
+	    get_timer(dhcp_arp_wait_start) < DHCP_ARP_WAIT) {
+		net_set_timeout_handler(DHCP_ARP_POLL, dhcp_arp_wait_handler);
+		return;
+	}
+
+	net_auto_load();
+}
+
 /*
  *	Handle DHCP received packets.
  */
@@ -1034,6 +1189,18 @@ static void dhcp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 	debug("DHCPHandler: got DHCP packet: (src=%d, dst=%d, len=%d) state: "
 	      "%d\n", src, dest, len, dhcp_state);
 
+#ifdef CONFIG_DHCP_INIT_REBOOT
+	if (dhcp_state == REBOOTING &&
+	    dhcp_message_type((u8 *)bp->bp_vend) == DHCP_NAK) {
+		printf("DHCP refused %pI4; asking for a new address\n",
+		       &dhcp_reboot_ip);
+		setenv("dhcplease", NULL);
+		bootp_reset();
+		bootp_request();
+		return;
+	}
+#endif
+
 	if (net_read_ip(&bp->bp_yiaddr).s_addr == 0)
 		return;
 
@@ -1065,6 +1232,13 @@ static void dhcp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 
 		return;
 		break;
+#ifdef CONFIG_DHCP_INIT_REBOOT
+	case REBOOTING:
+		debug("DHCP State: REBOOTING\n");
+		if (dhcp_message_type((u8 *)bp->bp_vend) == DHCP_ACK)
+			efi_net_set_dhcp_ack(pkt, len);
+		/* fall through */
+#endif
 	case REQUESTING:
 		debug("DHCP State: REQUESTING\n");
 
@@ -1073,13 +1247,20 @@ static void dhcp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			/* Store net params from reply */
 			store_net_params(bp);
 			dhcp_state = BOUND;
+#ifdef CONFIG_DHCP_INIT_REBOOT
+			dhcp_lease_store();
+#endif
 			printf("DHCP client bound to address %pI4 (%lu ms)\n",
 			       &net_ip, get_timer(bootp_start));
 			net_set_timeout_handler(0, (thand_f *)0);
 			bootstage_mark_name(BOOTSTAGE_ID_BOOTP_STOP,
 					    "bootp_stop");
 
-			net_auto_load();
+			/* The next command will need these, so ask now */
+			arp_prefetch(net_gateway);
+			arp_prefetch(net_server_ip);
+			dhcp_arp_wait_start = get_timer(0);
+			dhcp_arp_wait_handler();
 			return;
 		}
 		break;
@@ -1094,6 +1275,20 @@ static void dhcp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 
 void dhcp_request(void)
 {
+#ifdef CONFIG_DHCP_INIT_REBOOT
+	const char *lease = getenv("dhcplease");
+
+	if (lease && !dhcp_lease_expired(lease)) {
+		dhcp_reboot_ip = string_to_ip(lease);
+		if (dhcp_reboot_ip.s_addr) {
+			bootstage_mark_name(BOOTSTAGE_ID_BOOTP_START,
+					    "bootp_start");
+			dhcp_reboot_try = 0;
+			dhcp_reboot_request();
+			return;
+		}
+	}
+#endif
 	bootp_request();
 }
 #endif	/* CONFIG_CMD_DHCP */
@@ -10,30 +10,85 @@
 
 #include <common.h>
 #include <net.h>
+#include <asm/unaligned.h>
 
-unsigned compute_ip_checksum(const void *vptr, unsigned nbytes)
+/*
+ * Add up a buffer as 16-bit words in the CPU's byte order. The words are
+ * loaded 32 bits at a time into a 64-bit total which is folded at the end;
+ * the one's complement sum is the same whichever width is used.
+ */
+static u64 ip_checksum_add(const void *vptr, unsigned nbytes, u64 sum)
 {
-	int sum, oddbyte;
-	const unsigned short *ptr = vptr;
+	const u8 *ptr = vptr;
 
-	sum = 0;
-	while (nbytes > 1) {
-		sum += *ptr++;
+	if ((ulong)ptr & 1) {
+		/* unaligned, which callers should avoid */
+		for (; nbytes > 1; ptr += 2, nbytes -= 2)
+			sum += get_unaligned((const u16 *)ptr);
+	} else if (((ulong)ptr & 2) && nbytes > 1) {
+		sum += *(const u16 *)ptr;
+		ptr += 2;
+		nbytes -= 2;
+	}
+	while (nbytes >= 16) {
+		const u32 *p32 = (const u32 *)ptr;
+
+		sum += p32[0];
+		sum += p32[1];
+		sum += p32[2];
+		sum += p32[3];
+		ptr += 16;
+		nbytes -= 16;
+	}
+	while (nbytes >= 4) {
+		sum += *(const u32 *)ptr;
+		ptr += 4;
+		nbytes -= 4;
+	}
+	if (nbytes >= 2) {
+		sum += *(const u16 *)ptr;
+		ptr += 2;
 		nbytes -= 2;
 	}
 	if (nbytes == 1) {
-		oddbyte = 0;
-		((u8 *)&oddbyte)[0] = *(u8 *)ptr;
-		((u8 *)&oddbyte)[1] = 0;
+		u16 oddbyte = 0;
+
+		((u8 *)&oddbyte)[0] = *ptr;
 		sum += oddbyte;
 	}
-	sum = (sum >> 16) + (sum & 0xffff);
-	sum += (sum >> 16);
-	sum = ~sum & 0xffff;
 
 	return sum;
 }
 
+/* Fold a sum from ip_checksum_add() to 16 bits and invert it */
+static unsigned ip_checksum_fold(u64 sum)
+{
+	sum = (sum >> 32) + (sum & 0xffffffff);
+	sum = (sum >> 32) + (sum & 0xffffffff);
+	sum = (sum >> 16) + (sum & 0xffff);
+	sum = (sum >> 16) + (sum & 0xffff);
+
+	return ~sum & 0xffff;
+}
+
+unsigned compute_ip_checksum(const void *vptr, unsigned nbytes)
+{
+	return ip_checksum_fold(ip_checksum_add(vptr, nbytes, 0));
+}
+
+unsigned compute_udp_checksum(const struct ip_udp_hdr *ip, unsigned udp_len)
+{
+	u64 sum;
+
+	/* pseudo-header: source and destination address, protocol, length */
+	sum = ip_checksum_add(&ip->ip_src, 2 * sizeof(struct in_addr), 0);
+	sum += htons(ip->ip_p);
+	sum += htons(udp_len);
+	sum = ip_checksum_add(&ip->udp_src, udp_len, sum);
+
+	return ip_checksum_fold(sum);
+}
+
 unsigned add_ip_checksums(unsigned offset, unsigned sum, unsigned new)
 {
 	unsigned long checksum;
@@ -142,6 +142,18 @@ unsigned char *eth_get_ethaddr(void)
 	return NULL;
 }
 
+int eth_get_offload(void)
+{
+	struct eth_pdata *pdata;
+
+	if (eth_get_dev()) {
+		pdata = eth_get_dev()->platdata;
+		return pdata->offload;
+	}
+
+	return 0;
+}
+
 /* Set active state without calling start on the driver */
 int eth_init_state_only(void)
 {
@@ -347,6 +359,40 @@ int eth_send(void *packet, int length)
 	return ret;
 }
 
+int eth_send_batch(struct eth_pkt *pkts, int count)
+{
+	struct udevice *current;
+	struct eth_ops *ops;
+	int ret;
+	int i;
+
+	current = eth_get_dev();
+	if (!current)
+		return -ENODEV;
+
+	if (!device_active(current))
+		return -EINVAL;
+
+	ops = eth_get_ops(current);
+	if (ops->send_batch) {
+		ret = ops->send_batch(current, pkts, count);
+		if (ret < 0)
+			debug("%s: send_batch() returned error %d\n", __func__,
+			      ret);
+		return ret;
+	}
+
+	for (i = 0; i < count; i++) {
+		ret = ops->send(current, pkts[i].packet, pkts[i].length);
+		if (ret < 0) {
+			debug("%s: send() returned error %d\n", __func__, ret);
+			return i ? i : ret;
+		}
+	}
+
+	return count;
+}
+
 int eth_rx(void)
 {
 	struct udevice *current;
@@ -538,6 +584,9 @@ static int eth_pre_remove(struct udevice *dev)
 	/* clear the MAC address */
 	memset(pdata->enetaddr, 0, ARP_HLEN);
 
+	/* device indexes may be reused for other networks */
+	arp_cache_flush();
+
 	return 0;
 }
 
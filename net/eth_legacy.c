@@ -390,6 +390,27 @@ int eth_send(void *packet, int length)
 	return eth_current->send(eth_current, packet, length);
 }
 
+int eth_send_batch(struct eth_pkt *pkts, int count)
+{
+	int ret;
+	int i;
+
+	if (!eth_current)
+		return -ENODEV;
+
+	if (eth_current->send_batch)
+		return eth_current->send_batch(eth_current, pkts, count);
+
+	for (i = 0; i < count; i++) {
+		ret = eth_current->send(eth_current, pkts[i].packet,
+					pkts[i].length);
+		if (ret < 0)
+			return i ? i : ret;
+	}
+
+	return count;
+}
+
 int eth_rx(void)
 {
 	if (!eth_current)
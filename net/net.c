@@ -87,6 +87,7 @@
 #include <environment.h>
 #include <errno.h>
 #include <net.h>
+#include <net/tcp.h>
 #include <net/tftp.h>
 #if defined(CONFIG_LED_STATUS)
 #include <miiphy.h>
@@ -107,6 +108,9 @@
 #if defined(CONFIG_CMD_SNTP)
 #include "sntp.h"
 #endif
+#if defined(CONFIG_CMD_WGET)
+#include "wget.h"
+#endif
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -195,6 +199,9 @@ static thand_f *time_handler;
 static ulong	time_start;
 /* Current timeout value */
 static ulong	time_delta;
+/* IP reassembly, set up for each net_loop() */
+static void net_defrag_reset(void);
+static void net_defrag_report(void);
 /* THE transmit packet */
 uchar *net_tx_packet;
 
@@ -402,6 +409,7 @@ int net_loop(enum proto_t protocol)
 
 	bootstage_mark_name(BOOTSTAGE_ID_ETH_START, "eth_start");
 	net_init();
+	net_defrag_reset();
 	if (eth_is_on_demand_init() || protocol != NETCONS) {
 		eth_halt();
 		eth_set_current();
@@ -484,6 +492,11 @@ restart:
 			nfs_start();
 			break;
 #endif
+#if defined(CONFIG_CMD_WGET)
+		case WGET:
+			wget_start();
+			break;
+#endif
 #if defined(CONFIG_CMD_CDP)
 		case CDP:
 			cdp_start();
@@ -643,6 +656,7 @@ restart:
 	}
 
 done:
+	net_defrag_report();
 #ifdef CONFIG_USB_KEYBOARD
 	net_busy_flag = 0;
 #endif
@@ -779,10 +793,6 @@ void net_set_timeout_handler(ulong iv, thand_f *f)
 int net_send_udp_packet(uchar *ether, struct in_addr dest, int dport, int sport,
 		int payload_len)
 {
-	uchar *pkt;
-	int eth_hdr_size;
-	int pkt_hdr_size;
-
 	/* make sure the net_tx_packet is initialized (net_init() was called) */
 	assert(net_tx_packet != NULL);
 	if (net_tx_packet == NULL)
@@ -792,16 +802,23 @@ int net_send_udp_packet(uchar *ether, struct in_addr dest, int dport, int sport,
 	if (dest.s_addr == 0)
 		dest.s_addr = 0xFFFFFFFF;
 
+	net_set_udp_header(net_tx_packet + net_eth_hdr_size(), dest, dport,
+			   sport, payload_len);
+
+	return net_send_ip_packet(ether, dest, IP_UDP_HDR_SIZE + payload_len);
+}
+
+int net_send_ip_packet(uchar *ether, struct in_addr dest, int len)
+{
+	int eth_hdr_size;
+
 	/* if broadcast, make the ether address a broadcast and don't do ARP */
 	if (dest.s_addr == 0xFFFFFFFF)
 		ether = (uchar *)net_bcast_ethaddr;
+	else if (memcmp(ether, net_null_ethaddr, 6) == 0)
+		arp_cache_lookup(dest, ether);	/* an earlier command's ARP */
 
-	pkt = (uchar *)net_tx_packet;
-
-	eth_hdr_size = net_set_ether(pkt, ether, PROT_IP);
-	pkt += eth_hdr_size;
-	net_set_udp_header(pkt, dest, dport, sport, payload_len);
-	pkt_hdr_size = eth_hdr_size + IP_UDP_HDR_SIZE;
+	eth_hdr_size = net_set_ether(net_tx_packet, ether, PROT_IP);
 
 	/* if MAC address was not discovered yet, do an ARP request */
 	if (memcmp(ether, net_null_ethaddr, 6) == 0) {
@@ -812,7 +829,7 @@ int net_send_udp_packet(uchar *ether, struct in_addr dest, int dport, int sport,
 		arp_wait_packet_ethaddr = ether;
 
 		/* size of the waiting packet */
-		arp_wait_tx_packet_size = pkt_hdr_size + payload_len;
+		arp_wait_tx_packet_size = eth_hdr_size + len;
 
 		/* and do the ARP request */
 		arp_wait_try = 1;
@@ -820,9 +837,9 @@ int net_send_udp_packet(uchar *ether, struct in_addr dest, int dport, int sport,
 		arp_request();
 		return 1;	/* waiting */
 	} else {
-		debug_cond(DEBUG_DEV_PKT, "sending UDP to %pI4/%pM\n",
+		debug_cond(DEBUG_DEV_PKT, "sending IP to %pI4/%pM\n",
 			   &dest, ether);
-		net_send_packet(net_tx_packet, pkt_hdr_size + payload_len);
+		net_send_packet(net_tx_packet, eth_hdr_size + len);
 		return 0;	/* transmitted */
 	}
 }
@@ -852,33 +869,134 @@ struct hole {
 	u16 unused;
 };
 
+/**
+ * struct defrag_ctx - A datagram being reassembled
+ *
+ * @pkt_buff:	The datagram, starting with the IP header of its first fragment
+ * @first_hole:	Index of the first hole descriptor in the payload
+ * @total_len:	Payload length once the last fragment is seen, 0xffff before
+ *		that, 0 if the context is free
+ * @last_time:	get_timer() value when the last fragment was received
+ */
+struct defrag_ctx {
+	uchar pkt_buff[IP_PKTSIZE] __aligned(PKTALIGN);
+	u16 first_hole;
+	u16 total_len;
+	ulong last_time;
+};
+
+static struct defrag_ctx defrag_ctx[CONFIG_NET_DEFRAG_SLOTS];
+static struct net_defrag_stats defrag_stats;
+
+void net_defrag_get_stats(struct net_defrag_stats *stats)
+{
+	*stats = defrag_stats;
+}
+
+/* Forget any partly reassembled datagrams and clear the counters */
+static void net_defrag_reset(void)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_NET_DEFRAG_SLOTS; i++)
+		defrag_ctx[i].total_len = 0;
+	memset(&defrag_stats, '\0', sizeof(defrag_stats));
+}
+
+/* Report datagrams which could not be reassembled */
+static void net_defrag_report(void)
+{
+	struct net_defrag_stats *st = &defrag_stats;
+
+	if (st->dropped || st->timeouts || st->evictions)
+		printf("IP reassembly: %lu datagrams, %lu fragments dropped, %lu timed out, %lu evicted\n",
+		       st->reassembled, st->dropped, st->timeouts,
+		       st->evictions);
+}
+
+/*
+ * Find the context for the datagram a fragment belongs to, by ID, addresses
+ * and protocol as RFC791 requires. Contexts which have waited too long are
+ * freed on the way. A new datagram takes a free context, or the least
+ * recently used one.
+ */
+static struct defrag_ctx *net_defrag_find(struct ip_udp_hdr *ip)
+{
+	struct defrag_ctx *ctx, *found = NULL, *victim = NULL;
+	ulong now = get_timer(0);
+
+	for (ctx = defrag_ctx; ctx < defrag_ctx + CONFIG_NET_DEFRAG_SLOTS;
+	     ctx++) {
+		struct ip_udp_hdr *localip = (struct ip_udp_hdr *)ctx->pkt_buff;
+
+		if (ctx->total_len &&
+		    now - ctx->last_time > CONFIG_NET_DEFRAG_TIMEOUT) {
+			ctx->total_len = 0;
+			defrag_stats.timeouts++;
+		}
+		if (!ctx->total_len) {
+			if (!victim || victim->total_len)
+				victim = ctx;
+			continue;
+		}
+		if (localip->ip_id == ip->ip_id &&
+		    localip->ip_p == ip->ip_p &&
+		    net_read_ip(&localip->ip_src).s_addr ==
+		    net_read_ip(&ip->ip_src).s_addr &&
+		    net_read_ip(&localip->ip_dst).s_addr ==
+		    net_read_ip(&ip->ip_dst).s_addr)
+			found = ctx;
+		else if (!victim || (victim->total_len &&
+			 ctx->last_time < victim->last_time))
+			victim = ctx;
+	}
+	if (found)
+		ctx = found;
+	else
+		ctx = victim;
+	if (!found && ctx->total_len) {
+		ctx->total_len = 0;
+		defrag_stats.evictions++;
+	}
+	ctx->last_time = now;
+
+	return ctx;
+}
+
 static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 {
-	static uchar pkt_buff[IP_PKTSIZE] __aligned(PKTALIGN);
-	static u16 first_hole, total_len;
+	struct defrag_ctx *ctx;
+	uchar *pkt_buff;
 	struct hole *payload, *thisfrag, *h, *newh;
-	struct ip_udp_hdr *localip = (struct ip_udp_hdr *)pkt_buff;
+	struct ip_udp_hdr *localip;
 	uchar *indata = (uchar *)ip;
 	int offset8, start, len, done = 0;
 	u16 ip_off = ntohs(ip->ip_off);
 
-	/* payload starts after IP header, this fragment is in there */
-	payload = (struct hole *)(pkt_buff + IP_HDR_SIZE);
 	offset8 =  (ip_off & IP_OFFS);
-	thisfrag = payload + offset8;
 	start = offset8 * 8;
 	len = ntohs(ip->ip_len) - IP_HDR_SIZE;
 
-	if (start + len > IP_MAXUDP) /* fragment extends too far */
+	if (start + len > IP_MAXUDP) { /* fragment extends too far */
+		defrag_stats.dropped++;
 		return NULL;
+	}
+
+	ctx = net_defrag_find(ip);
+	pkt_buff = ctx->pkt_buff;
+	localip = (struct ip_udp_hdr *)pkt_buff;
 
-	if (!total_len || localip->ip_id != ip->ip_id) {
-		/* new (or different) packet, reset structs */
-		total_len = 0xffff;
+	/* payload starts after IP header, this fragment is in there */
+	payload = (struct hole *)(pkt_buff + IP_HDR_SIZE);
+	thisfrag = payload + offset8;
+
+	if (!ctx->total_len) {
+		/* new packet, reset structs */
+		ctx->total_len = 0xffff;
 		payload[0].last_byte = ~0;
 		payload[0].next_hole = 0;
 		payload[0].prev_hole = 0;
-		first_hole = 0;
+		ctx->first_hole = 0;
 		/* any IP header will work, copy the first we received */
 		memcpy(localip, ip, IP_HDR_SIZE);
 	}
@@ -890,10 +1008,11 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 	 * so it is represented as byte count, not as 8-byte blocks.
 	 */
 
-	h = payload + first_hole;
+	h = payload + ctx->first_hole;
 	while (h->last_byte < start) {
 		if (!h->next_hole) {
 			/* no hole that far away */
+			defrag_stats.dropped++;
 			return NULL;
 		}
 		h = payload + h->next_hole;
@@ -902,12 +1021,13 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 	/* last fragment may be 1..7 bytes, the "+7" forces acceptance */
 	if (offset8 + ((len + 7) / 8) <= h - payload) {
 		/* no overlap with holes (dup fragment?) */
+		defrag_stats.dropped++;
 		return NULL;
 	}
 
 	if (!(ip_off & IP_FLAGS_MFRAG)) {
 		/* no more fragmentss: truncate this (last) hole */
-		total_len = start + len;
+		ctx->total_len = start + len;
 		h->last_byte = start + len;
 	}
 
@@ -924,7 +1044,7 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 			done = 1;
 		} else if (!h->prev_hole) {
 			/* first hole */
-			first_hole = h->next_hole;
+			ctx->first_hole = h->next_hole;
 			payload[h->next_hole].prev_hole = 0;
 		} else if (!h->next_hole) {
 			/* last hole */
@@ -949,7 +1069,7 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 		if (h->prev_hole)
 			payload[h->prev_hole].next_hole = (h - payload);
 		else
-			first_hole = (h - payload);
+			ctx->first_hole = (h - payload);
 
 	} else {
 		/* fragment sits in the middle: split the hole */
@@ -967,8 +1087,10 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 	if (!done)
 		return NULL;
 
-	localip->ip_len = htons(total_len);
-	*lenp = total_len + IP_HDR_SIZE;
+	localip->ip_len = htons(ctx->total_len);
+	*lenp = ctx->total_len + IP_HDR_SIZE;
+	ctx->total_len = 0;
+	defrag_stats.reassembled++;
 	return localip;
 }
 
@@ -991,6 +1113,14 @@ static inline struct ip_udp_hdr *net_defragment(struct ip_udp_hdr *ip,
 		return ip; /* not a fragment */
 	return NULL;
 }
+
+static inline void net_defrag_reset(void)
+{
+}
+
+static inline void net_defrag_report(void)
+{
+}
 #endif
 
 /**
@@ -1029,10 +1159,11 @@ static void receive_icmp(struct ip_udp_hdr *ip, int len,
 void net_process_received_packet(uchar *in_packet, int len)
 {
 	struct ethernet_hdr *et;
-	struct ip_udp_hdr *ip;
+	struct ip_udp_hdr *ip, *frag;
 	struct in_addr dst_ip;
 	struct in_addr src_ip;
 	int eth_proto;
+	int offload;
 #if defined(CONFIG_CMD_CDP)
 	int iscdp;
 #endif
@@ -1160,8 +1291,10 @@ void net_process_received_packet(uchar *in_packet, int len)
 		/* Can't deal with IP options (headers != 20 bytes) */
 		if ((ip->ip_hl_v & 0x0f) > 0x05)
 			return;
-		/* Check the Checksum of the header */
-		if (!ip_checksum_ok((uchar *)ip, IP_HDR_SIZE)) {
+		/* Check the Checksum of the header, unless the MAC did */
+		offload = eth_get_offload();
+		if (!(offload & ETH_OFFLOAD_RX_CSUM) &&
+		    !ip_checksum_ok((uchar *)ip, IP_HDR_SIZE)) {
 			debug("checksum bad\n");
 			return;
 		}
@@ -1181,6 +1314,7 @@ void net_process_received_packet(uchar *in_packet, int len)
 		 * a fragment, and either the complete packet or NULL if
 		 * it is a fragment (if !CONFIG_IP_DEFRAG, it returns NULL)
 		 */
+		frag = ip;
 		ip = net_defragment(ip, &len);
 		if (!ip)
 			return;
@@ -1208,6 +1342,11 @@ void net_process_received_packet(uchar *in_packet, int len)
 		if (ip->ip_p == IPPROTO_ICMP) {
 			receive_icmp(ip, len, src_ip, et);
 			return;
+#ifdef CONFIG_NET_TCP
+		} else if (ip->ip_p == IPPROTO_TCP) {
+			tcp_receive(ip, len);
+			return;
+#endif
 		} else if (ip->ip_p != IPPROTO_UDP) {	/* Only UDP packets */
 			return;
 		}
@@ -1217,41 +1356,17 @@ void net_process_received_packet(uchar *in_packet, int len)
 			   &dst_ip, &src_ip, len);
 
 #ifdef CONFIG_UDP_CHECKSUM
-		if (ip->udp_xsum != 0) {
-			ulong   xsum;
-			ushort *sumptr;
-			ushort  sumlen;
-
-			xsum  = ip->ip_p;
-			xsum += (ntohs(ip->udp_len));
-			xsum += (ntohl(ip->ip_src.s_addr) >> 16) & 0x0000ffff;
-			xsum += (ntohl(ip->ip_src.s_addr) >>  0) & 0x0000ffff;
-			xsum += (ntohl(ip->ip_dst.s_addr) >> 16) & 0x0000ffff;
-			xsum += (ntohl(ip->ip_dst.s_addr) >>  0) & 0x0000ffff;
-
-			sumlen = ntohs(ip->udp_len);
-			sumptr = (ushort *)&(ip->udp_src);
-
-			while (sumlen > 1) {
-				ushort sumdata;
-
-				sumdata = *sumptr++;
-				xsum += ntohs(sumdata);
-				sumlen -= 2;
-			}
-			if (sumlen > 0) {
-				ushort sumdata;
+		/*
+		 * The MAC cannot check a datagram it only saw in fragments,
+		 * so check those after reassembly
+		 */
+		if (ip->udp_xsum != 0 &&
+		    (!(offload & ETH_OFFLOAD_RX_CSUM) || ip != frag)) {
+			unsigned xsum;
 
-				sumdata = *(unsigned char *)sumptr;
-				sumdata = (sumdata << 8) & 0xff00;
-				xsum += sumdata;
-			}
-			while ((xsum >> 16) != 0) {
-				xsum = (xsum & 0x0000ffff) +
-				       ((xsum >> 16) & 0x0000ffff);
-			}
-			if ((xsum != 0x00000000) && (xsum != 0x0000ffff)) {
-				printf(" UDP wrong checksum %08lx %08x\n",
+			xsum = compute_udp_checksum(ip, ntohs(ip->udp_len));
+			if (xsum != 0 && xsum != 0xffff) {
+				printf(" UDP wrong checksum %04x %04x\n",
 				       xsum, ntohs(ip->udp_xsum));
 				return;
 			}
@@ -1309,6 +1424,9 @@ static int net_check_prereq(enum proto_t protocol)
 #endif
 #if defined(CONFIG_CMD_NFS)
 	case NFS:
+#endif
+#if defined(CONFIG_CMD_WGET)
+	case WGET:
 #endif
 		/* Fall through */
 	case TFTPGET:
@@ -1463,7 +1581,8 @@ void net_set_udp_header(uchar *pkt, struct in_addr dest, int dport, int sport,
 	net_set_ip_header(pkt, dest, net_ip);
 	ip->ip_len   = htons(IP_UDP_HDR_SIZE + len);
 	ip->ip_p     = IPPROTO_UDP;
-	ip->ip_sum   = compute_ip_checksum(ip, IP_HDR_SIZE);
+	if (!(eth_get_offload() & ETH_OFFLOAD_TX_IP_CSUM))
+		ip->ip_sum = compute_ip_checksum(ip, IP_HDR_SIZE);
 
 	ip->udp_src  = htons(sport);
 	ip->udp_dst  = htons(dport);
@@ -31,6 +31,7 @@
 #include <net.h>
 #include <malloc.h>
 #include <mapmem.h>
+#include <net/rtt.h>
 #include "nfs.h"
 #include "bootp.h"
 
@@ -41,15 +42,16 @@
 #else
 # define NFS_TIMEOUT CONFIG_NFS_TIMEOUT
 #endif
+/* Longest timeout, after backing off */
+#define NFS_TIMEOUT_MAX	(NFS_TIMEOUT * 8)
 
 #define NFS_RPC_ERR	1
 #define NFS_RPC_DROP	124
 
 static int fs_mounted;
 static unsigned long rpc_id;
-static int nfs_offset = -1;
-static int nfs_len;
 static ulong nfs_timeout = NFS_TIMEOUT;
+static struct net_rtt nfs_rtt;
 
 static char dirfh[NFS_FHSIZE];	/* NFSv2 / NFSv3 file handle of directory */
 static char filefh[NFS3_FHSIZE]; /* NFSv2 / NFSv3 file handle */
@@ -78,6 +80,36 @@ static char nfs_path_buff[2048];
 #define NFSV3_FLAG 1 << 1
 static char supported_nfs_versions = NFSV2_FLAG | NFSV3_FLAG;
 
+/* Bytes received between each "loading" hash */
+#define NFS_HASH_BYTES	(NFS_READ_SIZE / 2 * 10)
+
+/* Words of an NFSv3 READ reply up to the data, the larger of v2 and v3 */
+#define NFS_READ_REPLY_WORDS	26
+
+/**
+ * struct nfs_read_slot - A READ request which is waiting for its reply
+ *
+ * @id:		RPC transaction ID of the request, 0 if the slot is free
+ * @offset:	File offset requested
+ * @len:	Number of bytes requested
+ * @sent:	timer_get_us() when the request was last sent
+ * @resent:	The request has been sent more than once, so its reply
+ *		cannot be timed
+ */
+struct nfs_read_slot {
+	ulong id;
+	uint offset;
+	uint len;
+	ulong sent;
+	bool resent;
+};
+
+static struct nfs_read_slot nfs_read_slots[NFS_READ_WINDOW];
+static int nfs_read_window;	/* number of slots in use, up to the window */
+static uint nfs_read_next;	/* next file offset to request */
+static uint nfs_read_end;	/* end of the file, once a reply shows it */
+static uint nfs_read_bytes;	/* bytes received, for the progress hashes */
+
 static inline int store_block(uchar *src, unsigned offset, unsigned len)
 {
 	ulong newsize = offset + len;
@@ -386,6 +418,78 @@ static void nfs_read_req(int offset, int readlen)
 	rpc_req(PROG_NFS, NFS_READ, data, len);
 }
 
+/* Send the READ for a slot, with a new transaction ID */
+static void nfs_read_send(struct nfs_read_slot *slot)
+{
+	slot->sent = timer_get_us();
+	nfs_read_req(slot->offset, slot->len);
+	slot->id = rpc_id;
+}
+
+/* Start reading the file from the beginning, one request at a time */
+static void nfs_read_start(void)
+{
+	memset(nfs_read_slots, '\0', sizeof(nfs_read_slots));
+	nfs_read_window = 1;
+	nfs_read_next = 0;
+	nfs_read_end = UINT_MAX;
+	nfs_read_bytes = 0;
+}
+
+/*
+ * Resend the requests which are still waiting, except those past the end of
+ * the file, then request the next parts of the file in any free slots
+ */
+static void nfs_read_fill(bool resend)
+{
+	struct nfs_read_slot *slot;
+
+	for (slot = nfs_read_slots; slot < nfs_read_slots + nfs_read_window;
+	     slot++) {
+		if (slot->id && slot->offset >= nfs_read_end)
+			slot->id = 0;
+		if (slot->id) {
+			if (resend) {
+				slot->resent = true;
+				nfs_read_send(slot);
+			}
+		} else if (nfs_read_next < nfs_read_end) {
+			slot->offset = nfs_read_next;
+			slot->len = NFS_READ_SIZE;
+			slot->resent = false;
+			nfs_read_next += NFS_READ_SIZE;
+			nfs_read_send(slot);
+		}
+	}
+}
+
+/* Check whether any READ requests are waiting for their reply */
+static bool nfs_read_busy(void)
+{
+	int i;
+
+	for (i = 0; i < nfs_read_window; i++) {
+		if (nfs_read_slots[i].id)
+			return true;
+	}
+
+	return false;
+}
+
+/* Print a hash for each NFS_HASH_BYTES received */
+static void nfs_read_progress(uint rlen)
+{
+	uint hashes = nfs_read_bytes / NFS_HASH_BYTES;
+
+	nfs_read_bytes += rlen;
+	while (hashes < nfs_read_bytes / NFS_HASH_BYTES) {
+		if (hashes && !(hashes % HASHES_PER_LINE))
+			puts("\n\t ");
+		putc('#');
+		hashes++;
+	}
+}
+
 /**************************************************************************
 RPC request dispatcher
 **************************************************************************/
@@ -416,7 +520,7 @@ static void nfs_send(void)
 		nfs_lookup_req(nfs_filename);
 		break;
 	case STATE_READ_REQ:
-		nfs_read_req(nfs_offset, nfs_len);
+		nfs_read_fill(true);
 		break;
 	case STATE_READLINK_REQ:
 		nfs_readlink_req();
@@ -652,20 +756,40 @@ static int nfs_readlink_reply(uchar *pkt, unsigned len)
 	return 0;
 }
 
+/*
+ * Store the data from a READ reply at the offset its request asked for, then
+ * ask for the rest if the server returned less than that. Replies may arrive
+ * in any order and only the header is copied out of the packet.
+ */
 static int nfs_read_reply(uchar *pkt, unsigned len)
 {
 	struct rpc_t rpc_pkt;
-	int rlen;
+	struct nfs_read_slot *slot;
+	unsigned hdr_len, data_off;
+	ulong id;
+	uint rlen;
+	bool eof = false;
 	uchar *data_ptr;
 
 	debug("%s\n", __func__);
 
-	memcpy(&rpc_pkt.u.data[0], pkt, sizeof(rpc_pkt.u.reply));
+	hdr_len = min_t(unsigned, len,
+			offsetof(struct rpc_t,
+				 u.reply.data[NFS_READ_REPLY_WORDS]));
+	memcpy(&rpc_pkt.u.data[0], pkt, hdr_len);
 
-	if (ntohl(rpc_pkt.u.reply.id) > rpc_id)
+	id = ntohl(rpc_pkt.u.reply.id);
+	if (id > rpc_id)
 		return -NFS_RPC_ERR;
-	else if (ntohl(rpc_pkt.u.reply.id) < rpc_id)
-		return -NFS_RPC_DROP;
+	for (slot = nfs_read_slots; slot < nfs_read_slots + nfs_read_window;
+	     slot++) {
+		if (slot->id == id)
+			break;
+	}
+	if (slot == nfs_read_slots + nfs_read_window)
+		return -NFS_RPC_DROP;	/* duplicate, or answered already */
+	if (!slot->resent)
+		net_rtt_sample(&nfs_rtt, timer_get_us() - slot->sent);
 
 	if (rpc_pkt.u.reply.rstatus  ||
 	    rpc_pkt.u.reply.verifier ||
@@ -678,12 +802,6 @@ static int nfs_read_reply(uchar *pkt, unsigned len)
 		return -ntohl(rpc_pkt.u.reply.data[0]);
 	}
 
-	if ((nfs_offset != 0) && !((nfs_offset) %
-			(NFS_READ_SIZE / 2 * 10 * HASHES_PER_LINE)))
-		puts("\n\t ");
-	if (!(nfs_offset % ((NFS_READ_SIZE / 2) * 10)))
-		putc('#');
-
 	if (supported_nfs_versions & NFSV2_FLAG) {
 		rlen = ntohl(rpc_pkt.u.reply.data[18]);
 		data_ptr = (uchar *)&(rpc_pkt.u.reply.data[19]);
@@ -693,16 +811,33 @@ static int nfs_read_reply(uchar *pkt, unsigned len)
 
 		/* count value */
 		rlen = ntohl(rpc_pkt.u.reply.data[1 + nfsv3_data_offset]);
-		/* Skip unused values :
-			EOF:		32 bits value,
+		eof = rpc_pkt.u.reply.data[2 + nfsv3_data_offset] != 0;
+		/* Skip unused value :
 			data_size:	32 bits value,
 		*/
 		data_ptr = (uchar *)
 			&(rpc_pkt.u.reply.data[4 + nfsv3_data_offset]);
 	}
 
-	if (store_block(data_ptr, nfs_offset, rlen))
+	data_off = data_ptr - &rpc_pkt.u.data[0];
+	if (data_off > hdr_len || rlen > slot->len ||
+	    rlen > len - data_off)
+		return -NFS_RPC_DROP;	/* truncated or not what we asked */
+
+	if (store_block(pkt + data_off, slot->offset, rlen))
 			return -9999;
+	nfs_read_progress(rlen);
+
+	/* NFSv2 has no EOF flag; reading nothing shows where the file ends */
+	if (eof || !rlen)
+		nfs_read_end = min(nfs_read_end, slot->offset + rlen);
+	slot->offset += rlen;
+	slot->len -= rlen;
+	slot->resent = false;
+	if (slot->len && slot->offset < nfs_read_end)
+		nfs_read_send(slot);
+	else
+		slot->id = 0;
 
 	return rlen;
 }
@@ -717,8 +852,8 @@ static void nfs_timeout_handler(void)
 		net_start_again();
 	} else {
 		puts("T ");
-		net_set_timeout_handler(nfs_timeout +
-					NFS_TIMEOUT * nfs_timeout_count,
+		net_rtt_backoff(&nfs_rtt);
+		net_set_timeout_handler(net_rtt_timeout(&nfs_rtt),
 					nfs_timeout_handler);
 		nfs_send();
 	}
@@ -773,6 +908,7 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			debug("*** ERROR: Cannot umount\n");
 			net_set_state(NETLOOP_FAIL);
 		} else {
+			net_rtt_report(&nfs_rtt);
 			puts("\ndone\n");
 			net_set_state(nfs_download_state);
 		}
@@ -796,8 +932,7 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			nfs_send();
 		} else {
 			nfs_state = STATE_READ_REQ;
-			nfs_offset = 0;
-			nfs_len = NFS_READ_SIZE;
+			nfs_read_start();
 			nfs_send();
 		}
 		break;
@@ -822,19 +957,27 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 
 	case STATE_READ_REQ:
 		rlen = nfs_read_reply(pkt, len);
-		net_set_timeout_handler(nfs_timeout, nfs_timeout_handler);
-		if (rlen > 0) {
-			nfs_offset += rlen;
-			nfs_send();
+		if (rlen == -NFS_RPC_DROP)
+			break;
+		/* Only give up after this many timeouts in a row */
+		nfs_timeout_count = 0;
+		net_set_timeout_handler(net_rtt_timeout(&nfs_rtt),
+					nfs_timeout_handler);
+		if (rlen >= 0) {
+			/* The file is readable, so open the window */
+			nfs_read_window = NFS_READ_WINDOW;
+			nfs_read_fill(false);
+			if (!nfs_read_busy()) {
+				nfs_download_state = NETLOOP_SUCCESS;
+				nfs_state = STATE_UMOUNT_REQ;
+				nfs_send();
+			}
 		} else if ((rlen == -NFSERR_ISDIR) || (rlen == -NFSERR_INVAL)) {
 			/* symbolic link */
 			nfs_state = STATE_READLINK_REQ;
 			nfs_send();
 		} else {
-			if (!rlen)
-				nfs_download_state = NETLOOP_SUCCESS;
-			if (rlen < 0)
-				debug("NFS READ error (%d)\n", rlen);
+			debug("NFS READ error (%d)\n", rlen);
 			nfs_state = STATE_UMOUNT_REQ;
 			nfs_send();
 		}
@@ -908,7 +1051,8 @@ void nfs_start(void)
 	}
 	debug("\nLoad address: 0x%lx\nLoading: *\b", load_addr);
 
-	net_set_timeout_handler(nfs_timeout, nfs_timeout_handler);
+	net_rtt_init(&nfs_rtt, nfs_timeout, NFS_TIMEOUT_MAX);
+	net_set_timeout_handler(net_rtt_timeout(&nfs_rtt), nfs_timeout_handler);
 	net_set_udp_handler(nfs_handler);
 
 	nfs_timeout_count = 0;
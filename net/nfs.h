@@ -38,15 +38,30 @@
 
 /* Block size used for NFS read accesses.  A RPC reply packet (including  all
  * headers) must fit within a single Ethernet frame to avoid fragmentation.
- * However, if CONFIG_IP_DEFRAG is set, the config file may want to use a
- * bigger value. In any case, most NFS servers are optimized for a power of 2.
+ * However, if CONFIG_IP_DEFRAG is set, the reply may be as large as the
+ * reassembly buffer (CONFIG_NET_MAXDEFRAG), less the RPC and NFS headers. In
+ * any case, most NFS servers are optimized for a power of 2.  A server which
+ * returns less than was asked for is simply asked for the rest.
  */
 #ifdef CONFIG_NFS_READ_SIZE
 #define NFS_READ_SIZE CONFIG_NFS_READ_SIZE
+#elif defined(CONFIG_IP_DEFRAG) && \
+	(!defined(CONFIG_NET_MAXDEFRAG) || CONFIG_NET_MAXDEFRAG >= 16384)
+#define NFS_READ_SIZE 8192
+#elif defined(CONFIG_IP_DEFRAG) && CONFIG_NET_MAXDEFRAG >= 8192
+#define NFS_READ_SIZE 4096
+#elif defined(CONFIG_IP_DEFRAG) && CONFIG_NET_MAXDEFRAG >= 4096
+#define NFS_READ_SIZE 2048
 #else
 #define NFS_READ_SIZE 1024 /* biggest power of two that fits Ether frame */
 #endif
 
+/* Number of READ requests sent before waiting for a reply.  Each reply may
+ * be several frames once fragmented, so the Ethernet driver must be able to
+ * receive NFS_READ_WINDOW * NFS_READ_SIZE bytes back to back.
+ */
+#define NFS_READ_WINDOW CONFIG_NFS_READ_WINDOW
+
 /* Values for Accept State flag on RPC answers (See: rfc1831) */
 enum rpc_accept_stat {
 	NFS_RPC_SUCCESS = 0,	/* RPC executed successfully */
@@ -76,7 +91,7 @@ struct rpc_t {
 			uint32_t verifier;
 			uint32_t v2;
 			uint32_t astatus;
-			uint32_t data[NFS_READ_SIZE];
+			uint32_t data[NFS_READ_SIZE / 4];
 		} reply;
 	} u;
 };
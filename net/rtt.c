@@ -0,0 +1,60 @@
+/*
+ * Round trip time estimation for retransmission over UDP, as RFC 6298
+ * describes for TCP
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <net/rtt.h>
+
+/* Timeouts are set in ms, so the deviation term is at least this, in us */
+#define RTT_GRANULARITY		1000
+
+static void net_rtt_update_rto(struct net_rtt *rtt)
+{
+	ulong rto;
+
+	rto = (rtt->srtt + max_t(ulong, RTT_GRANULARITY, 4 * rtt->rttvar) +
+	       999) / 1000;
+	rtt->rto = clamp_t(ulong, rto, CONFIG_NET_RTO_MIN, rtt->rto_max);
+}
+
+void net_rtt_init(struct net_rtt *rtt, ulong rto, ulong rto_max)
+{
+	memset(rtt, '\0', sizeof(*rtt));
+	rtt->rto_max = max_t(ulong, rto_max, CONFIG_NET_RTO_MIN);
+	rtt->rto = clamp_t(ulong, rto, CONFIG_NET_RTO_MIN, rtt->rto_max);
+}
+
+void net_rtt_sample(struct net_rtt *rtt, ulong us)
+{
+	ulong delta;
+
+	if (!rtt->samples++) {
+		rtt->srtt = us;
+		rtt->rttvar = us / 2;
+	} else {
+		delta = us > rtt->srtt ? us - rtt->srtt : rtt->srtt - us;
+		rtt->rttvar = rtt->rttvar - rtt->rttvar / 4 + delta / 4;
+		rtt->srtt = rtt->srtt - rtt->srtt / 8 + us / 8;
+	}
+	net_rtt_update_rto(rtt);
+}
+
+void net_rtt_backoff(struct net_rtt *rtt)
+{
+	rtt->retransmits++;
+	rtt->rto = min(rtt->rto * 2, rtt->rto_max);
+}
+
+void net_rtt_report(struct net_rtt *rtt)
+{
+	if (!rtt->samples && !rtt->retransmits)
+		return;
+	puts("\n\t ");	/* Line up with "Loading: " */
+	if (rtt->samples)
+		printf("RTT %lu.%03lu ms, timeout %lu ms, ", rtt->srtt / 1000,
+		       rtt->srtt % 1000, rtt->rto);
+	printf("%lu retransmitted", rtt->retransmits);
+}
@@ -0,0 +1,484 @@
+/*
+ * Minimal TCP client
+ *
+ * This supports one connection at a time, opened by U-Boot to download from
+ * a server. Data may arrive out of order: it is handed on to be stored where
+ * it belongs, and a duplicate ACK is sent at once so that the server resends
+ * the missing segment without waiting for its retransmit timer (fast
+ * retransmit, without SACK). The receive window is scaled so that enough
+ * data can be in flight to fill a long path.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <net.h>
+#include <net/tcp.h>
+
+/* Receive window, which is scaled to fit in the 16-bit header field */
+#ifndef CONFIG_TCP_RCV_WINDOW
+#define CONFIG_TCP_RCV_WINDOW	(256 * 1024)
+#endif
+
+#define TCP_RTO_INIT	1000	/* initial retransmit timeout, ms */
+#define TCP_RTO_MAX	8000	/* longest retransmit timeout, ms */
+#define TCP_RETRIES	10	/* timeouts in a row before giving up */
+#define TCP_HELD	8	/* ranges held beyond a gap */
+
+enum tcp_state {
+	TCP_CLOSED,
+	TCP_SYN_SENT,
+	TCP_ESTABLISHED,
+};
+
+/* Sequence numbers of data received beyond a gap, empty if start == end */
+struct tcp_range {
+	u32 start;
+	u32 end;
+};
+
+/**
+ * struct tcp_conn - State of the connection
+ *
+ * @state:	Connection state
+ * @dest:	Server address
+ * @dport:	Server port
+ * @sport:	Our port
+ * @rx:		Called with received data
+ * @event:	Called when the connection changes
+ * @iss:	Our initial sequence number
+ * @snd_una:	Oldest sequence number not acknowledged by the server
+ * @snd_nxt:	Next sequence number to send
+ * @snd_mss:	Largest segment the server accepts
+ * @tx_data:	Data being sent
+ * @tx_seq:	Sequence number of the first byte of @tx_data
+ * @tx_len:	Length of @tx_data
+ * @dup_acks:	Number of duplicate ACKs received for @snd_una
+ * @irs:	Server's initial sequence number
+ * @rcv_nxt:	Next sequence number expected from the server
+ * @rcv_wscale:	Shift applied to the window we advertise
+ * @fin_seen:	true if the server has sent FIN
+ * @fin_seq:	Sequence number of the server's FIN
+ * @held:	Data received beyond @rcv_nxt
+ * @rto:	Current retransmit timeout in ms
+ * @retries:	Number of timeouts in a row
+ * @stats:	Counters
+ */
+struct tcp_conn {
+	enum tcp_state state;
+	struct in_addr dest;
+	int dport;
+	int sport;
+	tcp_rx_f *rx;
+	tcp_event_f *event;
+
+	u32 iss;
+	u32 snd_una;
+	u32 snd_nxt;
+	uint snd_mss;
+	const uchar *tx_data;
+	u32 tx_seq;
+	uint tx_len;
+	int dup_acks;
+
+	u32 irs;
+	u32 rcv_nxt;
+	uint rcv_wscale;
+	bool fin_seen;
+	u32 fin_seq;
+	struct tcp_range held[TCP_HELD];
+
+	ulong rto;
+	int retries;
+	struct tcp_stats stats;
+};
+
+static struct tcp_conn conn;
+static uchar tcp_ethaddr[ARP_HLEN];
+
+static inline bool tcp_seq_lt(u32 a, u32 b)
+{
+	return (s32)(a - b) < 0;
+}
+
+static inline bool tcp_seq_le(u32 a, u32 b)
+{
+	return (s32)(a - b) <= 0;
+}
+
+/* Number of bytes of the stream received in order */
+static u32 tcp_stream_len(void)
+{
+	return conn.rcv_nxt - conn.irs - 1;
+}
+
+/* Shift needed to advertise the whole receive window */
+static uint tcp_wscale(void)
+{
+	uint shift;
+
+	for (shift = 0; (CONFIG_TCP_RCV_WINDOW >> shift) > 0xffff; shift++)
+		;
+
+	return min(shift, 14U);
+}
+
+static void tcp_send_segment(u8 flags, u32 seq, const uchar *data, uint len)
+{
+	uchar *pkt = net_tx_packet + net_eth_hdr_size();
+	struct ip_udp_hdr *ip = (struct ip_udp_hdr *)pkt;
+	struct tcp_hdr *tcp = (struct tcp_hdr *)(pkt + IP_HDR_SIZE);
+	uchar *opt = (uchar *)(tcp + 1);
+	uint hlen = TCP_HDR_SIZE;
+	u32 win, val;
+
+	if (flags & TCP_SYN) {
+		*opt++ = TCP_OPT_MSS;
+		*opt++ = 4;
+		*opt++ = TCP_MSS >> 8;
+		*opt++ = TCP_MSS & 0xff;
+		*opt++ = TCP_OPT_NOP;
+		*opt++ = TCP_OPT_WSCALE;
+		*opt++ = 3;
+		*opt++ = tcp_wscale();
+		hlen += 8;
+		/* the window in a SYN is never scaled */
+		win = min(CONFIG_TCP_RCV_WINDOW, 0xffff);
+	} else {
+		win = min(CONFIG_TCP_RCV_WINDOW >> conn.rcv_wscale, 0xffff);
+	}
+	if (len)
+		memcpy((uchar *)tcp + hlen, data, len);
+
+	net_set_ip_header(pkt, conn.dest, net_ip);
+	ip->ip_len = htons(IP_HDR_SIZE + hlen + len);
+	ip->ip_p = IPPROTO_TCP;
+	if (!(eth_get_offload() & ETH_OFFLOAD_TX_IP_CSUM))
+		ip->ip_sum = compute_ip_checksum(ip, IP_HDR_SIZE);
+
+	tcp->tcp_src = htons(conn.sport);
+	tcp->tcp_dst = htons(conn.dport);
+	val = htonl(seq);
+	net_copy_u32(&tcp->tcp_seq, &val);
+	val = flags & TCP_ACK ? htonl(conn.rcv_nxt) : 0;
+	net_copy_u32(&tcp->tcp_ack, &val);
+	tcp->tcp_hlen = (hlen / 4) << 4;
+	tcp->tcp_flags = flags;
+	tcp->tcp_win = htons(win);
+	tcp->tcp_xsum = 0;
+	tcp->tcp_urg = 0;
+	tcp->tcp_xsum = compute_udp_checksum(ip, hlen + len);
+
+	net_send_ip_packet(tcp_ethaddr, conn.dest, IP_HDR_SIZE + hlen + len);
+}
+
+static void tcp_send_ack(void)
+{
+	tcp_send_segment(TCP_ACK, conn.snd_nxt, NULL, 0);
+}
+
+/* Send our data from @seq onwards, in segments the server accepts */
+static void tcp_send_data(u32 seq)
+{
+	u32 end = conn.tx_seq + conn.tx_len;
+	uint len;
+
+	while (tcp_seq_lt(seq, end)) {
+		len = min(end - seq, conn.snd_mss);
+		tcp_send_segment(TCP_ACK | TCP_PSH, seq,
+				 conn.tx_data + (seq - conn.tx_seq), len);
+		seq += len;
+	}
+}
+
+static void tcp_timeout(void);
+
+/* The server is responding, so restart the retransmit timer */
+static void tcp_progress(void)
+{
+	conn.retries = 0;
+	conn.rto = TCP_RTO_INIT;
+	net_set_timeout_handler(conn.rto, tcp_timeout);
+}
+
+/* Forget the connection and tell the caller why */
+static void tcp_end(enum tcp_event event)
+{
+	conn.state = TCP_CLOSED;
+	net_set_timeout_handler(0, NULL);
+	conn.event(event, tcp_stream_len());
+}
+
+static void tcp_timeout(void)
+{
+	if (++conn.retries > TCP_RETRIES) {
+		puts("\nTCP: connection timed out\n");
+		tcp_end(TCP_EVENT_TIMEOUT);
+		return;
+	}
+	conn.rto = min(conn.rto * 2, (ulong)TCP_RTO_MAX);
+	net_set_timeout_handler(conn.rto, tcp_timeout);
+
+	if (conn.state == TCP_SYN_SENT) {
+		tcp_send_segment(TCP_SYN, conn.iss, NULL, 0);
+	} else if (conn.snd_una != conn.snd_nxt) {
+		conn.stats.retransmits++;
+		tcp_send_data(conn.snd_una);
+	} else {
+		/* Nothing is arriving; repeat our ACK in case it was lost */
+		tcp_send_ack();
+	}
+}
+
+void tcp_connect(struct in_addr dest, int dport, tcp_rx_f *rx,
+		 tcp_event_f *event)
+{
+	memset(&conn, '\0', sizeof(conn));
+	memset(tcp_ethaddr, '\0', ARP_HLEN);
+	conn.dest = dest;
+	conn.dport = dport;
+	conn.sport = random_port();
+	conn.rx = rx;
+	conn.event = event;
+	conn.iss = (u32)get_ticks();
+	conn.snd_una = conn.iss;
+	conn.snd_nxt = conn.iss + 1;
+	conn.snd_mss = 536;	/* the default if the server gives none */
+	conn.state = TCP_SYN_SENT;
+
+	tcp_progress();
+	tcp_send_segment(TCP_SYN, conn.iss, NULL, 0);
+}
+
+int tcp_send(const void *data, unsigned len)
+{
+	if (conn.state != TCP_ESTABLISHED)
+		return -ENOTCONN;
+	if (conn.snd_una != conn.snd_nxt)
+		return -EBUSY;
+
+	conn.tx_data = data;
+	conn.tx_seq = conn.snd_nxt;
+	conn.tx_len = len;
+	conn.snd_nxt += len;
+	tcp_send_data(conn.tx_seq);
+	tcp_progress();
+
+	return 0;
+}
+
+void tcp_close(void)
+{
+	if (conn.state == TCP_ESTABLISHED)
+		tcp_send_segment(TCP_FIN | TCP_ACK, conn.snd_nxt, NULL, 0);
+	conn.state = TCP_CLOSED;
+	net_set_timeout_handler(0, NULL);
+}
+
+void tcp_get_stats(struct tcp_stats *stats)
+{
+	*stats = conn.stats;
+}
+
+/* Pick up the server's MSS and whether it agrees to window scaling */
+static void tcp_parse_options(struct tcp_hdr *tcp, uint hlen)
+{
+	const uchar *opt = (uchar *)(tcp + 1);
+	const uchar *end = (uchar *)tcp + hlen;
+	bool wscale = false;
+
+	while (opt < end && *opt != TCP_OPT_END) {
+		if (*opt == TCP_OPT_NOP) {
+			opt++;
+			continue;
+		}
+		if (opt + 1 >= end || opt[1] < 2 || opt + opt[1] > end)
+			break;
+		if (*opt == TCP_OPT_MSS && opt[1] == 4)
+			conn.snd_mss = min_t(uint, (opt[2] << 8) | opt[3],
+					     TCP_MSS);
+		else if (*opt == TCP_OPT_WSCALE && opt[1] == 3)
+			wscale = true;
+		opt += opt[1];
+	}
+	conn.rcv_wscale = wscale ? tcp_wscale() : 0;
+}
+
+/* Record data held beyond a gap, merging it with what is held already */
+static int tcp_hold(u32 start, u32 end)
+{
+	struct tcp_range *r, *free = NULL;
+
+	for (r = conn.held; r < conn.held + TCP_HELD; r++) {
+		if (r->start != r->end && tcp_seq_le(start, r->end) &&
+		    tcp_seq_le(r->start, end)) {
+			if (tcp_seq_lt(r->start, start))
+				start = r->start;
+			if (tcp_seq_lt(end, r->end))
+				end = r->end;
+			r->start = r->end;
+		}
+		if (r->start == r->end && !free)
+			free = r;
+	}
+	if (!free)
+		return -ENOSPC;
+	free->start = start;
+	free->end = end;
+
+	return 0;
+}
+
+/* Move past any held data which the gap now reaches */
+static void tcp_fill_gap(void)
+{
+	struct tcp_range *r;
+	bool again;
+
+	do {
+		again = false;
+		for (r = conn.held; r < conn.held + TCP_HELD; r++) {
+			if (r->start == r->end ||
+			    tcp_seq_lt(conn.rcv_nxt, r->start))
+				continue;
+			if (tcp_seq_lt(conn.rcv_nxt, r->end))
+				conn.rcv_nxt = r->end;
+			r->start = r->end;
+			again = true;
+		}
+	} while (again);
+}
+
+static void tcp_data_in(u32 seq, const uchar *data, uint len)
+{
+	s32 off = seq - conn.rcv_nxt;
+
+	conn.stats.segments++;
+	if (off < 0) {
+		if (off + (s32)len <= 0) {
+			/* all resent data we have: our ACK was lost */
+			tcp_send_ack();
+			return;
+		}
+		data -= off;
+		len += off;
+		seq = conn.rcv_nxt;
+		off = 0;
+	}
+	if (off + len > CONFIG_TCP_RCV_WINDOW) {
+		conn.stats.dropped++;
+		tcp_send_ack();
+		return;
+	}
+
+	if (!off) {
+		if (conn.rx(data, seq - conn.irs - 1, len)) {
+			conn.stats.dropped++;
+		} else {
+			conn.rcv_nxt += len;
+			tcp_fill_gap();
+			tcp_progress();
+		}
+	} else {
+		conn.stats.out_of_order++;
+		if (conn.rx(data, seq - conn.irs - 1, len) ||
+		    tcp_hold(seq, seq + len))
+			conn.stats.dropped++;
+		/* Ask again for the missing data */
+		conn.stats.dup_acks++;
+	}
+	/* The caller may have given up on the connection */
+	if (conn.state != TCP_ESTABLISHED)
+		return;
+	tcp_send_ack();
+	if (!off)
+		conn.event(TCP_EVENT_DATA, tcp_stream_len());
+}
+
+static void tcp_ack_in(u32 ack, bool has_data)
+{
+	if (tcp_seq_lt(conn.snd_una, ack) && tcp_seq_le(ack, conn.snd_nxt)) {
+		conn.snd_una = ack;
+		conn.dup_acks = 0;
+		tcp_progress();
+	} else if (ack == conn.snd_una && conn.snd_una != conn.snd_nxt &&
+		   !has_data && ++conn.dup_acks == 3) {
+		conn.stats.fast_retransmits++;
+		tcp_send_data(conn.snd_una);
+	}
+}
+
+void tcp_receive(struct ip_udp_hdr *ip, unsigned len)
+{
+	struct tcp_hdr *tcp = (struct tcp_hdr *)((uchar *)ip + IP_HDR_SIZE);
+	uint tcp_len, hlen, dlen, xsum;
+	u32 seq, ack;
+	u8 flags;
+
+	if (conn.state == TCP_CLOSED || len < IP_TCP_HDR_SIZE)
+		return;
+	tcp_len = len - IP_HDR_SIZE;
+	hlen = (tcp->tcp_hlen >> 4) * 4;
+	if (hlen < TCP_HDR_SIZE || hlen > tcp_len)
+		return;
+	if (ntohs(tcp->tcp_dst) != conn.sport ||
+	    ntohs(tcp->tcp_src) != conn.dport ||
+	    net_read_ip(&ip->ip_src).s_addr != conn.dest.s_addr)
+		return;
+	xsum = compute_udp_checksum(ip, tcp_len);
+	if (xsum && xsum != 0xffff) {
+		debug("TCP: bad checksum\n");
+		return;
+	}
+
+	flags = tcp->tcp_flags;
+	seq = ntohl(net_read_u32(&tcp->tcp_seq));
+	ack = ntohl(net_read_u32(&tcp->tcp_ack));
+	dlen = tcp_len - hlen;
+
+	if (flags & TCP_RST) {
+		if (conn.state == TCP_SYN_SENT ?
+		    (flags & TCP_ACK) && ack == conn.snd_nxt :
+		    seq == conn.rcv_nxt) {
+			puts("\nTCP: connection reset\n");
+			tcp_end(TCP_EVENT_RESET);
+		}
+		return;
+	}
+
+	if (conn.state == TCP_SYN_SENT) {
+		if (!(flags & TCP_SYN) || !(flags & TCP_ACK) ||
+		    ack != conn.snd_nxt)
+			return;
+		tcp_parse_options(tcp, hlen);
+		conn.irs = seq;
+		conn.rcv_nxt = seq + 1;
+		conn.snd_una = ack;
+		conn.state = TCP_ESTABLISHED;
+		tcp_progress();
+		tcp_send_ack();
+		conn.event(TCP_EVENT_CONNECTED, 0);
+		return;
+	}
+
+	if (flags & TCP_SYN) {
+		/* The server did not see our ACK of its SYN */
+		tcp_send_ack();
+		return;
+	}
+	if (flags & TCP_ACK)
+		tcp_ack_in(ack, dlen || (flags & TCP_FIN));
+	if (dlen && conn.state == TCP_ESTABLISHED)
+		tcp_data_in(seq, (uchar *)tcp + hlen, dlen);
+	if (flags & TCP_FIN) {
+		conn.fin_seen = true;
+		conn.fin_seq = seq + dlen;
+	}
+	if (conn.state == TCP_ESTABLISHED && conn.fin_seen &&
+	    conn.rcv_nxt == conn.fin_seq) {
+		/* Everything has arrived: acknowledge the FIN and close */
+		conn.rcv_nxt++;
+		tcp_send_segment(TCP_FIN | TCP_ACK, conn.snd_nxt, NULL, 0);
+		tcp_end(TCP_EVENT_CLOSED);
+	}
+}
@@ -11,14 +11,13 @@
 #include <efi_loader.h>
 #include <mapmem.h>
 #include <net.h>
+#include <net/rtt.h>
 #include <net/tftp.h>
 #include "bootp.h"
 #ifdef CONFIG_SYS_DIRECT_FLASH_TFTP
 #include <flash.h>
 #endif
 
-/* Well known TFTP port # */
-#define WELL_KNOWN_PORT	69
 /* Millisecs to timeout for lost pkt */
 #define TIMEOUT		5000UL
 #ifndef	CONFIG_NET_RETRY_COUNT
@@ -30,19 +29,12 @@
 /* Number of "loading" hashes per line (for checking the image size) */
 #define HASHES_PER_LINE	65
 
-/*
- *	TFTP operations.
- */
-#define TFTP_RRQ	1
-#define TFTP_WRQ	2
-#define TFTP_DATA	3
-#define TFTP_ACK	4
-#define TFTP_ERROR	5
-#define TFTP_OACK	6
-
 static ulong timeout_ms = TIMEOUT;
 static int timeout_count_max = TIMEOUT_COUNT;
 static ulong time_start;   /* Record time we started tftp */
+static struct net_rtt tftp_rtt;
+static ulong tftp_sent_us;	/* timer_get_us() when we last sent */
+static bool tftp_resent;	/* our last packet was sent more than once */
 
 /*
  * These globals govern the timeout behavior when attempting a connection to a
@@ -56,16 +48,6 @@ static ulong time_start;   /* Record time we started tftp */
 ulong tftp_timeout_ms = TIMEOUT;
 int tftp_timeout_count_max = TIMEOUT_COUNT;
 
-enum {
-	TFTP_ERR_UNDEFINED           = 0,
-	TFTP_ERR_FILE_NOT_FOUND      = 1,
-	TFTP_ERR_ACCESS_DENIED       = 2,
-	TFTP_ERR_DISK_FULL           = 3,
-	TFTP_ERR_UNEXPECTED_OPCODE   = 4,
-	TFTP_ERR_UNKNOWN_TRANSFER_ID  = 5,
-	TFTP_ERR_FILE_ALREADY_EXISTS = 6,
-};
-
 static struct in_addr tftp_remote_ip;
 /* The UDP port at their end */
 static int	tftp_remote_port;
@@ -101,13 +83,7 @@ static int	tftp_put_final_block_sent;
 #define STATE_TOO_LARGE	3
 #define STATE_BAD_MAGIC	4
 #define STATE_OACK	5
-#define STATE_RECV_WRQ	6
-#define STATE_SEND_WRQ	7
-
-/* default TFTP block size */
-#define TFTP_BLOCK_SIZE		512
-/* sequence number is 16 bit */
-#define TFTP_SEQUENCE_SIZE	((ulong)(1<<16))
+#define STATE_SEND_WRQ	6
 
 #define DEFAULT_NAME_LEN	(8 + 4 + 1)
 static char default_filename[DEFAULT_NAME_LEN];
@@ -120,17 +96,6 @@ static char default_filename[DEFAULT_NAME_LEN];
 
 static char tftp_filename[MAX_LEN];
 
-/* 512 is poor choice for ethernet, MTU is typically 1500.
- * Minus eth.hdrs thats 1468.  Can get 2x better throughput with
- * almost-MTU block sizes.  At least try... fall back to 512 if need be.
- * (but those using CONFIG_IP_DEFRAG may want to set a larger block in cfg file)
- */
-#ifdef CONFIG_TFTP_BLOCKSIZE
-#define TFTP_MTU_BLOCKSIZE CONFIG_TFTP_BLOCKSIZE
-#else
-#define TFTP_MTU_BLOCKSIZE 1468
-#endif
-
 static unsigned short tftp_block_size = TFTP_BLOCK_SIZE;
 static unsigned short tftp_block_size_option = TFTP_MTU_BLOCKSIZE;
 
@@ -244,6 +209,21 @@ static void tftp_timeout_handler(void);
 
 /**********************************************************************/
 
+/*
+ * The reply to the packet we sent last has arrived. Measure the round trip,
+ * unless the packet was resent, and wait for the next reply.
+ */
+static void tftp_got_reply(void)
+{
+	if (!tftp_resent)
+		net_rtt_sample(&tftp_rtt, timer_get_us() - tftp_sent_us);
+	tftp_resent = false;
+	/* Only give up after too many timeouts in a row */
+	timeout_count = 0;
+	net_set_timeout_handler(net_rtt_timeout(&tftp_rtt),
+				tftp_timeout_handler);
+}
+
 static void show_block_marker(void)
 {
 #ifdef CONFIG_TFTP_TSIZE
@@ -321,6 +301,7 @@ static void tftp_complete(void)
 		print_size(net_boot_file_size /
 			time_start * 1000, "/s");
 	}
+	net_rtt_report(&tftp_rtt);
 	puts("\ndone\n");
 	net_set_state(NETLOOP_SUCCESS);
 }
@@ -397,7 +378,6 @@ static void tftp_send(void)
 		/* fall through */
 #endif
 
-	case STATE_RECV_WRQ:
 	case STATE_DATA:
 		xp = pkt;
 		s = (ushort *)pkt;
@@ -441,6 +421,7 @@ static void tftp_send(void)
 		break;
 	}
 
+	tftp_sent_us = timer_get_us();
 	net_send_udp_packet(net_server_ethaddr, tftp_remote_ip,
 			    tftp_remote_port, tftp_our_port, len);
 }
@@ -472,7 +453,7 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			return;
 	}
 	if (tftp_state != STATE_SEND_RRQ && src != tftp_remote_port &&
-	    tftp_state != STATE_RECV_WRQ && tftp_state != STATE_SEND_WRQ)
+	    tftp_state != STATE_SEND_WRQ)
 		return;
 
 	if (len < 2)
@@ -501,8 +482,10 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 
 				tftp_cur_block = (unsigned short)(block + 1);
 				update_block_number();
-				if (ack_ok)
+				if (ack_ok) {
+					tftp_got_reply();
 					tftp_send(); /* Send next data block */
+				}
 			}
 		}
 #endif
@@ -511,22 +494,12 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 	default:
 		break;
 
-#ifdef CONFIG_CMD_TFTPSRV
-	case TFTP_WRQ:
-		debug("Got WRQ\n");
-		tftp_remote_ip = sip;
-		tftp_remote_port = src;
-		tftp_our_port = 1024 + (get_timer(0) % 3072);
-		new_transfer();
-		tftp_send(); /* Send ACK(0) */
-		break;
-#endif
-
 	case TFTP_OACK:
 		debug("Got OACK: %s %s\n",
 		      pkt, pkt + strlen((char *)pkt) + 1);
 		tftp_state = STATE_OACK;
 		tftp_remote_port = src;
+		tftp_got_reply();
 		/*
 		 * Check for 'blksize' option.
 		 * Careful: "i" is signed, "len" is unsigned, thus
@@ -575,8 +548,7 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		if (tftp_state == STATE_SEND_RRQ)
 			debug("Server did not acknowledge timeout option!\n");
 
-		if (tftp_state == STATE_SEND_RRQ || tftp_state == STATE_OACK ||
-		    tftp_state == STATE_RECV_WRQ) {
+		if (tftp_state == STATE_SEND_RRQ || tftp_state == STATE_OACK) {
 			/* first block received */
 			tftp_state = STATE_DATA;
 			tftp_remote_port = src;
@@ -604,7 +576,7 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 
 		tftp_prev_block = tftp_cur_block;
 		timeout_count_max = tftp_timeout_count_max;
-		net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
+		tftp_got_reply();
 
 		store_block(tftp_cur_block - 1, pkt + 2, len);
 
@@ -689,9 +661,11 @@ static void tftp_timeout_handler(void)
 		restart("Retry count exceeded");
 	} else {
 		puts("T ");
-		net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
-		if (tftp_state != STATE_RECV_WRQ)
-			tftp_send();
+		net_rtt_backoff(&tftp_rtt);
+		tftp_resent = true;
+		net_set_timeout_handler(net_rtt_timeout(&tftp_rtt),
+					tftp_timeout_handler);
+		tftp_send();
 	}
 }
 
@@ -702,8 +676,12 @@ void tftp_start(enum proto_t protocol)
 	char *ep;             /* Environment pointer */
 
 	/*
-	 * Allow the user to choose TFTP blocksize and timeout.
-	 * TFTP protocol has a minimal timeout of 1 second.
+	 * Allow the user to choose TFTP blocksize and timeout. The timeout
+	 * is only the first one, used until the server's round trip time is
+	 * measured, and the longest one backing off to; in between, packets
+	 * are resent after as little as CONFIG_NET_RTO_MIN ms. It is also
+	 * sent as the timeout option, which is in whole seconds, so it must
+	 * be at least 1 second.
 	 */
 
 	ep = getenv("tftpblocksize");
@@ -811,12 +789,16 @@ void tftp_start(enum proto_t protocol)
 	time_start = get_timer(0);
 	timeout_count_max = tftp_timeout_count_max;
 
-	net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
+	/* Adapt to the server's round trip time, up to the set timeout */
+	net_rtt_init(&tftp_rtt, timeout_ms, timeout_ms);
+	tftp_resent = false;
+	net_set_timeout_handler(net_rtt_timeout(&tftp_rtt),
+				tftp_timeout_handler);
 	net_set_udp_handler(tftp_handler);
 #ifdef CONFIG_CMD_TFTPPUT
 	net_set_icmp_handler(icmp_handler);
 #endif
-	tftp_remote_port = WELL_KNOWN_PORT;
+	tftp_remote_port = TFTP_PORT;
 	timeout_count = 0;
 	/* Use a pseudo-random port unless a specific port is set */
 	tftp_our_port = 1024 + (get_timer(0) % 3072);
@@ -846,40 +828,6 @@ void tftp_start(enum proto_t protocol)
 	tftp_send();
 }
 
-#ifdef CONFIG_CMD_TFTPSRV
-void tftp_start_server(void)
-{
-	tftp_filename[0] = 0;
-
-	printf("Using %s device\n", eth_get_name());
-	printf("Listening for TFTP transfer on %pI4\n", &net_ip);
-	printf("Load address: 0x%lx\n", load_addr);
-
-	puts("Loading: *\b");
-
-	timeout_count_max = tftp_timeout_count_max;
-	timeout_count = 0;
-	timeout_ms = TIMEOUT;
-	net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
-
-	/* Revert tftp_block_size to dflt */
-	tftp_block_size = TFTP_BLOCK_SIZE;
-	tftp_cur_block = 0;
-	tftp_our_port = WELL_KNOWN_PORT;
-
-#ifdef CONFIG_TFTP_TSIZE
-	tftp_tsize = 0;
-	tftp_tsize_num_hash = 0;
-#endif
-
-	tftp_state = STATE_RECV_WRQ;
-	net_set_udp_handler(tftp_handler);
-
-	/* zero out server ether in case the server ip has changed */
-	memset(net_server_ethaddr, 0, 6);
-}
-#endif /* CONFIG_CMD_TFTPSRV */
-
 #ifdef CONFIG_MCAST_TFTP
 /*
  * Credits: atftp project.
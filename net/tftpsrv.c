@@ -0,0 +1,641 @@
+/*
+ * TFTP server, serving several transfers at once
+ *
+ * Each request starts a session with its own port at our end (the transfer
+ * ID of RFC 1350), block counter and retransmit timer, so one slow or lossy
+ * client does not hold up the others.
+ *
+ * A file name of the form <interface>/<dev>[:<part>], such as mmc/0:1, is
+ * a block device or partition, which is read or written whole. Any other
+ * name is the memory image at the load address; gets are given "filesize"
+ * bytes of it. Data is moved straight between the packet and the image or
+ * device, without staging copies.
+ *
+ * As before, the server stops once a file has been put into memory and the
+ * other transfers have finished.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <blk.h>
+#include <mapmem.h>
+#include <memalign.h>
+#include <net.h>
+#include <part.h>
+#include <net/rtt.h>
+#include <net/tftp.h>
+
+#ifndef CONFIG_TFTPSRV_SESSIONS
+#define CONFIG_TFTPSRV_SESSIONS	4
+#endif
+
+#define TFTPSRV_NAME_LEN	128
+#define TFTPSRV_MIN_BLKSIZE	8	/* RFC 2348 */
+#define TFTPSRV_MAX_TIMEOUT	255	/* RFC 2349, in seconds */
+
+/**
+ * struct tftpsrv_session - One transfer
+ *
+ * @active:	true if this session is in use
+ * @write:	true for a put to us, false for a get
+ * @ip:		Client's IP address
+ * @port:	Client's UDP port
+ * @our_port:	Our UDP port for this transfer
+ * @ethaddr:	Where to send packets, from the client's last packet
+ * @name:	File name asked for
+ * @desc:	Block device, or NULL for the memory image
+ * @start:	First block of the partition on @desc
+ * @size:	Number of bytes which can be read or written
+ * @len:	Number of bytes read or written so far
+ * @blksize:	TFTP block size
+ * @block:	Last block sent (get) or received (put), not wrapped to 16 bits
+ * @last:	true if block @block is the last of a get
+ * @dally:	true once a put is complete, while we wait in case our last ACK
+ *		was lost and the client sends its last block again
+ * @oack:	true if block 0 is an OACK rather than an ACK or nothing
+ * @opt_blksize: true to acknowledge the blksize option
+ * @tsize:	Value of the tsize option, -1 if it was not given
+ * @timeout:	Value of the timeout option in seconds, 0 if not given
+ * @rtt:	Round trip time estimate, which sets the retransmit timeout
+ * @sent_us:	timer_get_us() when we last sent
+ * @resent:	true if our last packet was sent more than once
+ * @deadline:	get_timer() value at which to send again
+ * @timeouts:	Number of timeouts in a row
+ * @time_start:	get_timer() value when the request came
+ */
+struct tftpsrv_session {
+	bool active;
+	bool write;
+	struct in_addr ip;
+	int port;
+	int our_port;
+	uchar ethaddr[ARP_HLEN];
+	char name[TFTPSRV_NAME_LEN];
+	struct blk_desc *desc;
+	lbaint_t start;
+	ulong size;
+	ulong len;
+	int blksize;
+	ulong block;
+	bool last;
+	bool dally;
+	bool oack;
+	bool opt_blksize;
+	long tsize;
+	int timeout;
+	struct net_rtt rtt;
+	ulong sent_us;
+	bool resent;
+	ulong deadline;
+	int timeouts;
+	ulong time_start;
+};
+
+static struct tftpsrv_session sessions[CONFIG_TFTPSRV_SESSIONS];
+static ulong tftpsrv_image_size;	/* of the memory image, for gets */
+static bool tftpsrv_stopping;		/* a put to memory is complete */
+
+static void tftpsrv_send_error(uchar *ethaddr, struct in_addr ip, int port,
+			       int our_port, int code, const char *msg)
+{
+	uchar *pkt = net_tx_packet + net_eth_hdr_size() + IP_UDP_HDR_SIZE;
+	__be16 *s = (__be16 *)pkt;
+
+	s[0] = htons(TFTP_ERROR);
+	s[1] = htons(code);
+	strcpy((char *)(s + 2), msg);
+	net_send_udp_packet(ethaddr, ip, port, our_port, 4 + strlen(msg) + 1);
+}
+
+/* Say what was sent or received; a put to memory stops the server */
+static void tftpsrv_report(struct tftpsrv_session *sess)
+{
+	printf("%pI4:%d: %s '%s', ", &sess->ip, sess->port,
+	       sess->write ? "received" : "sent", sess->name);
+	print_size(sess->len, "");
+	printf(" in %lu ms\n", get_timer(sess->time_start));
+
+	if (sess->write && !sess->desc) {
+		net_boot_file_size = sess->len;
+		tftpsrv_stopping = true;
+	}
+}
+
+/* Finish a session, with @err giving the reason if it failed */
+static void tftpsrv_end(struct tftpsrv_session *sess, const char *err)
+{
+	sess->active = false;
+	if (sess->dally)
+		return;		/* reported when the last block came */
+	if (err)
+		printf("%pI4:%d: '%s' failed: %s\n", &sess->ip, sess->port,
+		       sess->name, err);
+	else
+		tftpsrv_report(sess);
+}
+
+/* Tell the client why we are giving up, then forget the session */
+static void tftpsrv_fail(struct tftpsrv_session *sess, int code,
+			 const char *msg)
+{
+	tftpsrv_send_error(sess->ethaddr, sess->ip, sess->port,
+			   sess->our_port, code, msg);
+	tftpsrv_end(sess, msg);
+}
+
+static int tftpsrv_read(struct tftpsrv_session *sess, ulong offset,
+			uchar *dst, int len)
+{
+	void *src;
+
+#ifdef CONFIG_PARTITIONS
+	if (sess->desc) {
+		/* The block size is a multiple of the device's, as is @len */
+		struct blk_desc *desc = sess->desc;
+		lbaint_t cnt = len / desc->blksz;
+
+		if (cnt && blk_dread(desc, sess->start + offset / desc->blksz,
+				     cnt, dst) != cnt)
+			return -EIO;
+		return 0;
+	}
+#endif
+	src = map_sysmem(load_addr + offset, len);
+	memcpy(dst, src, len);
+	unmap_sysmem(src);
+
+	return 0;
+}
+
+static int tftpsrv_write(struct tftpsrv_session *sess, ulong offset,
+			 const uchar *data, int len)
+{
+	void *dst;
+
+#ifdef CONFIG_PARTITIONS
+	if (sess->desc) {
+		struct blk_desc *desc = sess->desc;
+		lbaint_t blk = sess->start + offset / desc->blksz;
+		lbaint_t cnt = len / desc->blksz;
+		int tail = len % desc->blksz;
+
+		if (cnt && blk_dwrite(desc, blk, cnt, data) != cnt)
+			return -EIO;
+		if (tail) {
+			ALLOC_CACHE_ALIGN_BUFFER(uchar, buf, desc->blksz);
+
+			/* Keep the rest of the device's last block */
+			if (blk_dread(desc, blk + cnt, 1, buf) != 1)
+				return -EIO;
+			memcpy(buf, data + cnt * desc->blksz, tail);
+			if (blk_dwrite(desc, blk + cnt, 1, buf) != 1)
+				return -EIO;
+		}
+		return 0;
+	}
+#endif
+	dst = map_sysmem(load_addr + offset, len);
+	memcpy(dst, data, len);
+	unmap_sysmem(dst);
+
+	return 0;
+}
+
+/* Send the packet for the current block: OACK, DATA or ACK */
+static void tftpsrv_send(struct tftpsrv_session *sess)
+{
+	uchar *pkt = net_tx_packet + net_eth_hdr_size() + IP_UDP_HDR_SIZE;
+	__be16 *s = (__be16 *)pkt;
+	ulong offset;
+	int len;
+
+	if (!sess->block && sess->oack) {
+		s[0] = htons(TFTP_OACK);
+		len = 2;
+		if (sess->opt_blksize)
+			len += sprintf((char *)pkt + len, "blksize%c%d%c", 0,
+				       sess->blksize, 0);
+		if (sess->tsize >= 0)
+			len += sprintf((char *)pkt + len, "tsize%c%ld%c", 0,
+				       sess->tsize, 0);
+		if (sess->timeout)
+			len += sprintf((char *)pkt + len, "timeout%c%d%c", 0,
+				       sess->timeout, 0);
+	} else if (sess->write) {
+		s[0] = htons(TFTP_ACK);
+		s[1] = htons((ushort)sess->block);
+		len = 4;
+	} else {
+		offset = (sess->block - 1) * sess->blksize;
+		len = min_t(ulong, sess->blksize, sess->size - offset);
+		s[0] = htons(TFTP_DATA);
+		s[1] = htons((ushort)sess->block);
+		if (tftpsrv_read(sess, offset, pkt + 4, len)) {
+			tftpsrv_fail(sess, TFTP_ERR_UNDEFINED, "Read error");
+			return;
+		}
+		sess->last = len < sess->blksize;
+		len += 4;
+	}
+
+	sess->sent_us = timer_get_us();
+	sess->deadline = get_timer(0) + net_rtt_timeout(&sess->rtt);
+	net_send_udp_packet(sess->ethaddr, sess->ip, sess->port,
+			    sess->our_port, len);
+}
+
+/*
+ * The reply to the packet we sent last has arrived. Measure the round trip,
+ * unless the packet was resent.
+ */
+static void tftpsrv_got_reply(struct tftpsrv_session *sess)
+{
+	if (!sess->resent)
+		net_rtt_sample(&sess->rtt, timer_get_us() - sess->sent_us);
+	sess->resent = false;
+	sess->timeouts = 0;
+}
+
+static void tftpsrv_timeout_handler(void);
+
+/* Wake up for the session which needs to send again soonest */
+static void tftpsrv_set_timer(void)
+{
+	ulong now = get_timer(0);
+	long wait = LONG_MAX;
+	int i;
+
+	for (i = 0; i < CONFIG_TFTPSRV_SESSIONS; i++) {
+		if (sessions[i].active)
+			wait = min(wait, (long)(sessions[i].deadline - now));
+	}
+
+	if (wait == LONG_MAX)
+		net_set_timeout_handler(0, NULL);
+	else
+		net_set_timeout_handler(max(wait, 1L),
+					tftpsrv_timeout_handler);
+}
+
+/* Stop once a put to memory is complete and nothing else is going on */
+static void tftpsrv_check_done(void)
+{
+	int i;
+
+	if (!tftpsrv_stopping)
+		return;
+	for (i = 0; i < CONFIG_TFTPSRV_SESSIONS; i++) {
+		if (sessions[i].active)
+			return;
+	}
+	net_set_state(NETLOOP_SUCCESS);
+}
+
+static void tftpsrv_timeout_handler(void)
+{
+	struct tftpsrv_session *sess;
+	ulong now = get_timer(0);
+	int i;
+
+	for (i = 0; i < CONFIG_TFTPSRV_SESSIONS; i++) {
+		sess = &sessions[i];
+		if (!sess->active || (long)(now - sess->deadline) < 0)
+			continue;
+		if (sess->dally) {
+			/* The client has stopped, so it had our last ACK */
+			tftpsrv_end(sess, NULL);
+			continue;
+		}
+		if (++sess->timeouts > tftp_timeout_count_max) {
+			tftpsrv_end(sess, "retry count exceeded");
+			continue;
+		}
+		net_rtt_backoff(&sess->rtt);
+		sess->resent = true;
+		tftpsrv_send(sess);
+	}
+
+	tftpsrv_set_timer();
+	tftpsrv_check_done();
+}
+
+/* Pick a port for a new session, which no other session has */
+static int tftpsrv_new_port(void)
+{
+	int port = get_timer(0) % 3072;
+	int i;
+
+	for (i = 0; i < CONFIG_TFTPSRV_SESSIONS; i++) {
+		if (sessions[i].active &&
+		    sessions[i].our_port == 1024 + port) {
+			port = (port + 1) % 3072;
+			i = -1;
+		}
+	}
+
+	return 1024 + port;
+}
+
+/* Find what the file name refers to: a block device or the memory image */
+static int tftpsrv_open(struct tftpsrv_session *sess)
+{
+	char *dev = strchr(sess->name, '/');
+	int i;
+
+	if (dev) {
+#ifdef CONFIG_PARTITIONS
+		disk_partition_t info;
+		int ret;
+
+		*dev = '\0';
+		ret = blk_get_device_part_str(sess->name, dev + 1, &sess->desc,
+					      &info, 1);
+		*dev = '/';
+		if (ret < 0)
+			return -ENOENT;
+		sess->start = info.start;
+		sess->size = (ulong)info.size * info.blksz;
+		return 0;
+#else
+		return -ENOENT;
+#endif
+	}
+
+	/* The image cannot be read while it is being written */
+	for (i = 0; i < CONFIG_TFTPSRV_SESSIONS; i++) {
+		if (sessions[i].active && !sessions[i].desc &&
+		    (sess->write || sessions[i].write))
+			return -EBUSY;
+	}
+	if (sess->write) {
+		sess->size = ULONG_MAX;
+	} else {
+		if (!tftpsrv_image_size)
+			return -ENOENT;
+		sess->size = tftpsrv_image_size;
+	}
+
+	return 0;
+}
+
+/* Return the string after @p, or NULL if @p is not terminated before @end */
+static char *tftpsrv_next_str(char *p, char *end)
+{
+	int len = strnlen(p, end - p);
+
+	return len < end - p ? p + len + 1 : NULL;
+}
+
+/* Take the options (RFC 2347) from a request, checking them */
+static int tftpsrv_parse_options(struct tftpsrv_session *sess, char *opt,
+				 char *end)
+{
+	ulong blksz = sess->desc ? sess->desc->blksz : 1;
+	char *val;
+	ulong n;
+
+	sess->blksize = TFTP_BLOCK_SIZE;
+	sess->tsize = -1;
+	while (opt && opt < end) {
+		val = tftpsrv_next_str(opt, end);
+		if (!val || val >= end)
+			break;
+		n = simple_strtoul(val, NULL, 10);
+		if (!strcasecmp(opt, "blksize") && n >= TFTPSRV_MIN_BLKSIZE) {
+			n = min_t(ulong, n, TFTP_MTU_BLOCKSIZE);
+			/* Whole device blocks, so they go straight to it */
+			if (n >= blksz) {
+				sess->blksize = n - n % blksz;
+				sess->opt_blksize = true;
+			}
+		} else if (!strcasecmp(opt, "tsize")) {
+			if (sess->write && n > sess->size)
+				return -ENOSPC;
+			sess->tsize = sess->write ? n : sess->size;
+		} else if (!strcasecmp(opt, "timeout") && n >= 1 &&
+			   n <= TFTPSRV_MAX_TIMEOUT) {
+			sess->timeout = n;
+		}
+		opt = tftpsrv_next_str(val, end);
+	}
+	if (sess->blksize % blksz)
+		return -EINVAL;
+	sess->oack = sess->opt_blksize || sess->tsize >= 0 || sess->timeout;
+
+	return 0;
+}
+
+/* Start a session for a read or write request */
+static void tftpsrv_request(int op, char *pkt, unsigned len,
+			    struct in_addr sip, unsigned src)
+{
+	struct ethernet_hdr *et = (struct ethernet_hdr *)net_rx_packet;
+	struct tftpsrv_session *sess = NULL;
+	char *end = pkt + len;
+	char *mode, *opt;
+	ulong timeout;
+	int ret;
+	int i;
+
+	for (i = 0; i < CONFIG_TFTPSRV_SESSIONS; i++) {
+		if (sessions[i].active && sessions[i].ip.s_addr == sip.s_addr &&
+		    sessions[i].port == src) {
+			/* The request again, so our reply was lost */
+			sessions[i].resent = true;
+			tftpsrv_send(&sessions[i]);
+			return;
+		}
+		if (!sessions[i].active && !sess)
+			sess = &sessions[i];
+	}
+
+	mode = tftpsrv_next_str(pkt, end);
+	opt = mode ? tftpsrv_next_str(mode, end) : NULL;
+	if (!opt)
+		return;
+	if (tftpsrv_stopping || !sess) {
+		tftpsrv_send_error(et->et_src, sip, src, TFTP_PORT,
+				   TFTP_ERR_UNDEFINED, "Server busy");
+		return;
+	}
+
+	memset(sess, '\0', sizeof(*sess));
+	sess->write = op == TFTP_WRQ;
+	sess->ip = sip;
+	sess->port = src;
+	sess->our_port = tftpsrv_new_port();
+	memcpy(sess->ethaddr, et->et_src, ARP_HLEN);
+	strncpy(sess->name, pkt, TFTPSRV_NAME_LEN - 1);
+	sess->time_start = get_timer(0);
+
+	if (strcasecmp(mode, "octet")) {
+		tftpsrv_fail(sess, TFTP_ERR_UNDEFINED, "Only octet mode");
+		return;
+	}
+	ret = tftpsrv_open(sess);
+	if (!ret)
+		ret = tftpsrv_parse_options(sess, opt, end);
+	switch (ret) {
+	case 0:
+		break;
+	case -ENOENT:
+		tftpsrv_fail(sess, TFTP_ERR_FILE_NOT_FOUND, "File not found");
+		return;
+	case -EBUSY:
+		tftpsrv_fail(sess, TFTP_ERR_ACCESS_DENIED, "Image in use");
+		return;
+	case -ENOSPC:
+		tftpsrv_fail(sess, TFTP_ERR_DISK_FULL, "File too large");
+		return;
+	default:
+		tftpsrv_fail(sess, TFTP_ERR_UNDEFINED, "Block size not supported");
+		return;
+	}
+
+	printf("%pI4:%d: %s '%s'\n", &sip, src, sess->write ? "put" : "get",
+	       sess->name);
+	timeout = sess->timeout ? sess->timeout * 1000UL : tftp_timeout_ms;
+	net_rtt_init(&sess->rtt, timeout, timeout);
+	sess->block = sess->oack || sess->write ? 0 : 1;
+	sess->active = true;
+	tftpsrv_send(sess);
+}
+
+static void tftpsrv_recv_ack(struct tftpsrv_session *sess, ushort block)
+{
+	if (sess->write || block != (ushort)sess->block)
+		return;
+	tftpsrv_got_reply(sess);
+	if (sess->block) {
+		sess->len = min_t(ulong, sess->block * sess->blksize,
+				  sess->size);
+		if (sess->last) {
+			tftpsrv_end(sess, NULL);
+			return;
+		}
+	}
+	sess->block++;
+	tftpsrv_send(sess);
+}
+
+static void tftpsrv_recv_data(struct tftpsrv_session *sess, ushort block,
+			      uchar *data, unsigned len)
+{
+	ulong offset = sess->block * sess->blksize;
+
+	if (!sess->write)
+		return;
+	if (block == (ushort)sess->block) {
+		/* Our ACK was lost */
+		sess->resent = true;
+		tftpsrv_send(sess);
+		return;
+	}
+	if (sess->dally || block != (ushort)(sess->block + 1) ||
+	    len > sess->blksize)
+		return;
+
+	tftpsrv_got_reply(sess);
+	if (len > sess->size - offset) {
+		tftpsrv_fail(sess, TFTP_ERR_DISK_FULL, "File too large");
+		return;
+	}
+	if (tftpsrv_write(sess, offset, data, len)) {
+		tftpsrv_fail(sess, TFTP_ERR_UNDEFINED, "Write error");
+		return;
+	}
+	sess->block++;
+	sess->len = offset + len;
+	tftpsrv_send(sess);
+	if (len < sess->blksize) {
+		/*
+		 * Report the put now, but keep the session for a retransmit
+		 * timeout so that a lost last ACK can be sent again (RFC 1350)
+		 */
+		tftpsrv_report(sess);
+		sess->dally = true;
+	}
+}
+
+static void tftpsrv_handler(uchar *pkt, unsigned dest, struct in_addr sip,
+			    unsigned src, unsigned len)
+{
+	struct ethernet_hdr *et = (struct ethernet_hdr *)net_rx_packet;
+	struct tftpsrv_session *sess = NULL;
+	__be16 *s = (__be16 *)pkt;
+	int op;
+	int i;
+
+	if (len < 2)
+		return;
+	op = ntohs(s[0]);
+	if (dest == TFTP_PORT) {
+		if (op == TFTP_RRQ || op == TFTP_WRQ)
+			tftpsrv_request(op, (char *)pkt + 2, len - 2, sip, src);
+		tftpsrv_set_timer();
+		return;
+	}
+
+	for (i = 0; i < CONFIG_TFTPSRV_SESSIONS; i++) {
+		if (sessions[i].active && sessions[i].our_port == dest)
+			sess = &sessions[i];
+	}
+	if (!sess)
+		return;
+	if (sess->ip.s_addr != sip.s_addr || sess->port != src) {
+		tftpsrv_send_error(et->et_src, sip, src, dest,
+				   TFTP_ERR_UNKNOWN_TRANSFER_ID,
+				   "Unknown transfer ID");
+		return;
+	}
+	memcpy(sess->ethaddr, et->et_src, ARP_HLEN);
+
+	switch (op) {
+	case TFTP_ACK:
+		if (len >= 4)
+			tftpsrv_recv_ack(sess, ntohs(s[1]));
+		break;
+	case TFTP_DATA:
+		if (len >= 4)
+			tftpsrv_recv_data(sess, ntohs(s[1]), pkt + 4, len - 4);
+		break;
+	case TFTP_ERROR:
+		tftpsrv_end(sess, "stopped by client");
+		break;
+	}
+
+	tftpsrv_set_timer();
+	tftpsrv_check_done();
+}
+
+void tftp_start_server(void)
+{
+#if CONFIG_NET_TFTP_VARS
+	char *ep;
+#endif
+
+	memset(sessions, '\0', sizeof(sessions));
+	tftpsrv_stopping = false;
+	tftpsrv_image_size = getenv_hex("filesize", 0);
+#if CONFIG_NET_TFTP_VARS
+	/* As for the client, the number of timeouts in a row to give up at */
+	ep = getenv("tftptimeoutcountmax");
+	if (ep != NULL)
+		tftp_timeout_count_max = simple_strtol(ep, NULL, 10);
+	if (tftp_timeout_count_max < 0) {
+		printf("TFTP timeout count max (%d) negative, set to 0\n",
+		       tftp_timeout_count_max);
+		tftp_timeout_count_max = 0;
+	}
+#endif
+
+	printf("Using %s device\n", eth_get_name());
+	printf("Listening for TFTP transfers on %pI4\n", &net_ip);
+	printf("Load address: 0x%lx\n", load_addr);
+	if (tftpsrv_image_size)
+		printf("Image size:   0x%lx\n", tftpsrv_image_size);
+
+	net_set_timeout_handler(0, NULL);
+	net_set_udp_handler(tftpsrv_handler);
+}
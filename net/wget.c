@@ -0,0 +1,260 @@
+/*
+ * Download a file over HTTP
+ *
+ * The file is requested with HTTP/1.1 GET and stored at the load address as
+ * it arrives, using the TCP client in tcp.c. Only a plain 200 response with
+ * the body sent as is (not chunked) is accepted.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <mapmem.h>
+#include <net.h>
+#include <net/tcp.h>
+#include "wget.h"
+
+#define HASHES_PER_LINE	65
+#define WGET_HASH_SIZE	(64 * 1024)	/* bytes per hash, if size unknown */
+#define WGET_HDR_SIZE	1024		/* longest response header */
+
+static struct in_addr wget_server_ip;
+static char *wget_path;
+static char wget_req[sizeof(net_boot_file_name) + 128];
+static char wget_hdr[WGET_HDR_SIZE + 1];
+static uint wget_hdr_len;
+static u32 wget_body_off;		/* offset of the body, 0 until known */
+static long wget_content_len;		/* -1 if not given */
+static uint wget_hashes;
+static ulong time_start;
+
+static void wget_fail(const char *msg)
+{
+	printf("\nwget: %s\n", msg);
+	tcp_close();
+	net_set_state(NETLOOP_FAIL);
+}
+
+static void wget_complete(void)
+{
+	struct tcp_stats stats;
+
+	tcp_get_stats(&stats);
+	if (wget_content_len > 0) {
+		while (wget_hashes < 50) {
+			putc('#');
+			wget_hashes++;
+		}
+	}
+	puts("  ");
+	print_size(net_boot_file_size, "");
+	time_start = get_timer(time_start);
+	if (time_start > 0) {
+		puts("\n\t ");	/* Line up with "Loading: " */
+		print_size(net_boot_file_size / time_start * 1000, "/s");
+	}
+	if (stats.out_of_order || stats.retransmits || stats.dropped)
+		printf("\n\t %lu segments, %lu out of order, %lu dropped, %lu retransmitted",
+		       stats.segments, stats.out_of_order, stats.dropped,
+		       stats.retransmits + stats.fast_retransmits);
+	puts("\ndone\n");
+	net_set_state(NETLOOP_SUCCESS);
+}
+
+static void wget_show_progress(u32 stream_len)
+{
+	u32 len = stream_len - wget_body_off;
+
+	if (wget_content_len > 0) {
+		while (wget_hashes < (u64)len * 50 / wget_content_len) {
+			putc('#');
+			wget_hashes++;
+		}
+		return;
+	}
+	while (wget_hashes < len / WGET_HASH_SIZE) {
+		putc('#');
+		if (!(++wget_hashes % HASHES_PER_LINE))
+			puts("\n\t ");
+	}
+}
+
+/* Find a header field, returning its value or NULL */
+static const char *wget_find_field(const char *name)
+{
+	const char *line = strstr(wget_hdr, "\r\n");
+	int len = strlen(name);
+
+	while (line && line[2] != '\r') {
+		line += 2;
+		if (!strncasecmp(line, name, len) && line[len] == ':') {
+			line += len + 1;
+			while (*line == ' ' || *line == '\t')
+				line++;
+			return line;
+		}
+		line = strstr(line, "\r\n");
+	}
+
+	return NULL;
+}
+
+/* Check the response header, which is in wget_hdr and ends at @end */
+static int wget_parse_header(char *end)
+{
+	const char *p;
+	ulong status;
+
+	*end = '\0';
+	p = strchr(wget_hdr, ' ');
+	if (strncmp(wget_hdr, "HTTP/1.", 7) || !p) {
+		wget_fail("bad response");
+		return -EINVAL;
+	}
+	status = simple_strtoul(p + 1, NULL, 10);
+	if (status != 200) {
+		printf("\nwget: %.*s", (int)strcspn(wget_hdr, "\r"), wget_hdr);
+		wget_fail("request failed");
+		return -ENOENT;
+	}
+
+	p = wget_find_field("Transfer-Encoding");
+	if (p && strncasecmp(p, "identity", 8)) {
+		wget_fail("transfer encoding not supported");
+		return -ENOTSUPP;
+	}
+	p = wget_find_field("Content-Length");
+	wget_content_len = p ? simple_strtol(p, NULL, 10) : -1;
+
+	return 0;
+}
+
+static void wget_store(const uchar *data, u32 offset, uint len)
+{
+	ulong off = offset - wget_body_off;
+	void *ptr;
+
+	if (wget_content_len >= 0) {
+		if (off >= wget_content_len)
+			return;
+		len = min_t(ulong, len, wget_content_len - off);
+	}
+	ptr = map_sysmem(load_addr + off, len);
+	memcpy(ptr, data, len);
+	unmap_sysmem(ptr);
+
+	if (net_boot_file_size < off + len)
+		net_boot_file_size = off + len;
+}
+
+static int wget_rx(const uchar *data, u32 offset, uint len)
+{
+	uint copy;
+	char *end;
+
+	if (wget_body_off) {
+		if (offset < wget_body_off) {
+			copy = min(len, wget_body_off - offset);
+			data += copy;
+			offset += copy;
+			len -= copy;
+		}
+		wget_store(data, offset, len);
+		return 0;
+	}
+
+	/* Take the header in order, so it can be parsed as one string */
+	if (offset != wget_hdr_len)
+		return -EAGAIN;
+	copy = min(len, WGET_HDR_SIZE - wget_hdr_len);
+	memcpy(wget_hdr + wget_hdr_len, data, copy);
+	wget_hdr_len += copy;
+	wget_hdr[wget_hdr_len] = '\0';
+
+	end = strstr(wget_hdr, "\r\n\r\n");
+	if (!end) {
+		if (wget_hdr_len == WGET_HDR_SIZE)
+			wget_fail("response header too long");
+		return 0;
+	}
+	wget_body_off = end + 4 - wget_hdr;
+	if (wget_parse_header(end))
+		return 0;
+
+	/* The rest of this segment is the start of the body */
+	copy = wget_body_off - offset;
+	if (copy < len)
+		wget_store(data + copy, wget_body_off, len - copy);
+
+	return 0;
+}
+
+static void wget_event(enum tcp_event event, u32 stream_len)
+{
+	switch (event) {
+	case TCP_EVENT_CONNECTED:
+		tcp_send(wget_req, strlen(wget_req));
+		break;
+	case TCP_EVENT_DATA:
+		if (!wget_body_off)
+			break;
+		wget_show_progress(stream_len);
+		if (wget_content_len >= 0 &&
+		    stream_len >= wget_body_off + wget_content_len) {
+			tcp_close();
+			wget_complete();
+		}
+		break;
+	case TCP_EVENT_CLOSED:
+		if (!wget_body_off)
+			wget_fail("no response");
+		else if (wget_content_len >= 0 &&
+			 net_boot_file_size < wget_content_len)
+			wget_fail("connection closed early");
+		else
+			wget_complete();
+		break;
+	case TCP_EVENT_RESET:
+	case TCP_EVENT_TIMEOUT:
+		net_set_state(NETLOOP_FAIL);
+		break;
+	}
+}
+
+void wget_start(void)
+{
+	char *p;
+
+	wget_server_ip = net_server_ip;
+	wget_path = net_boot_file_name;
+	p = strchr(net_boot_file_name, ':');
+	if (p) {
+		wget_server_ip = string_to_ip(net_boot_file_name);
+		wget_path = p + 1;
+	}
+	if (!*wget_path) {
+		puts("*** ERROR: no file name\n");
+		net_set_state(NETLOOP_FAIL);
+		return;
+	}
+
+	snprintf(wget_req, sizeof(wget_req),
+		 "GET %s%s HTTP/1.1\r\nHost: %pI4\r\nConnection: close\r\n\r\n",
+		 *wget_path == '/' ? "" : "/", wget_path, &wget_server_ip);
+	wget_hdr_len = 0;
+	wget_body_off = 0;
+	wget_content_len = -1;
+	wget_hashes = 0;
+	net_boot_file_size = 0;
+
+	printf("Using %s device\n", eth_get_name());
+	printf("HTTP from server %pI4; our IP address is %pI4\n",
+	       &wget_server_ip, &net_ip);
+	printf("Filename '%s'.\n", wget_path);
+	printf("Load address: 0x%lx\n", load_addr);
+	puts("Loading: *\b");
+
+	time_start = get_timer(0);
+	tcp_connect(wget_server_ip, HTTP_PORT, wget_rx, wget_event);
+}
@@ -0,0 +1,17 @@
+/*
+ * Download a file over HTTP
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __WGET_H__
+#define __WGET_H__
+
+#define HTTP_PORT	80
+
+/*
+ * Begin the download (beginning of netloop)
+ */
+void wget_start(void);
+
+#endif /* __WGET_H__ */
@@ -0,0 +1,144 @@
+/*
+ * Throughput test for the software BCH code used by NAND ECC
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <errno.h>
+#include <malloc.h>
+#include <linux/bch.h>
+#include <test/suites.h>
+
+/* Parameters of a typical 2KiB page with 8-bit/512-byte soft BCH */
+#define BCH_UT_M		13
+#define BCH_UT_T		8
+#define BCH_UT_STEP_SIZE	512
+#define BCH_UT_PAGE_SIZE	2048
+#define BCH_UT_STEPS		(BCH_UT_PAGE_SIZE / BCH_UT_STEP_SIZE)
+#define BCH_UT_PAGES		256
+
+/**
+ * bch_ut_run() - Correct every page of a buffer as a NAND read would
+ *
+ * @bch:	BCH control structure
+ * @data:	page data, modified in place by correction
+ * @ecc:	stored ECC bytes for each step
+ * @calc:	scratch space for calculated ECC bytes
+ * @errloc:	scratch space for error locations
+ * @flips:	number of bit flips to inject into each step, or 0
+ * @return number of bits corrected, or -EBADMSG if a step failed to decode
+ */
+static int bch_ut_run(struct bch_control *bch, u8 *data, u8 *ecc, u8 *calc,
+		      unsigned int *errloc, int flips)
+{
+	int page, step, i, count, corrected = 0;
+	u8 *p, *e;
+
+	for (page = 0; page < BCH_UT_PAGES; page++) {
+		for (step = 0; step < BCH_UT_STEPS; step++) {
+			i = page * BCH_UT_STEPS + step;
+			p = data + i * BCH_UT_STEP_SIZE;
+			e = ecc + i * bch->ecc_bytes;
+
+			for (count = 0; count < flips; count++)
+				p[(count * 61) % BCH_UT_STEP_SIZE] ^=
+					1 << (count & 7);
+
+			memset(calc, 0, bch->ecc_bytes);
+			encode_bch(bch, p, BCH_UT_STEP_SIZE, calc);
+			count = decode_bch(bch, NULL, BCH_UT_STEP_SIZE, e,
+					   calc, NULL, errloc);
+			if (count < 0)
+				return -EBADMSG;
+
+			while (count--) {
+				if (errloc[count] < BCH_UT_STEP_SIZE * 8) {
+					p[errloc[count] >> 3] ^=
+						1 << (errloc[count] & 7);
+					corrected++;
+				}
+			}
+		}
+	}
+
+	return corrected;
+}
+
+static int test_bch_throughput(struct bch_control *bch, int flips)
+{
+	unsigned int size = BCH_UT_PAGES * BCH_UT_PAGE_SIZE;
+	unsigned int nsteps = BCH_UT_PAGES * BCH_UT_STEPS;
+	unsigned int *errloc;
+	u8 *data, *orig, *ecc, *calc;
+	ulong start, delta;
+	int i, ret = -ENOMEM;
+
+	data = malloc(size);
+	orig = malloc(size);
+	ecc = calloc(nsteps, bch->ecc_bytes);
+	calc = malloc(bch->ecc_bytes);
+	errloc = malloc(BCH_UT_T * sizeof(*errloc));
+	if (!data || !orig || !ecc || !calc || !errloc)
+		goto out;
+
+	srand(0x5eed);
+	for (i = 0; i < size; i++)
+		orig[i] = rand();
+	for (i = 0; i < nsteps; i++)
+		encode_bch(bch, orig + i * BCH_UT_STEP_SIZE, BCH_UT_STEP_SIZE,
+			   ecc + i * bch->ecc_bytes);
+	memcpy(data, orig, size);
+
+	start = timer_get_us();
+	ret = bch_ut_run(bch, data, ecc, calc, errloc, flips);
+	delta = timer_get_us() - start;
+	if (ret < 0) {
+		printf("%s: decode failed with %d flips per step\n", __func__,
+		       flips);
+		goto out;
+	}
+
+	if (ret != flips * nsteps || memcmp(data, orig, size)) {
+		printf("%s: corrected %d bits, expected %u\n", __func__, ret,
+		       flips * nsteps);
+		ret = -EINVAL;
+		goto out;
+	}
+
+	printf("%s: %d flips/step: %d pages in %lu us (%lu pages/s)\n",
+	       __func__, flips, BCH_UT_PAGES, delta,
+	       delta ? BCH_UT_PAGES * 1000000UL / delta : 0);
+	ret = 0;
+out:
+	free(errloc);
+	free(calc);
+	free(ecc);
+	free(orig);
+	free(data);
+
+	return ret;
+}
+
+int do_ut_bch(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	struct bch_control *bch;
+	int ret = 0;
+
+	bch = init_bch(BCH_UT_M, BCH_UT_T, 0);
+	if (!bch) {
+		printf("%s: init_bch() failed\n", __func__);
+		return CMD_RET_FAILURE;
+	}
+
+	ret |= test_bch_throughput(bch, 0);
+	ret |= test_bch_throughput(bch, BCH_UT_T / 2);
+	ret |= test_bch_throughput(bch, BCH_UT_T);
+
+	free_bch(bch);
+
+	printf("Test %s\n", ret ? "failed" : "passed");
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
@@ -0,0 +1,163 @@
+/*
+ * Test of the nested bootstage spans and their export
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <bootstage.h>
+#include <command.h>
+#include <errno.h>
+#include <malloc.h>
+#include <test/suites.h>
+
+struct span_times {
+	ulong start;
+	ulong dur;
+};
+
+/* Find the last Chrome trace event for a span and read its times */
+static int find_span(const char *buf, const char *name,
+		     struct span_times *times)
+{
+	char key[40];
+	const char *p, *found = NULL;
+
+	snprintf(key, sizeof(key), "{\"name\":\"%s\",\"ph\":\"X\",", name);
+	for (p = buf; (p = strstr(p, key)); p++)
+		found = p;
+	if (!found) {
+		printf("%s: not exported\n", name);
+		return -ENOENT;
+	}
+	p = strstr(found, "\"ts\":");
+	if (!p)
+		return -EINVAL;
+	times->start = simple_strtoul(p + 5, NULL, 10);
+	p = strstr(found, "\"dur\":");
+	if (!p)
+		return -EINVAL;
+	times->dur = simple_strtoul(p + 6, NULL, 10);
+
+	return 0;
+}
+
+/* Check that span @inner lies within @outer */
+static int check_within(const char *what, const struct span_times *inner,
+			const struct span_times *outer)
+{
+	if (inner->start >= outer->start &&
+	    inner->start + inner->dur <= outer->start + outer->dur)
+		return 0;
+	printf("%s: %lu..%lu not within %lu..%lu\n", what, inner->start,
+	       inner->start + inner->dur, outer->start,
+	       outer->start + outer->dur);
+
+	return -EINVAL;
+}
+
+static int check_dur(const char *what, const struct span_times *times,
+		     uint32_t dur)
+{
+	if (times->dur == dur)
+		return 0;
+	printf("%s: exported duration %lu, expected %u\n", what, times->dur,
+	       dur);
+
+	return -EINVAL;
+}
+
+static char *export_spans(enum bootstage_export_fmt fmt)
+{
+	char *buf;
+	int len;
+
+	/* Allow for the time of the final event growing by a digit or two */
+	len = bootstage_export(fmt, NULL, 0) + 32;
+	buf = malloc(len);
+	if (!buf)
+		return NULL;
+	if (bootstage_export(fmt, buf, len) >= len) {
+		free(buf);
+		return NULL;
+	}
+
+	return buf;
+}
+
+static int test_bootstage_spans(void)
+{
+	struct span_times range, outer, inner, open;
+	uint32_t outer_dur, inner_dur;
+	int outer_id, inner_id;
+	char *buf;
+	int ret = 0;
+
+	range.start = timer_get_boot_us();
+	outer_id = bootstage_span_begin("ut_outer");
+	udelay(1000);
+	inner_id = bootstage_span_begin("ut_inner");
+	udelay(2000);
+	inner_dur = bootstage_span_end(inner_id);
+	udelay(1000);
+
+	/* Left open, so ending the outer span must close it */
+	bootstage_span_begin("ut_open");
+	udelay(1000);
+	outer_dur = bootstage_span_end(outer_id);
+	range.dur = timer_get_boot_us() - range.start;
+	if (outer_id < 0 || inner_id < 0) {
+		printf("Span table full, increase CONFIG_BOOTSTAGE_SPAN_COUNT\n");
+		return -ENOSPC;
+	}
+
+	buf = export_spans(BOOTSTAGE_EXPORT_CHROME);
+	if (!buf)
+		return -ENOMEM;
+	if (find_span(buf, "ut_outer", &outer) ||
+	    find_span(buf, "ut_inner", &inner) ||
+	    find_span(buf, "ut_open", &open)) {
+		free(buf);
+		return -EINVAL;
+	}
+	free(buf);
+
+	ret |= check_within("outer", &outer, &range);
+	ret |= check_within("inner", &inner, &outer);
+	ret |= check_within("open", &open, &outer);
+	ret |= check_dur("outer", &outer, outer_dur);
+	ret |= check_dur("inner", &inner, inner_dur);
+	if (open.start < inner.start + inner.dur) {
+		printf("open: starts at %lu, before inner ends at %lu\n",
+		       open.start, inner.start + inner.dur);
+		ret = -EINVAL;
+	}
+	if (open.start + open.dur != outer.start + outer.dur) {
+		printf("open: ends at %lu, not with outer at %lu\n",
+		       open.start + open.dur, outer.start + outer.dur);
+		ret = -EINVAL;
+	}
+
+	/* The folded stacks show the nesting */
+	buf = export_spans(BOOTSTAGE_EXPORT_FOLDED);
+	if (!buf)
+		return -ENOMEM;
+	if (!strstr(buf, ";ut_outer;ut_inner ") &&
+	    strncmp(buf, "ut_outer;ut_inner ", 18)) {
+		printf("inner: not nested in outer in folded stacks\n");
+		ret = -EINVAL;
+	}
+	free(buf);
+
+	return ret;
+}
+
+int do_ut_bootstage(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	int ret;
+
+	ret = test_bootstage_spans();
+	printf("Test %s\n", ret ? "failed" : "passed");
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
@@ -0,0 +1,182 @@
+/*
+ * Test of the Internet checksum routines against a simple reference
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <errno.h>
+#include <net.h>
+#include <test/suites.h>
+
+#define BUF_SIZE	2048
+#define SPEED_LOOPS	2000
+
+static u8 buf[BUF_SIZE + 4] __aligned(8);
+
+/*
+ * The original routine, which sums 16 bits at a time. Kept out of line so
+ * that the speed test calls it rather than the compiler hoisting it.
+ */
+static noinline unsigned ref_ip_checksum(const void *vptr, unsigned nbytes)
+{
+	int sum, oddbyte;
+	const unsigned short *ptr = vptr;
+
+	sum = 0;
+	while (nbytes > 1) {
+		sum += *ptr++;
+		nbytes -= 2;
+	}
+	if (nbytes == 1) {
+		oddbyte = 0;
+		((u8 *)&oddbyte)[0] = *(u8 *)ptr;
+		((u8 *)&oddbyte)[1] = 0;
+		sum += oddbyte;
+	}
+	sum = (sum >> 16) + (sum & 0xffff);
+	sum += (sum >> 16);
+	sum = ~sum & 0xffff;
+
+	return sum;
+}
+
+/* The original UDP check from net_process_received_packet() */
+static bool ref_udp_checksum_ok(struct ip_udp_hdr *ip)
+{
+	ulong xsum;
+	ushort *sumptr;
+	ushort sumlen;
+
+	xsum  = ip->ip_p;
+	xsum += (ntohs(ip->udp_len));
+	xsum += (ntohl(ip->ip_src.s_addr) >> 16) & 0x0000ffff;
+	xsum += (ntohl(ip->ip_src.s_addr) >>  0) & 0x0000ffff;
+	xsum += (ntohl(ip->ip_dst.s_addr) >> 16) & 0x0000ffff;
+	xsum += (ntohl(ip->ip_dst.s_addr) >>  0) & 0x0000ffff;
+
+	sumlen = ntohs(ip->udp_len);
+	sumptr = (ushort *)&(ip->udp_src);
+
+	while (sumlen > 1) {
+		xsum += ntohs(*sumptr++);
+		sumlen -= 2;
+	}
+	if (sumlen > 0)
+		xsum += (*(unsigned char *)sumptr << 8) & 0xff00;
+	while ((xsum >> 16) != 0)
+		xsum = (xsum & 0x0000ffff) + ((xsum >> 16) & 0x0000ffff);
+
+	return xsum == 0 || xsum == 0xffff;
+}
+
+static void fill_buf(uint seed)
+{
+	int i;
+
+	for (i = 0; i < sizeof(buf); i++) {
+		seed = seed * 1103515245 + 12345;
+		buf[i] = seed >> 16;
+	}
+}
+
+/* Every length up to a full frame, at each 16-bit alignment */
+static int test_ip_checksum(void)
+{
+	unsigned len, align, expect, sum;
+
+	for (align = 0; align < 8; align += 2) {
+		fill_buf(align);
+		for (len = 0; len <= 1514; len++) {
+			expect = ref_ip_checksum(buf + align, len);
+			sum = compute_ip_checksum(buf + align, len);
+			if (sum != expect) {
+				printf("%s: align %u len %u: %04x, expected %04x\n",
+				       __func__, align, len, sum, expect);
+				return -EINVAL;
+			}
+		}
+	}
+
+	/* All ones must not overflow */
+	memset(buf, 0xff, sizeof(buf));
+	if (compute_ip_checksum(buf, BUF_SIZE) != ref_ip_checksum(buf, BUF_SIZE))
+		return -EINVAL;
+
+	return 0;
+}
+
+/* Datagrams checksummed by compute_udp_checksum() pass the original check */
+static int test_udp_checksum(void)
+{
+	struct ip_udp_hdr *ip = (struct ip_udp_hdr *)(buf + 2);
+	unsigned len, sum;
+
+	for (len = UDP_HDR_SIZE; len <= BUF_SIZE - IP_HDR_SIZE; len += 7) {
+		fill_buf(len);
+		ip->ip_p = IPPROTO_UDP;
+		ip->udp_len = htons(len);
+		ip->udp_xsum = 0;
+		sum = compute_udp_checksum(ip, len);
+		ip->udp_xsum = sum ? sum : 0xffff;
+
+		sum = compute_udp_checksum(ip, len);
+		if ((sum && sum != 0xffff) || !ref_udp_checksum_ok(ip)) {
+			printf("%s: len %u: checksum %04x is wrong\n",
+			       __func__, len, ntohs(ip->udp_xsum));
+			return -EINVAL;
+		}
+
+		/* Corrupt the data */
+		((u8 *)ip)[IP_HDR_SIZE + len - 1] ^= 0x10;
+		sum = compute_udp_checksum(ip, len);
+		if ((!sum || sum == 0xffff) || ref_udp_checksum_ok(ip)) {
+			printf("%s: len %u: corruption not detected\n",
+			       __func__, len);
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Both loops alternate between an aligned and a misaligned buffer, which
+ * also stops the compiler from summing the same buffer only once
+ */
+static void test_checksum_speed(void)
+{
+	ulong start, ref_us, us;
+	unsigned sum = 0;
+	int i;
+
+	fill_buf(0);
+	start = timer_get_us();
+	for (i = 0; i < SPEED_LOOPS; i++)
+		sum += ref_ip_checksum(buf + (i & 1) * 2, BUF_SIZE);
+	ref_us = timer_get_us() - start;
+
+	start = timer_get_us();
+	for (i = 0; i < SPEED_LOOPS; i++)
+		sum -= compute_ip_checksum(buf + (i & 1) * 2, BUF_SIZE);
+	us = timer_get_us() - start;
+
+	printf("%d x %d bytes: %lu us, original %lu us%s\n", SPEED_LOOPS,
+	       BUF_SIZE, us, ref_us, sum ? " (mismatch)" : "");
+}
+
+int do_ut_checksum(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	int ret;
+
+	ret = test_ip_checksum();
+	if (!ret)
+		ret = test_udp_checksum();
+	if (!ret)
+		test_checksum_speed();
+
+	printf("Test %s\n", ret ? "failed" : "passed");
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
@@ -13,15 +13,42 @@ static int do_ut_all(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
 
 static cmd_tbl_t cmd_ut_sub[] = {
 	U_BOOT_CMD_MKENT(all, CONFIG_SYS_MAXARGS, 1, do_ut_all, "", ""),
+#ifdef CONFIG_UT_BCH
+	U_BOOT_CMD_MKENT(bch, CONFIG_SYS_MAXARGS, 1, do_ut_bch, "", ""),
+#endif
+#ifdef CONFIG_UT_BOOTSTAGE
+	U_BOOT_CMD_MKENT(bootstage, CONFIG_SYS_MAXARGS, 1, do_ut_bootstage, "", ""),
+#endif
+#ifdef CONFIG_UT_CHECKSUM
+	U_BOOT_CMD_MKENT(checksum, CONFIG_SYS_MAXARGS, 1, do_ut_checksum, "", ""),
+#endif
 #if defined(CONFIG_UT_DM)
 	U_BOOT_CMD_MKENT(dm, CONFIG_SYS_MAXARGS, 1, do_ut_dm, "", ""),
 #endif
+#ifdef CONFIG_UT_EFI_MEM
+	U_BOOT_CMD_MKENT(efi_mem, CONFIG_SYS_MAXARGS, 1, do_ut_efi_mem, "", ""),
+#endif
+#ifdef CONFIG_UT_EFI_POOL
+	U_BOOT_CMD_MKENT(efi_pool, CONFIG_SYS_MAXARGS, 1, do_ut_efi_pool, "", ""),
+#endif
 #if defined(CONFIG_UT_ENV)
 	U_BOOT_CMD_MKENT(env, CONFIG_SYS_MAXARGS, 1, do_ut_env, "", ""),
 #endif
+#ifdef CONFIG_UT_LMB
+	U_BOOT_CMD_MKENT(lmb, CONFIG_SYS_MAXARGS, 1, do_ut_lmb, "", ""),
+#endif
+#ifdef CONFIG_UT_MALLOC
+	U_BOOT_CMD_MKENT(malloc, CONFIG_SYS_MAXARGS, 1, do_ut_malloc, "", ""),
+#endif
 #ifdef CONFIG_UT_OVERLAY
 	U_BOOT_CMD_MKENT(overlay, CONFIG_SYS_MAXARGS, 1, do_ut_overlay, "", ""),
 #endif
+#ifdef CONFIG_UT_PMU
+	U_BOOT_CMD_MKENT(pmu, CONFIG_SYS_MAXARGS, 1, do_ut_pmu, "", ""),
+#endif
+#ifdef CONFIG_UT_RTT
+	U_BOOT_CMD_MKENT(rtt, CONFIG_SYS_MAXARGS, 1, do_ut_rtt, "", ""),
+#endif
 #ifdef CONFIG_UT_TIME
 	U_BOOT_CMD_MKENT(time, CONFIG_SYS_MAXARGS, 1, do_ut_time, "", ""),
 #endif
@@ -65,15 +92,42 @@ static int do_ut(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 #ifdef CONFIG_SYS_LONGHELP
 static char ut_help_text[] =
 	"all - execute all enabled tests\n"
+#ifdef CONFIG_UT_BCH
+	"ut bch - BCH ECC correction and throughput\n"
+#endif
+#ifdef CONFIG_UT_BOOTSTAGE
+	"ut bootstage - Nested spans and their export\n"
+#endif
+#ifdef CONFIG_UT_CHECKSUM
+	"ut checksum - IP and UDP checksums against a reference\n"
+#endif
 #ifdef CONFIG_UT_DM
 	"ut dm [test-name]\n"
 #endif
+#ifdef CONFIG_UT_EFI_MEM
+	"ut efi_mem - EFI memory map allocation stress test\n"
+#endif
+#ifdef CONFIG_UT_EFI_POOL
+	"ut efi_pool - EFI pool allocator with a boot loader workload\n"
+#endif
 #ifdef CONFIG_UT_ENV
 	"ut env [test-name]\n"
 #endif
+#ifdef CONFIG_UT_LMB
+	"ut lmb - Logical memory block reserve and allocation\n"
+#endif
+#ifdef CONFIG_UT_MALLOC
+	"ut malloc - Record allocations with the malloc() tracker\n"
+#endif
 #ifdef CONFIG_UT_OVERLAY
 	"ut overlay [test-name]\n"
 #endif
+#ifdef CONFIG_UT_PMU
+	"ut pmu - Count a loop with the performance counters\n"
+#endif
+#ifdef CONFIG_UT_RTT
+	"ut rtt - Round trip time estimate for retransmission\n"
+#endif
 #ifdef CONFIG_UT_TIME
 	"ut time - Very basic test of time functions\n"
 #endif
@@ -11,6 +11,7 @@
 #include <command.h>
 #include <dm.h>
 #include <malloc.h>
+#include <malloc_class.h>
 #include <mapmem.h>
 #include <errno.h>
 #include <asm/io.h>
@@ -41,10 +42,23 @@ static int do_dm_dump_devres(cmd_tbl_t *cmdtp, int flag, int argc,
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(MALLOC_CLASS)
+static int do_dm_dump_alloc(cmd_tbl_t *cmdtp, int flag, int argc,
+			    char * const argv[])
+{
+	malloc_class_report();
+
+	return 0;
+}
+#endif
+
 static cmd_tbl_t test_commands[] = {
 	U_BOOT_CMD_MKENT(tree, 0, 1, do_dm_dump_all, "", ""),
 	U_BOOT_CMD_MKENT(uclass, 1, 1, do_dm_dump_uclass, "", ""),
 	U_BOOT_CMD_MKENT(devres, 1, 1, do_dm_dump_devres, "", ""),
+#if CONFIG_IS_ENABLED(MALLOC_CLASS)
+	U_BOOT_CMD_MKENT(alloc, 1, 1, do_dm_dump_alloc, "", ""),
+#endif
 };
 
 static __maybe_unused void dm_reloc(void)
@@ -86,4 +100,7 @@ U_BOOT_CMD(
 	"tree         Dump driver model tree ('*' = activated)\n"
 	"dm uclass        Dump list of instances for each uclass\n"
 	"dm devres        Dump list of device resources for each device"
+#if CONFIG_IS_ENABLED(MALLOC_CLASS)
+	"\ndm alloc         Show allocations served from size classes"
+#endif
 );
@@ -0,0 +1,313 @@
+/*
+ * Test of DHCP asking for the previous lease, against a scripted server
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <net.h>
+#include <dm/test.h>
+#include <asm/eth.h>
+#include <test/ut.h>
+#include "../../net/bootp.h"
+
+#define DHCP_TEST_SERVER	"1.1.2.2"
+#define DHCP_TEST_ADDR		"1.1.2.5"
+#define DHCP_TEST_LEASE		3600
+
+#define BOOTP_VENDOR_MAGIC	0x63825363
+
+/* What the server has been asked */
+static struct dhcp_test_server {
+	int discovers;
+	int requests;		/* naming the server, after an offer */
+	int reboots;		/* not naming it, in the INIT-REBOOT state */
+	int naks;
+} srv;
+
+/* Find option @opt in @bp, returning a pointer to its length or NULL */
+static u8 *dhcp_test_find(struct bootp_hdr *bp, int opt)
+{
+	u8 *p = (u8 *)bp->bp_vend + 4;
+	u8 *end = (u8 *)bp->bp_vend + sizeof(bp->bp_vend);
+
+	while (p < end && *p != 0xff) {
+		if (*p == opt)
+			return p + 1;
+		p += *p ? p[1] + 2 : 1;
+	}
+
+	return NULL;
+}
+
+static u8 *dhcp_test_put_ip(u8 *p, int opt, struct in_addr ip)
+{
+	*p++ = opt;
+	*p++ = 4;
+	memcpy(p, &ip, 4);
+
+	return p + 4;
+}
+
+static void dhcp_test_reply(struct udevice *dev, struct bootp_hdr *req,
+			    int type, struct in_addr yiaddr)
+{
+	uchar pkt[PKTSIZE];
+	struct ethernet_hdr *eth = (void *)pkt;
+	struct ip_udp_hdr *ip = (void *)pkt + ETHER_HDR_SIZE;
+	struct bootp_hdr *bp = (void *)ip + IP_UDP_HDR_SIZE;
+	struct in_addr netmask = string_to_ip("255.255.255.0");
+	u32 lease = htonl(DHCP_TEST_LEASE);
+	u8 *p;
+
+	memset(pkt, '\0', sizeof(pkt));
+	memset(eth->et_dest, 0xff, ARP_HLEN);
+	memcpy(eth->et_src, "\x00\x00\x66\x44\x22\x00", ARP_HLEN);
+	eth->et_protlen = htons(PROT_IP);
+
+	bp->bp_op = OP_BOOTREPLY;
+	bp->bp_htype = HWT_ETHER;
+	bp->bp_hlen = HWL_ETHER;
+	net_copy_u32(&bp->bp_id, &req->bp_id);
+	net_write_ip(&bp->bp_yiaddr, yiaddr);
+	memcpy(bp->bp_chaddr, req->bp_chaddr, sizeof(bp->bp_chaddr));
+
+	p = (u8 *)bp->bp_vend;
+	*p++ = 99;
+	*p++ = 130;
+	*p++ = 83;
+	*p++ = 99;
+	*p++ = 53;
+	*p++ = 1;
+	*p++ = type;
+	p = dhcp_test_put_ip(p, 54, string_to_ip(DHCP_TEST_SERVER));
+	if (type != DHCP_NAK) {
+		p = dhcp_test_put_ip(p, 1, netmask);
+		*p++ = 51;
+		*p++ = 4;
+		memcpy(p, &lease, 4);
+		p += 4;
+	}
+	*p++ = 0xff;
+
+	net_set_ip_header((uchar *)ip, string_to_ip("255.255.255.255"),
+			  string_to_ip(DHCP_TEST_SERVER));
+	net_set_udp_header((uchar *)ip, string_to_ip("255.255.255.255"), 68,
+			   67, BOOTP_HDR_SIZE);
+	net_write_ip(&ip->ip_src, string_to_ip(DHCP_TEST_SERVER));
+	ip->ip_sum = 0;
+	ip->ip_sum = compute_ip_checksum(ip, IP_HDR_SIZE);
+
+	sandbox_eth_queue_recv(dev, pkt, ETHER_HDR_SIZE + IP_UDP_HDR_SIZE +
+			       BOOTP_HDR_SIZE);
+}
+
+/* Give out DHCP_TEST_ADDR, refusing requests for any other address */
+static int dhcp_test_tx(struct udevice *dev, void *packet, unsigned int len)
+{
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	struct bootp_hdr *bp = packet + ETHER_HDR_SIZE + IP_UDP_HDR_SIZE;
+	struct in_addr addr = string_to_ip(DHCP_TEST_ADDR);
+	struct in_addr want;
+	u8 *type, *opt;
+
+	if (ntohs(((struct ethernet_hdr *)packet)->et_protlen) != PROT_IP ||
+	    ip->ip_p != IPPROTO_UDP || ntohs(ip->udp_dst) != 67 ||
+	    net_read_u32((u32 *)bp->bp_vend) != htonl(BOOTP_VENDOR_MAGIC))
+		return 0;
+	type = dhcp_test_find(bp, 53);
+	if (!type)
+		return 0;
+
+	switch (type[1]) {
+	case DHCP_DISCOVER:
+		srv.discovers++;
+		dhcp_test_reply(dev, bp, DHCP_OFFER, addr);
+		break;
+	case DHCP_REQUEST:
+		opt = dhcp_test_find(bp, 50);
+		if (!opt)
+			return -EINVAL;
+		memcpy(&want, opt + 1, 4);
+		if (dhcp_test_find(bp, 54))
+			srv.requests++;
+		else
+			srv.reboots++;
+		if (want.s_addr == addr.s_addr) {
+			dhcp_test_reply(dev, bp, DHCP_ACK, addr);
+		} else {
+			srv.naks++;
+			want.s_addr = 0;
+			dhcp_test_reply(dev, bp, DHCP_NAK, want);
+		}
+		break;
+	}
+
+	return 0;
+}
+
+/* The asserts include a return on fail; cleanup in the caller */
+static int _dm_test_dhcp_reboot(struct unit_test_state *uts)
+{
+	const char *lease_prefix = DHCP_TEST_ADDR " " DHCP_TEST_SERVER " ";
+	struct in_addr addr = string_to_ip(DHCP_TEST_ADDR);
+
+	/* With no lease, the full exchange gives one */
+	ut_assertok(net_loop(DHCP));
+	ut_asserteq(addr.s_addr, net_ip.s_addr);
+	ut_asserteq(1, srv.discovers);
+	ut_asserteq(1, srv.requests);
+	ut_asserteq(0, srv.reboots);
+	ut_assertnonnull(getenv("dhcplease"));
+	ut_assertok(strncmp(getenv("dhcplease"), lease_prefix,
+			    strlen(lease_prefix)));
+
+	/* Next time a single request is enough */
+	memset(&srv, '\0', sizeof(srv));
+	ut_assertok(net_loop(DHCP));
+	ut_asserteq(addr.s_addr, net_ip.s_addr);
+	ut_asserteq(0, srv.discovers);
+	ut_asserteq(1, srv.reboots);
+
+	/* A stale lease is refused and the full exchange follows */
+	memset(&srv, '\0', sizeof(srv));
+	setenv("dhcplease", "1.1.2.99 " DHCP_TEST_SERVER " 0");
+	ut_assertok(net_loop(DHCP));
+	ut_asserteq(addr.s_addr, net_ip.s_addr);
+	ut_asserteq(1, srv.reboots);
+	ut_asserteq(1, srv.naks);
+	ut_asserteq(1, srv.discovers);
+	ut_asserteq(1, srv.requests);
+	ut_assertok(strncmp(getenv("dhcplease"), lease_prefix,
+			    strlen(lease_prefix)));
+
+	return 0;
+}
+
+static int dm_test_dhcp_reboot(struct unit_test_state *uts)
+{
+	struct in_addr ip = net_ip, netmask = net_netmask;
+	struct in_addr gateway = net_gateway;
+	int retval;
+
+	memset(&srv, '\0', sizeof(srv));
+	setenv("ethact", "eth@10002000");
+	setenv("autoload", "no");
+	setenv("dhcplease", NULL);
+	sandbox_eth_set_tx_handler(0, dhcp_test_tx);
+
+	retval = _dm_test_dhcp_reboot(uts);
+
+	sandbox_eth_set_tx_handler(0, NULL);
+	setenv("dhcplease", NULL);
+	setenv("autoload", NULL);
+	net_ip = ip;
+	net_netmask = netmask;
+	net_gateway = gateway;
+
+	return retval;
+}
+DM_TEST(dm_test_dhcp_reboot, DM_TESTF_SCAN_FDT);
+
+#define DHCP_TEST_FILE_SIZE	100
+
+static int dhcp_test_arps;	/* ARP requests sent */
+
+/* Answer a TFTP read request at once with a one-block file */
+static void dhcp_test_tftp_reply(struct udevice *dev, void *packet)
+{
+	uchar pkt[PKTSIZE];
+	struct ethernet_hdr *eth = (void *)pkt;
+	struct ip_udp_hdr *req = packet + ETHER_HDR_SIZE;
+	struct ip_udp_hdr *ip = (void *)pkt + ETHER_HDR_SIZE;
+	__be16 *data = (void *)ip + IP_UDP_HDR_SIZE;
+	int len = 4 + DHCP_TEST_FILE_SIZE;
+
+	memset(pkt, '\0', sizeof(pkt));
+	memcpy(eth->et_dest, ((struct ethernet_hdr *)packet)->et_src, ARP_HLEN);
+	memcpy(eth->et_src, "\x00\x00\x66\x44\x22\x00", ARP_HLEN);
+	eth->et_protlen = htons(PROT_IP);
+
+	data[0] = htons(3);	/* DATA */
+	data[1] = htons(1);
+
+	net_set_udp_header((uchar *)ip, net_read_ip(&req->ip_src),
+			   ntohs(req->udp_src), 1069, len);
+	net_write_ip(&ip->ip_src, string_to_ip(DHCP_TEST_SERVER));
+	ip->ip_sum = 0;
+	ip->ip_sum = compute_ip_checksum(ip, IP_HDR_SIZE);
+
+	sandbox_eth_queue_recv(dev, pkt, ETHER_HDR_SIZE + IP_UDP_HDR_SIZE +
+			       len);
+}
+
+/* Count ARP requests, serving DHCP and TFTP reads */
+static int dhcp_test_arp_tx(struct udevice *dev, void *packet,
+			    unsigned int len)
+{
+	struct ethernet_hdr *eth = packet;
+	struct arp_hdr *arp = packet + ETHER_HDR_SIZE;
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	__be16 *op = packet + ETHER_HDR_SIZE + IP_UDP_HDR_SIZE;
+
+	if (ntohs(eth->et_protlen) == PROT_ARP) {
+		if (ntohs(arp->ar_op) == ARPOP_REQUEST)
+			dhcp_test_arps++;
+		return 0;
+	}
+	if (ntohs(eth->et_protlen) == PROT_IP && ip->ip_p == IPPROTO_UDP &&
+	    ntohs(ip->udp_dst) == 69 && ntohs(*op) == 1)	/* RRQ */
+		dhcp_test_tftp_reply(dev, packet);
+
+	return dhcp_test_tx(dev, packet, len);
+}
+
+/* The asserts include a return on fail; cleanup in the caller */
+static int _dm_test_dhcp_arp_prefetch(struct unit_test_state *uts)
+{
+	/* Binding asks for the server's address and waits for the answer */
+	ut_assertok(net_loop(DHCP));
+	ut_asserteq(1, dhcp_test_arps);
+
+	/* so neither transfer that follows needs to ask again */
+	copy_filename(net_boot_file_name, "dhcp-test",
+		      sizeof(net_boot_file_name));
+	ut_asserteq(DHCP_TEST_FILE_SIZE, net_loop(TFTPGET));
+	ut_asserteq(DHCP_TEST_FILE_SIZE, net_loop(TFTPGET));
+	ut_asserteq(1, dhcp_test_arps);
+
+	return 0;
+}
+
+static int dm_test_dhcp_arp_prefetch(struct unit_test_state *uts)
+{
+	struct in_addr ip = net_ip, netmask = net_netmask;
+	struct in_addr gateway = net_gateway, server = net_server_ip;
+	int retval;
+
+	memset(&srv, '\0', sizeof(srv));
+	dhcp_test_arps = 0;
+	arp_cache_flush();
+	setenv("ethact", "eth@10002000");
+	setenv("autoload", "no");
+	setenv("dhcplease", NULL);
+	/* This board has a fixed server address, which DHCP leaves alone */
+	net_server_ip = string_to_ip(DHCP_TEST_SERVER);
+	net_gateway.s_addr = 0;
+	sandbox_eth_set_tx_handler(0, dhcp_test_arp_tx);
+
+	retval = _dm_test_dhcp_arp_prefetch(uts);
+
+	sandbox_eth_set_tx_handler(0, NULL);
+	arp_cache_flush();
+	setenv("dhcplease", NULL);
+	setenv("autoload", NULL);
+	net_ip = ip;
+	net_netmask = netmask;
+	net_gateway = gateway;
+	net_server_ip = server;
+
+	return retval;
+}
+DM_TEST(dm_test_dhcp_arp_prefetch, DM_TESTF_SCAN_FDT);
@@ -16,6 +16,7 @@
 #include <dm/device-internal.h>
 #include <dm/uclass-internal.h>
 #include <asm/eth.h>
+#include <asm/test.h>
 #include <test/ut.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -259,3 +260,127 @@ static int dm_test_net_retry(struct unit_test_state *uts)
 	return retval;
 }
 DM_TEST(dm_test_net_retry, DM_TESTF_SCAN_FDT);
+
+/* Count the ARP requests sent, for dm_test_eth_arp_cache() */
+static int arp_test_requests;
+
+static int arp_test_tx(struct udevice *dev, void *packet, unsigned int len)
+{
+	struct ethernet_hdr *eth = packet;
+	struct arp_hdr *arp = packet + ETHER_HDR_SIZE;
+
+	if (ntohs(eth->et_protlen) == PROT_ARP &&
+	    ntohs(arp->ar_op) == ARPOP_REQUEST)
+		arp_test_requests++;
+
+	return 0;
+}
+
+/* The asserts include a return on fail; cleanup in the caller */
+static int _dm_test_eth_arp_cache(struct unit_test_state *uts)
+{
+	const uchar host0[] = {0x00, 0x00, 0x66, 0x44, 0x22, 0x00};
+	const uchar host1[] = {0x00, 0x00, 0x66, 0x44, 0x22, 0x11};
+	struct in_addr ip = string_to_ip("1.1.2.2");
+	uchar ethaddr[ARP_HLEN];
+
+	net_ping_ip = ip;
+	setenv("ethact", "eth@10002000");
+	sandbox_eth_set_tx_handler(0, arp_test_tx);
+	ut_asserteq(-ENOENT, arp_cache_lookup(ip, ethaddr));
+
+	/* The reply to the ping's ARP request is kept */
+	ut_assertok(net_loop(PING));
+	ut_asserteq(1, arp_test_requests);
+	ut_assertok(arp_cache_lookup(ip, ethaddr));
+	ut_assertok(memcmp(host0, ethaddr, ARP_HLEN));
+
+	/* Hosts off the subnet are reached through the gateway */
+	ut_asserteq(-ENOENT, arp_cache_lookup(string_to_ip("1.2.3.4"),
+					      ethaddr));
+	net_gateway = ip;
+	ut_assertok(arp_cache_lookup(string_to_ip("1.2.3.4"), ethaddr));
+	ut_assertok(memcmp(host0, ethaddr, ARP_HLEN));
+	net_gateway.s_addr = 0;
+
+	/* Prefetching a known address sends nothing */
+	arp_prefetch(ip);
+	ut_asserteq(1, arp_test_requests);
+
+	/* Each device has its own addresses */
+	setenv("ethact", "eth@10003000");
+	ut_assertok(net_loop(PING));
+	ut_assertok(arp_cache_lookup(ip, ethaddr));
+	ut_assertok(memcmp(host1, ethaddr, ARP_HLEN));
+	setenv("ethact", "eth@10002000");
+	ut_assertok(net_loop(PING));
+	ut_assertok(arp_cache_lookup(ip, ethaddr));
+	ut_assertok(memcmp(host0, ethaddr, ARP_HLEN));
+
+	/* Addresses are forgotten when they get old, or on request */
+	sandbox_timer_add_offset(200000);
+	ut_asserteq(-ENOENT, arp_cache_lookup(ip, ethaddr));
+	ut_assertok(net_loop(PING));
+	ut_assertok(arp_cache_lookup(ip, ethaddr));
+	arp_cache_flush();
+	ut_asserteq(-ENOENT, arp_cache_lookup(ip, ethaddr));
+
+	return 0;
+}
+
+static int dm_test_eth_arp_cache(struct unit_test_state *uts)
+{
+	int retval;
+
+	arp_test_requests = 0;
+	retval = _dm_test_eth_arp_cache(uts);
+	sandbox_eth_set_tx_handler(0, NULL);
+
+	return retval;
+}
+DM_TEST(dm_test_eth_arp_cache, DM_TESTF_SCAN_FDT);
+
+/* The first byte of the payload of each frame sent, in order */
+static uchar batch_test_seen[4];
+static int batch_test_count;
+
+static int batch_test_tx(struct udevice *dev, void *packet, unsigned int len)
+{
+	if (batch_test_count < ARRAY_SIZE(batch_test_seen))
+		batch_test_seen[batch_test_count] =
+			((uchar *)packet)[ETHER_HDR_SIZE];
+	batch_test_count++;
+
+	return 0;
+}
+
+/* Drivers without send_batch() send a batch one frame at a time */
+static int dm_test_eth_send_batch(struct unit_test_state *uts)
+{
+	uchar frames[3][ETHER_HDR_SIZE + 1];
+	struct eth_pkt pkts[3];
+	int ret;
+	int i;
+
+	for (i = 0; i < 3; i++) {
+		memset(frames[i], '\0', sizeof(frames[i]));
+		frames[i][ETHER_HDR_SIZE] = 'a' + i;
+		pkts[i].packet = frames[i];
+		pkts[i].length = sizeof(frames[i]);
+	}
+
+	batch_test_count = 0;
+	setenv("ethact", "eth@10002000");
+	ut_assertok(eth_init());
+	sandbox_eth_set_tx_handler(0, batch_test_tx);
+	ret = eth_send_batch(pkts, 3);
+	sandbox_eth_set_tx_handler(0, NULL);
+	eth_halt();
+
+	ut_asserteq(3, ret);
+	ut_asserteq(3, batch_test_count);
+	ut_assertok(memcmp("abc", batch_test_seen, 3));
+
+	return 0;
+}
+DM_TEST(dm_test_eth_send_batch, DM_TESTF_SCAN_FDT);
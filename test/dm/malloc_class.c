@@ -0,0 +1,87 @@
+/*
+ * Tests for the size-class allocator used by driver model
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <malloc_class.h>
+#include <dm/root.h>
+#include <dm/test.h>
+#include <dm/uclass-internal.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Number of times to bind, probe and unbind all devices in each pass */
+#define LOOPS	20
+
+/* Bind and probe the test devices, then unbind everything again */
+static int dm_malloc_lifecycle(struct unit_test_state *uts)
+{
+	struct udevice *dev;
+	int ret, id;
+
+	ut_assertok(dm_scan_platdata(false));
+	ut_assertok(dm_scan_fdt(gd->fdt_blob, false));
+
+	for (ret = uclass_first_device(UCLASS_TEST, &dev);
+	     dev;
+	     ret = uclass_next_device(&dev))
+		;
+	ut_assertok(ret);
+
+	/* Don't delete the root class, since we started with that */
+	for (id = UCLASS_ROOT + 1; id < UCLASS_COUNT; id++) {
+		struct uclass *uc;
+
+		uc = uclass_find(id);
+		if (!uc)
+			continue;
+		ut_assertok(uclass_destroy(uc));
+	}
+
+	return 0;
+}
+
+/*
+ * Run the device lifecycle with and without the size classes, counting
+ * calls to malloc() and the time taken
+ */
+static int dm_test_malloc_class(struct unit_test_state *uts)
+{
+	struct malloc_class_stats before[MALLOC_CLASS_COUNT];
+	struct malloc_class_stats after[MALLOC_CLASS_COUNT];
+	ulong calls[2], time[2];
+	int pass, i, j;
+
+	for (pass = 0; pass < 2; pass++) {
+		ulong start;
+
+		malloc_class_set_enabled(pass);
+		calls[pass] = malloc_class_get_stats(before);
+		start = timer_get_us();
+		for (i = 0; i < LOOPS; i++)
+			ut_assertok(dm_malloc_lifecycle(uts));
+		time[pass] = timer_get_us() - start;
+		calls[pass] = malloc_class_get_stats(after) - calls[pass];
+
+		/* Everything allocated from a class must be returned to it */
+		for (j = 0; j < MALLOC_CLASS_COUNT; j++) {
+			ut_asserteq(after[j].allocs - before[j].allocs,
+				    after[j].frees - before[j].frees);
+			ut_asserteq(before[j].slabs, after[j].slabs);
+		}
+	}
+	malloc_class_set_enabled(true);
+
+	printf("%d loops: %lu malloc() calls, %lu us without size classes\n",
+	       LOOPS, calls[0], time[0]);
+	printf("%d loops: %lu malloc() calls, %lu us with size classes\n",
+	       LOOPS, calls[1], time[1]);
+	ut_assert(calls[1] < calls[0]);
+
+	return 0;
+}
+DM_TEST(dm_test_malloc_class, 0);
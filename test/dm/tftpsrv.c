@@ -0,0 +1,268 @@
+/*
+ * Test of the TFTP server, against scripted clients
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <mapmem.h>
+#include <net.h>
+#include <net/tftp.h>
+#include <dm/test.h>
+#include <asm/eth.h>
+#include <test/ut.h>
+
+#define TFTPSRV_TEST_ADDR	0x1000000
+#define TFTPSRV_TEST_SIZE	5000
+#define TFTPSRV_TEST_PUT_SIZE	1300
+
+/* A client, getting the memory image or putting a new one */
+static struct tftpsrv_test_client {
+	const char *ip;
+	int port;
+	int op;
+	int blksize;		/* asked for as an option, 0 for none */
+	int drop;		/* DATA (get) or ACK (put) ignored the first time */
+	int server_port;
+	int block;		/* last block received (get) or sent (put) */
+	uint len;
+	uchar data[TFTPSRV_TEST_SIZE];
+	int packets;		/* DATA (get) or ACK (put) packets received */
+	bool oack;
+	long tsize;
+	int error;
+	int done;		/* order of finishing, from 1 */
+} clients[] = {
+	{ "1.2.3.10", 2000, TFTP_RRQ, 0, 3 },
+	{ "1.2.3.11", 2001, TFTP_RRQ, 1024, 0 },
+	{ "1.2.3.12", 2002, TFTP_WRQ, 0, 0 },
+};
+
+static int tftpsrv_test_finished;
+
+static u8 tftpsrv_test_byte(uint off)
+{
+	return off * 13 + (off >> 8);
+}
+
+static u8 tftpsrv_test_put_byte(uint off)
+{
+	return off * 7 + 3;
+}
+
+static void tftpsrv_test_send(struct udevice *dev,
+			      struct tftpsrv_test_client *c, int dport,
+			      const void *data, int len)
+{
+	uchar pkt[PKTSIZE];
+	struct ethernet_hdr *eth = (void *)pkt;
+	struct ip_udp_hdr *ip = (void *)pkt + ETHER_HDR_SIZE;
+
+	memset(pkt, '\0', sizeof(pkt));
+	memset(eth->et_dest, 0xff, ARP_HLEN);
+	eth->et_src[0] = 0x02;
+	eth->et_src[5] = c - clients;
+	eth->et_protlen = htons(PROT_IP);
+	memcpy(pkt + ETHER_HDR_SIZE + IP_UDP_HDR_SIZE, data, len);
+
+	net_set_udp_header((uchar *)ip, net_ip, dport, c->port, len);
+	net_write_ip(&ip->ip_src, string_to_ip(c->ip));
+	ip->ip_sum = 0;
+	ip->ip_sum = compute_ip_checksum(ip, IP_HDR_SIZE);
+
+	sandbox_eth_queue_recv(dev, pkt, ETHER_HDR_SIZE + IP_UDP_HDR_SIZE +
+			       len);
+}
+
+static void tftpsrv_test_request(struct udevice *dev,
+				 struct tftpsrv_test_client *c)
+{
+	char req[64];
+	int len;
+
+	req[0] = 0;
+	req[1] = c->op;
+	len = 2 + sprintf(req + 2, "image.bin%coctet%c", 0, 0);
+	if (c->blksize)
+		len += sprintf(req + len, "blksize%c%d%ctsize%c0%c", 0,
+			       c->blksize, 0, 0, 0);
+	tftpsrv_test_send(dev, c, TFTP_PORT, req, len);
+}
+
+static void tftpsrv_test_ack(struct udevice *dev,
+			     struct tftpsrv_test_client *c, int block)
+{
+	uchar ack[4] = { 0, TFTP_ACK, block >> 8, block };
+
+	tftpsrv_test_send(dev, c, c->server_port, ack, sizeof(ack));
+}
+
+/* Send the next block of the new image */
+static void tftpsrv_test_put(struct udevice *dev,
+			     struct tftpsrv_test_client *c)
+{
+	uchar pkt[4 + TFTP_BLOCK_SIZE];
+	uint off = c->block * TFTP_BLOCK_SIZE;
+	uint len = min_t(uint, TFTP_BLOCK_SIZE, TFTPSRV_TEST_PUT_SIZE - off);
+	uint i;
+
+	c->block++;
+	pkt[0] = 0;
+	pkt[1] = TFTP_DATA;
+	pkt[2] = c->block >> 8;
+	pkt[3] = c->block;
+	for (i = 0; i < len; i++)
+		pkt[4 + i] = tftpsrv_test_put_byte(off + i);
+	c->len = off + len;
+	tftpsrv_test_send(dev, c, c->server_port, pkt, 4 + len);
+}
+
+static int tftpsrv_test_tx(struct udevice *dev, void *packet, unsigned int len)
+{
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	uchar *data = packet + ETHER_HDR_SIZE + IP_UDP_HDR_SIZE;
+	struct tftpsrv_test_client *c = NULL;
+	int blksize, dlen, block, i;
+	char *opt;
+
+	if (ntohs(((struct ethernet_hdr *)packet)->et_protlen) != PROT_IP ||
+	    ip->ip_p != IPPROTO_UDP)
+		return 0;
+	for (i = 0; i < ARRAY_SIZE(clients); i++) {
+		if (clients[i].port == ntohs(ip->udp_dst))
+			c = &clients[i];
+	}
+	if (!c || c->done)
+		return 0;
+
+	c->server_port = ntohs(ip->udp_src);
+	dlen = ntohs(ip->udp_len) - UDP_HDR_SIZE - 4;
+	block = data[2] << 8 | data[3];
+	blksize = c->blksize ? c->blksize : TFTP_BLOCK_SIZE;
+
+	switch (data[1]) {
+	case TFTP_OACK:
+		c->oack = true;
+		for (opt = (char *)data + 2; opt < (char *)data + dlen + 4;
+		     opt += strlen(opt) + 1) {
+			if (!strcmp(opt, "tsize"))
+				c->tsize = simple_strtol(opt + 6, NULL, 10);
+		}
+		tftpsrv_test_ack(dev, c, 0);
+		break;
+	case TFTP_DATA:
+		c->packets++;
+		if (block == c->drop) {
+			c->drop = 0;
+			break;
+		}
+		if (block != c->block + 1 || c->len + dlen > TFTPSRV_TEST_SIZE)
+			break;
+		memcpy(c->data + c->len, data + 4, dlen);
+		c->len += dlen;
+		c->block = block;
+		tftpsrv_test_ack(dev, c, block);
+		if (dlen < blksize)
+			c->done = ++tftpsrv_test_finished;
+		/* Put a new image once both gets are done */
+		if (clients[0].done && clients[1].done)
+			tftpsrv_test_request(dev, &clients[2]);
+		break;
+	case TFTP_ACK:
+		c->packets++;
+		if (block != c->block)
+			break;
+		if (block && block == c->drop) {
+			/* Lost, so send the block again */
+			c->drop = 0;
+			c->block--;
+			tftpsrv_test_put(dev, c);
+			break;
+		}
+		if (c->block && c->len % TFTP_BLOCK_SIZE)
+			c->done = ++tftpsrv_test_finished;
+		else
+			tftpsrv_test_put(dev, c);
+		break;
+	case TFTP_ERROR:
+		c->error = block;
+		break;
+	}
+
+	return 0;
+}
+
+/*
+ * Two clients get the image at once, one of them losing a packet, then a
+ * third puts a new one, losing the last ACK, which stops the server
+ */
+static int dm_test_tftpsrv(struct unit_test_state *uts)
+{
+	struct udevice *dev;
+	uint i;
+	u8 *buf;
+	int ret;
+
+	for (i = 0; i < ARRAY_SIZE(clients); i++) {
+		clients[i].server_port = 0;
+		clients[i].block = 0;
+		clients[i].len = 0;
+		clients[i].packets = 0;
+		clients[i].oack = false;
+		clients[i].tsize = -1;
+		clients[i].error = 0;
+		clients[i].done = 0;
+	}
+	clients[0].drop = 3;
+	clients[2].drop = 3;
+	tftpsrv_test_finished = 0;
+
+	load_addr = TFTPSRV_TEST_ADDR;
+	buf = map_sysmem(load_addr, TFTPSRV_TEST_SIZE);
+	for (i = 0; i < TFTPSRV_TEST_SIZE; i++)
+		buf[i] = tftpsrv_test_byte(i);
+	setenv_hex("filesize", TFTPSRV_TEST_SIZE);
+	setenv("ethact", "eth@10002000");
+
+	ut_assertok(uclass_get_device_by_name(UCLASS_ETH, "eth@10002000",
+					      &dev));
+	tftpsrv_test_request(dev, &clients[0]);
+	tftpsrv_test_request(dev, &clients[1]);
+	sandbox_eth_set_tx_handler(0, tftpsrv_test_tx);
+	ret = net_loop(TFTPSRV);
+	sandbox_eth_set_tx_handler(0, NULL);
+	setenv("filesize", NULL);
+
+	/* The second get was not held up by the first one's lost packet */
+	ut_asserteq(1, clients[1].done);
+	ut_asserteq(2, clients[0].done);
+	ut_asserteq(3, clients[2].done);
+	for (i = 0; i < 2; i++) {
+		ut_asserteq(0, clients[i].error);
+		ut_asserteq(TFTPSRV_TEST_SIZE, clients[i].len);
+		ut_assertok(memcmp(clients[i].data, clients[0].data,
+				   TFTPSRV_TEST_SIZE));
+	}
+	for (i = 0; i < TFTPSRV_TEST_SIZE; i++)
+		ut_asserteq(tftpsrv_test_byte(i), clients[0].data[i]);
+	ut_asserteq(11, clients[0].packets);
+	ut_assert(!clients[0].oack);
+	ut_asserteq(5, clients[1].packets);
+	ut_assert(clients[1].oack);
+	ut_asserteq(TFTPSRV_TEST_SIZE, clients[1].tsize);
+
+	/* The last ACK of the put was sent again for the repeated block */
+	ut_asserteq(0, clients[2].error);
+	ut_asserteq(5, clients[2].packets);
+
+	/* The put is in memory and reported as the file received */
+	ut_asserteq(TFTPSRV_TEST_PUT_SIZE, ret);
+	ut_asserteq(TFTPSRV_TEST_PUT_SIZE, net_boot_file_size);
+	for (i = 0; i < TFTPSRV_TEST_PUT_SIZE; i++)
+		ut_asserteq(tftpsrv_test_put_byte(i), buf[i]);
+	unmap_sysmem(buf);
+
+	return 0;
+}
+DM_TEST(dm_test_tftpsrv, DM_TESTF_SCAN_FDT);
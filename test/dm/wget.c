@@ -0,0 +1,237 @@
+/*
+ * Test of the TCP client and wget, against a scripted HTTP server
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <mapmem.h>
+#include <net.h>
+#include <net/tcp.h>
+#include <dm/test.h>
+#include <asm/eth.h>
+#include <test/ut.h>
+
+#define WGET_TEST_ADDR		0x1000000
+#define WGET_TEST_SIZE		(1024 * 1024)
+#define WGET_TEST_PORT		80
+
+#define PEER_ISS	0x7ffff000	/* wraps the sign bit during the test */
+#define PEER_MSS	1460
+#define PEER_CWND	16		/* segments in flight */
+#define PEER_DROP	100		/* segment lost the first time */
+
+/* The server's side of the connection, as stream offsets */
+static struct wget_test_peer {
+	int cport;
+	u32 rcv_nxt;
+	uint wscale;
+	u32 client_win;
+	char req[256];
+	uint req_len;
+	char hdr[128];
+	uint hdr_len;
+	u32 total;
+	u32 una;
+	u32 nxt;
+	int dup_acks;
+	bool dropped;
+	ulong retransmits;
+} peer;
+
+static u8 wget_test_byte(u32 off)
+{
+	return off * 13 + (off >> 11);
+}
+
+static void peer_send(struct udevice *dev, uchar *in, u8 flags,
+		      u32 off, uint len)
+{
+	struct ethernet_hdr *eth_in = (void *)in;
+	struct ip_udp_hdr *ip_in = (void *)in + ETHER_HDR_SIZE;
+	uchar pkt[PKTSIZE];
+	struct ethernet_hdr *eth = (void *)pkt;
+	struct ip_udp_hdr *ip = (void *)pkt + ETHER_HDR_SIZE;
+	struct tcp_hdr *tcp = (void *)ip + IP_HDR_SIZE;
+	uchar *data = (uchar *)(tcp + 1);
+	uint hlen = TCP_HDR_SIZE;
+	u32 val;
+	uint i;
+
+	memcpy(eth->et_dest, eth_in->et_src, ARP_HLEN);
+	memcpy(eth->et_src, eth_in->et_dest, ARP_HLEN);
+	eth->et_protlen = htons(PROT_IP);
+
+	if (flags & TCP_SYN) {
+		*data++ = TCP_OPT_MSS;
+		*data++ = 4;
+		*data++ = PEER_MSS >> 8;
+		*data++ = PEER_MSS & 0xff;
+		*data++ = TCP_OPT_NOP;
+		*data++ = TCP_OPT_WSCALE;
+		*data++ = 3;
+		*data++ = 0;
+		hlen += 8;
+	}
+	for (i = 0; i < len; i++, off++) {
+		data[i] = off < peer.hdr_len ? peer.hdr[off] :
+			wget_test_byte(off - peer.hdr_len);
+	}
+	off -= len;
+
+	net_set_ip_header((uchar *)ip, net_read_ip(&ip_in->ip_src),
+			  net_read_ip(&ip_in->ip_dst));
+	ip->ip_len = htons(IP_HDR_SIZE + hlen + len);
+	ip->ip_p = IPPROTO_TCP;
+	ip->ip_sum = compute_ip_checksum(ip, IP_HDR_SIZE);
+
+	tcp->tcp_src = htons(WGET_TEST_PORT);
+	tcp->tcp_dst = htons(peer.cport);
+	val = htonl(flags & TCP_SYN ? PEER_ISS : PEER_ISS + 1 + off);
+	net_copy_u32(&tcp->tcp_seq, &val);
+	val = htonl(peer.rcv_nxt);
+	net_copy_u32(&tcp->tcp_ack, &val);
+	tcp->tcp_hlen = (hlen / 4) << 4;
+	tcp->tcp_flags = flags | TCP_ACK;
+	tcp->tcp_win = htons(0x4000);
+	tcp->tcp_xsum = 0;
+	tcp->tcp_urg = 0;
+	tcp->tcp_xsum = compute_udp_checksum(ip, hlen + len);
+
+	/* A full queue is just another lost packet */
+	sandbox_eth_queue_recv(dev, pkt, ETHER_HDR_SIZE + IP_HDR_SIZE + hlen +
+			       len);
+}
+
+/* Send the response segment starting at @off, dropping one of them once */
+static void peer_send_data(struct udevice *dev, uchar *in, u32 off)
+{
+	uint len = min_t(u32, PEER_MSS, peer.total - off);
+	u8 flags = off + len == peer.total ? TCP_FIN : 0;
+
+	if (off / PEER_MSS == PEER_DROP && !peer.dropped) {
+		peer.dropped = true;
+		return;
+	}
+	peer_send(dev, in, flags | TCP_PSH, off, len);
+}
+
+static int wget_test_tx(struct udevice *dev, void *packet, unsigned int len)
+{
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	struct tcp_hdr *tcp = packet + ETHER_HDR_SIZE + IP_HDR_SIZE;
+	const uchar *opt;
+	uint tcp_len, hlen, dlen, xsum;
+	u32 seq, ack;
+	s32 diff;
+
+	if (ntohs(((struct ethernet_hdr *)packet)->et_protlen) != PROT_IP ||
+	    ip->ip_p != IPPROTO_TCP ||
+	    ntohs(tcp->tcp_dst) != WGET_TEST_PORT)
+		return 0;
+	tcp_len = ntohs(ip->ip_len) - IP_HDR_SIZE;
+	xsum = compute_udp_checksum(ip, tcp_len);
+	if (xsum && xsum != 0xffff)
+		return -EINVAL;
+	hlen = (tcp->tcp_hlen >> 4) * 4;
+	dlen = tcp_len - hlen;
+	seq = ntohl(net_read_u32(&tcp->tcp_seq));
+	ack = ntohl(net_read_u32(&tcp->tcp_ack));
+
+	if (tcp->tcp_flags & TCP_SYN) {
+		peer.cport = ntohs(tcp->tcp_src);
+		peer.rcv_nxt = seq + 1;
+		for (opt = (uchar *)(tcp + 1); opt < (uchar *)tcp + hlen;
+		     opt += *opt == TCP_OPT_NOP ? 1 : opt[1]) {
+			if (*opt == TCP_OPT_WSCALE)
+				peer.wscale = opt[2];
+		}
+		peer_send(dev, packet, TCP_SYN, 0, 0);
+		return 0;
+	}
+	if ((tcp->tcp_flags & TCP_FIN) || !(tcp->tcp_flags & TCP_ACK))
+		return 0;
+	peer.client_win = ntohs(tcp->tcp_win) << peer.wscale;
+
+	if (dlen && seq == peer.rcv_nxt) {
+		/* the request */
+		if (peer.req_len + dlen < sizeof(peer.req))
+			memcpy(peer.req + peer.req_len, (uchar *)tcp + hlen,
+			       dlen);
+		peer.req_len += dlen;
+		peer.rcv_nxt += dlen;
+	}
+	if (!peer.req_len)
+		return 0;
+
+	diff = ack - (PEER_ISS + 1) - peer.una;
+	if (diff > 0) {
+		peer.una += diff;
+		peer.dup_acks = 0;
+	} else if (!diff && !dlen && peer.una != peer.nxt &&
+		   ++peer.dup_acks == 3) {
+		peer.retransmits++;
+		peer_send_data(dev, packet, peer.una);
+	}
+
+	while (peer.nxt < peer.total &&
+	       peer.nxt - peer.una < PEER_CWND * PEER_MSS &&
+	       peer.nxt - peer.una + PEER_MSS <= peer.client_win) {
+		peer_send_data(dev, packet, peer.nxt);
+		peer.nxt = min_t(u32, peer.nxt + PEER_MSS, peer.total);
+	}
+
+	return 0;
+}
+
+/* Download 1MiB with one segment lost, which must be fast-retransmitted */
+static int dm_test_wget(struct unit_test_state *uts)
+{
+	struct tcp_stats stats;
+	ulong start, us;
+	u8 *buf;
+	int ret;
+	u32 i;
+
+	memset(&peer, '\0', sizeof(peer));
+	peer.hdr_len = snprintf(peer.hdr, sizeof(peer.hdr),
+				"HTTP/1.1 200 OK\r\nServer: sandbox\r\n"
+				"content-length: %d\r\n\r\n", WGET_TEST_SIZE);
+	peer.total = peer.hdr_len + WGET_TEST_SIZE;
+
+	setenv("ethact", "eth@10002000");
+	setenv("serverip", "1.1.2.2");
+	sandbox_eth_set_tx_handler(0, wget_test_tx);
+	load_addr = WGET_TEST_ADDR;
+	strcpy(net_boot_file_name, "boot/image.bin");
+	buf = map_sysmem(load_addr, WGET_TEST_SIZE);
+	memset(buf, '\0', WGET_TEST_SIZE);
+
+	start = timer_get_us();
+	ret = net_loop(WGET);
+	us = timer_get_us() - start;
+	sandbox_eth_set_tx_handler(0, NULL);
+	tcp_get_stats(&stats);
+
+	ut_asserteq(WGET_TEST_SIZE, ret);
+	ut_asserteq(WGET_TEST_SIZE, net_boot_file_size);
+	peer.req[sizeof(peer.req) - 1] = '\0';
+	ut_asserteq_str("GET /boot/image.bin HTTP/1.1\r\nHost: 1.1.2.2\r\n"
+			"Connection: close\r\n\r\n", peer.req);
+	for (i = 0; i < WGET_TEST_SIZE; i++)
+		ut_asserteq(wget_test_byte(i), buf[i]);
+	unmap_sysmem(buf);
+
+	/* The loss was repaired without waiting for a timeout */
+	ut_assert(peer.dropped);
+	ut_asserteq(1, peer.retransmits);
+	ut_assert(stats.out_of_order >= 3);
+	ut_asserteq(0, stats.retransmits);
+	ut_asserteq(0, stats.dropped);
+	printf("%d bytes in %lu us, %lu segments out of order\n",
+	       WGET_TEST_SIZE, us, stats.out_of_order);
+
+	return 0;
+}
+DM_TEST(dm_test_wget, DM_TESTF_SCAN_FDT);
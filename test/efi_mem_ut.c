@@ -0,0 +1,159 @@
+/*
+ * Stress test of the EFI memory map
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <efi_loader.h>
+#include <errno.h>
+#include <malloc.h>
+#include <test/suites.h>
+
+#define EFI_MEM_UT_ALLOCS	1024
+
+struct efi_mem_ut_alloc {
+	uint64_t addr;
+	unsigned long pages;
+};
+
+/*
+ * Check that the map is sorted and free of overlaps, and count its
+ * descriptors and free pages
+ */
+static int efi_mem_ut_check_map(unsigned long *entries, uint64_t *free_pages)
+{
+	unsigned long map_size = 0, map_key, desc_size, i;
+	struct efi_mem_desc *map, *prev = NULL;
+	efi_status_t r;
+	int ret = 0;
+
+	efi_get_memory_map(&map_size, NULL, &map_key, &desc_size, NULL);
+	map = malloc(map_size);
+	if (!map)
+		return -ENOMEM;
+
+	r = efi_get_memory_map(&map_size, map, &map_key, &desc_size, NULL);
+	if (r != EFI_SUCCESS) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	*entries = map_size / desc_size;
+	*free_pages = 0;
+	for (i = 0; i < *entries; prev = &map[i], i++) {
+		uint64_t prev_end;
+
+		if (map[i].type == EFI_CONVENTIONAL_MEMORY)
+			*free_pages += map[i].num_pages;
+		if (!prev)
+			continue;
+		prev_end = prev->physical_start +
+			   (prev->num_pages << EFI_PAGE_SHIFT);
+		if (prev_end > map[i].physical_start) {
+			printf("%s: descriptor %lu overlaps its predecessor\n",
+			       __func__, i);
+			ret = -EINVAL;
+			break;
+		}
+	}
+
+out:
+	free(map);
+
+	return ret;
+}
+
+static int test_efi_mem_stress(struct efi_mem_ut_alloc *allocs)
+{
+	unsigned long entries_before, entries, peak = 0;
+	uint64_t free_before, free_pages;
+	unsigned int i, j, count = 0;
+	ulong start;
+	efi_status_t r;
+	int ret;
+
+	ret = efi_mem_ut_check_map(&entries_before, &free_before);
+	if (ret)
+		return ret;
+
+	srand(0xe71);
+	start = get_timer(0);
+	for (i = 0; i < EFI_MEM_UT_ALLOCS; i++) {
+		allocs[i].pages = 1 + rand() % 8;
+		r = efi_allocate_pages(0, (i & 1) ? EFI_BOOT_SERVICES_DATA :
+					   EFI_RUNTIME_SERVICES_DATA,
+				       allocs[i].pages, &allocs[i].addr);
+		if (r != EFI_SUCCESS) {
+			printf("%s: allocation %u failed\n", __func__, i);
+			return -ENOMEM;
+		}
+		count++;
+
+		/* Punch holes so the map fragments */
+		if (i & 2) {
+			j = rand() % (i + 1);
+			if (allocs[j].pages) {
+				efi_free_pages(allocs[j].addr, allocs[j].pages);
+				allocs[j].pages = 0;
+				count--;
+			}
+		}
+
+		if (!(i % 64)) {
+			ret = efi_mem_ut_check_map(&entries, &free_pages);
+			if (ret)
+				return ret;
+			peak = max(peak, entries);
+		}
+	}
+
+	for (i = 0; i < EFI_MEM_UT_ALLOCS; i++) {
+		if (!allocs[i].pages)
+			continue;
+		r = efi_free_pages(allocs[i].addr, allocs[i].pages);
+		if (r != EFI_SUCCESS) {
+			printf("%s: free of allocation %u failed\n", __func__,
+			       i);
+			return -EINVAL;
+		}
+	}
+
+	printf("%s: %u allocations, %u live, %lu to peak %lu descriptors, %lu ms\n",
+	       __func__, EFI_MEM_UT_ALLOCS, count, entries_before, peak,
+	       get_timer(start));
+
+	/*
+	 * With everything freed all pages are free again, though in more
+	 * descriptors since neighbours are not merged
+	 */
+	ret = efi_mem_ut_check_map(&entries, &free_pages);
+	if (ret)
+		return ret;
+	if (free_pages != free_before) {
+		printf("%s: %llu free pages, expected %llu\n", __func__,
+		       (unsigned long long)free_pages,
+		       (unsigned long long)free_before);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int do_ut_efi_mem(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	struct efi_mem_ut_alloc *allocs;
+	int ret;
+
+	allocs = calloc(EFI_MEM_UT_ALLOCS, sizeof(*allocs));
+	if (!allocs)
+		return CMD_RET_FAILURE;
+
+	ret = test_efi_mem_stress(allocs);
+	free(allocs);
+
+	printf("Test %s\n", ret ? "failed" : "passed");
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
@@ -0,0 +1,153 @@
+/*
+ * Test of the EFI pool allocator with a boot loader like workload
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <efi_loader.h>
+#include <errno.h>
+#include <malloc.h>
+#include <test/suites.h>
+
+#define EFI_POOL_UT_ALLOCS	4096
+
+static unsigned long efi_pool_ut_map_entries(void)
+{
+	unsigned long map_size = 0, map_key, desc_size = 0;
+
+	efi_get_memory_map(&map_size, NULL, &map_key, &desc_size, NULL);
+
+	return map_size / sizeof(struct efi_mem_desc);
+}
+
+/*
+ * Mostly small allocations of mixed sizes with a large one now and then,
+ * about half of them freed again in between, like GRUB loading its
+ * modules and parsing its configuration.
+ */
+static unsigned long efi_pool_ut_size(unsigned int i)
+{
+	if (!(i % 257))
+		return 8192 + (i % 7) * 4096;
+
+	return 8 + (rand() % 16) * ((i & 3) ? 8 : 56);
+}
+
+/* Check that allocation @i still holds the bytes it was filled with */
+static int efi_pool_ut_check(void **bufs, unsigned long *sizes,
+			     unsigned int i)
+{
+	u8 *p = bufs[i];
+	unsigned long k;
+
+	for (k = 0; k < sizes[i]; k++) {
+		if (p[k] != (u8)i) {
+			printf("%s: allocation %u was overwritten at byte %lu\n",
+			       __func__, i, k);
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+static int test_efi_pool_workload(void **bufs, unsigned long *sizes)
+{
+	struct efi_pool_stats before = efi_pool_stats;
+	unsigned long entries = efi_pool_ut_map_entries();
+	unsigned long small, large, arenas, growth;
+	unsigned int i, j;
+	efi_status_t r;
+	int ret;
+
+	srand(0xef1);
+	for (i = 0; i < EFI_POOL_UT_ALLOCS; i++) {
+		unsigned long size = efi_pool_ut_size(i);
+
+		r = efi_allocate_pool(EFI_BOOT_SERVICES_DATA, size, &bufs[i]);
+		if (r != EFI_SUCCESS) {
+			printf("%s: allocation %u of %lu bytes failed\n",
+			       __func__, i, size);
+			return -ENOMEM;
+		}
+		if ((uintptr_t)bufs[i] & 7) {
+			printf("%s: %p is not 8 byte aligned\n", __func__,
+			       bufs[i]);
+			return -EINVAL;
+		}
+		/* Fill it all, so that overlapping allocations show up */
+		memset(bufs[i], i, size);
+		sizes[i] = size;
+
+		/* Free an earlier allocation every other time */
+		if (i & 1) {
+			j = rand() % i;
+			if (bufs[j]) {
+				ret = efi_pool_ut_check(bufs, sizes, j);
+				if (ret)
+					return ret;
+				efi_free_pool(bufs[j]);
+				bufs[j] = NULL;
+			}
+		}
+	}
+
+	small = efi_pool_stats.small_allocs - before.small_allocs;
+	large = efi_pool_stats.page_allocs - before.page_allocs;
+	arenas = efi_pool_stats.arenas - before.arenas;
+	growth = efi_pool_ut_map_entries() - entries;
+	printf("%s: %lu small, %lu page allocations, %lu arenas, memory map grew by %lu entries\n",
+	       __func__, small, large, arenas, growth);
+
+	for (i = 0; i < EFI_POOL_UT_ALLOCS; i++) {
+		if (!bufs[i])
+			continue;
+		ret = efi_pool_ut_check(bufs, sizes, i);
+		if (ret)
+			return ret;
+		r = efi_free_pool(bufs[i]);
+		if (r != EFI_SUCCESS) {
+			printf("%s: free of allocation %u failed\n", __func__,
+			       i);
+			return -EINVAL;
+		}
+	}
+
+	/*
+	 * Each arena or page-backed allocation may add up to two map
+	 * entries (the allocation and a split of free memory), small
+	 * allocations must not add any.
+	 */
+	if (growth > 2 * (arenas + large)) {
+		printf("%s: memory map grew by %lu entries, expected at most %lu\n",
+		       __func__, growth, 2 * (arenas + large));
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int do_ut_efi_pool(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	unsigned long *sizes;
+	void **bufs;
+	int ret;
+
+	bufs = calloc(EFI_POOL_UT_ALLOCS, sizeof(*bufs));
+	sizes = calloc(EFI_POOL_UT_ALLOCS, sizeof(*sizes));
+	if (!bufs || !sizes) {
+		free(bufs);
+		free(sizes);
+		return CMD_RET_FAILURE;
+	}
+
+	ret = test_efi_pool_workload(bufs, sizes);
+	free(sizes);
+	free(bufs);
+
+	printf("Test %s\n", ret ? "failed" : "passed");
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
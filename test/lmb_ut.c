@@ -0,0 +1,163 @@
+/*
+ * Test of the logical memory block allocator
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <errno.h>
+#include <lmb.h>
+#include <test/suites.h>
+
+#define RAM_BASE	0x40000000
+#define RAM_SIZE	0x10000000
+
+/* Regions for the many-region test, more than the initial array holds */
+#define MANY_COUNT	1000
+#define MANY_SIZE	0x1000
+#define MANY_STRIDE	0x10000
+
+/* Check that reserved region @i is @base/@size, dumping them all if not */
+static int lmb_ut_check_region(struct lmb *lmb, unsigned long i,
+			       phys_addr_t base, phys_size_t size,
+			       const char *func)
+{
+	struct lmb_region *rgn = &lmb->reserved;
+
+	if (i < rgn->cnt && rgn->region[i].base == base &&
+	    rgn->region[i].size == size)
+		return 0;
+	printf("%s: region %lu is not %llx/%llx\n", func, i,
+	       (unsigned long long)base, (unsigned long long)size);
+	lmb_dump_all(lmb);
+
+	return -EINVAL;
+}
+
+/* Allocate from the top, below a reserved region, then free it again */
+static int test_lmb_simple(struct lmb *lmb)
+{
+	phys_addr_t top = RAM_BASE + RAM_SIZE - 0x100000;
+	phys_addr_t addr;
+
+	lmb_add(lmb, RAM_BASE, RAM_SIZE);
+	lmb_reserve(lmb, top, 0x100000);
+
+	addr = lmb_alloc(lmb, 0x1000, 0x1000);
+	if (addr != top - 0x1000) {
+		printf("%s: allocated at %llx\n", __func__,
+		       (unsigned long long)addr);
+		return -EINVAL;
+	}
+	/* The allocation is adjacent, so it is merged */
+	if (lmb_ut_check_region(lmb, 0, top - 0x1000, 0x101000, __func__))
+		return -EINVAL;
+	if (!lmb_is_reserved(lmb, addr) || lmb_is_reserved(lmb, addr - 1))
+		return -EINVAL;
+
+	if (lmb_free(lmb, addr, 0x1000))
+		return -EINVAL;
+
+	return lmb_ut_check_region(lmb, 0, top, 0x100000, __func__);
+}
+
+/* Overlapping and touching regions are merged; freeing can split them */
+static int test_lmb_overlap(struct lmb *lmb)
+{
+	lmb_add(lmb, RAM_BASE, RAM_SIZE);
+	lmb_reserve(lmb, RAM_BASE + 0x1000, 0x2000);
+	lmb_reserve(lmb, RAM_BASE + 0x2000, 0x3000);
+	lmb_reserve(lmb, RAM_BASE + 0x6000, 0x1000);
+	if (lmb->reserved.cnt != 2)
+		return -EINVAL;
+	lmb_reserve(lmb, RAM_BASE + 0x5000, 0x1000);
+	if (lmb->reserved.cnt != 1 ||
+	    lmb_ut_check_region(lmb, 0, RAM_BASE + 0x1000, 0x6000, __func__))
+		return -EINVAL;
+
+	if (lmb_free(lmb, RAM_BASE + 0x3000, 0x1000))
+		return -EINVAL;
+	if (lmb->reserved.cnt != 2 ||
+	    lmb_ut_check_region(lmb, 0, RAM_BASE + 0x1000, 0x2000, __func__) ||
+	    lmb_ut_check_region(lmb, 1, RAM_BASE + 0x4000, 0x3000, __func__))
+		return -EINVAL;
+
+	/* Not reserved, or only partly */
+	if (lmb_free(lmb, RAM_BASE + 0x3000, 0x1000) != -1 ||
+	    lmb_free(lmb, RAM_BASE + 0x2000, 0x2000) != -1)
+		return -EINVAL;
+
+	return 0;
+}
+
+/* Many reserved regions, as with a large /reserved-memory node */
+static int test_lmb_many(struct lmb *lmb)
+{
+	phys_addr_t base, addr, max_addr;
+	ulong start;
+	int i;
+
+	lmb_add(lmb, RAM_BASE, RAM_SIZE);
+	start = timer_get_us();
+	for (i = MANY_COUNT - 1; i >= 0; i--) {
+		if (lmb_reserve(lmb, RAM_BASE + i * MANY_STRIDE, MANY_SIZE) < 0)
+			return -ENOMEM;
+	}
+	if (lmb->reserved.cnt != MANY_COUNT) {
+		printf("%s: %lu regions\n", __func__, lmb->reserved.cnt);
+		return -EINVAL;
+	}
+	for (i = 0; i < MANY_COUNT; i++) {
+		base = RAM_BASE + i * MANY_STRIDE;
+		if (!lmb_is_reserved(lmb, base) ||
+		    !lmb_is_reserved(lmb, base + MANY_SIZE - 1) ||
+		    lmb_is_reserved(lmb, base + MANY_SIZE)) {
+			printf("%s: region %d is wrong\n", __func__, i);
+			return -EINVAL;
+		}
+	}
+
+	/* The first fit below the limit is just under the last region */
+	base = RAM_BASE + (MANY_COUNT - 1) * MANY_STRIDE;
+	max_addr = base + MANY_SIZE;
+	addr = __lmb_alloc_base(lmb, 0x8000, 0x1000, max_addr);
+	if (addr != base - 0x8000) {
+		printf("%s: allocated at %llx\n", __func__,
+		       (unsigned long long)addr);
+		return -EINVAL;
+	}
+
+	/* Nothing this size fits between the regions */
+	addr = __lmb_alloc_base(lmb, MANY_STRIDE, 0x1000, max_addr);
+	if (addr) {
+		printf("%s: allocated at %llx in a gap which is too small\n",
+		       __func__, (unsigned long long)addr);
+		return -EINVAL;
+	}
+	printf("%d regions: %lu us\n", MANY_COUNT, timer_get_us() - start);
+
+	return 0;
+}
+
+int do_ut_lmb(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	int (*const tests[])(struct lmb *lmb) = {
+		test_lmb_simple,
+		test_lmb_overlap,
+		test_lmb_many,
+	};
+	struct lmb lmb;
+	int ret = 0;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(tests) && !ret; i++) {
+		lmb_init(&lmb);
+		ret = tests[i](&lmb);
+		lmb_release(&lmb);
+	}
+
+	printf("Test %s\n", ret ? "failed" : "passed");
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
@@ -0,0 +1,138 @@
+/*
+ * Test of the malloc() tracker
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <errno.h>
+#include <malloc.h>
+#include <malloc_track.h>
+#include <test/suites.h>
+
+#define MALLOC_UT_COUNT	4
+#define MALLOC_UT_SIZE	100
+#define MALLOC_UT_BIG	0x10000
+
+static int malloc_ut_check(bool ok, const char *func, const char *what)
+{
+	if (ok)
+		return 0;
+	printf("%s: %s\n", func, what);
+
+	return -EINVAL;
+}
+
+/* Allocations from one call site are counted together until freed */
+static int test_malloc_site(void)
+{
+	struct malloc_track_site before, after;
+	void *ptr[MALLOC_UT_COUNT];
+	ulong freed = 0;
+	int ret, i;
+
+	for (i = 0; i < MALLOC_UT_COUNT; i++) {
+		ptr[i] = malloc(MALLOC_UT_SIZE + i);
+		if (!ptr[i])
+			return -ENOMEM;
+	}
+	ret = malloc_track_get_site(ptr[0], &before);
+	if (!ret) {
+		ret = malloc_ut_check(before.allocs - before.frees >=
+				      MALLOC_UT_COUNT &&
+				      before.live >= MALLOC_UT_SIZE *
+				      MALLOC_UT_COUNT && before.caller &&
+				      before.peak >= before.live,
+				      __func__, "allocations not recorded");
+	}
+
+	for (i = 1; i < MALLOC_UT_COUNT; i++) {
+		freed += MALLOC_UT_SIZE + i;
+		free(ptr[i]);
+	}
+	if (!ret && !malloc_track_get_site(ptr[1], &after))
+		ret = malloc_ut_check(false, __func__, "freed memory is live");
+	if (!ret) {
+		malloc_track_get_site(ptr[0], &after);
+		ret = malloc_ut_check(after.caller == before.caller &&
+				      after.frees == before.frees +
+				      MALLOC_UT_COUNT - 1 &&
+				      after.live == before.live - freed,
+				      __func__, "frees not recorded");
+	}
+	free(ptr[0]);
+
+	return ret;
+}
+
+/* realloc() moves the record to its own caller */
+static int test_malloc_realloc(void)
+{
+	struct malloc_track_site site, new_site;
+	void *ptr, *new_ptr;
+	int ret;
+
+	ptr = calloc(1, MALLOC_UT_SIZE);
+	if (!ptr)
+		return -ENOMEM;
+	ret = malloc_track_get_site(ptr, &site);
+	new_ptr = realloc(ptr, MALLOC_UT_SIZE * 4);
+	if (!new_ptr) {
+		free(ptr);
+		return -ENOMEM;
+	}
+	if (!ret)
+		ret = malloc_track_get_site(new_ptr, &new_site);
+	if (!ret) {
+		ret = malloc_ut_check(new_site.caller != site.caller &&
+				      new_site.live >= MALLOC_UT_SIZE * 4,
+				      __func__, "realloc() not recorded");
+	}
+	free(new_ptr);
+	if (!ret && !malloc_track_get_site(new_ptr, &new_site))
+		ret = malloc_ut_check(false, __func__, "freed memory is live");
+
+	return ret;
+}
+
+/* A large allocation shows up in the peak use of the current phase */
+static int test_malloc_phase(void)
+{
+	struct malloc_track_usage before, after, early;
+	void *ptr;
+
+	malloc_track_get_usage(MALLOC_PHASE_CLI, &before);
+	ptr = malloc(MALLOC_UT_BIG);
+	if (!ptr)
+		return -ENOMEM;
+	malloc_track_get_usage(MALLOC_PHASE_CLI, &after);
+	free(ptr);
+	malloc_track_get_usage(MALLOC_PHASE_F, &early);
+
+	/* Driver model always allocates before relocation on sandbox */
+	if (early.allocs && !early.peak)
+		return malloc_ut_check(false, __func__, "no pre-reloc use");
+
+	return malloc_ut_check(after.allocs > before.allocs &&
+			       after.bytes >= before.bytes + MALLOC_UT_BIG &&
+			       after.peak >= after.start + MALLOC_UT_BIG,
+			       __func__, "phase use not recorded");
+}
+
+int do_ut_malloc(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	int ret;
+
+	ret = test_malloc_site();
+	if (!ret)
+		ret = test_malloc_realloc();
+	if (!ret)
+		ret = test_malloc_phase();
+	if (!ret)
+		malloc_track_print_phases();
+
+	printf("Test %s\n", ret ? "failed" : "passed");
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
@@ -0,0 +1,73 @@
+/*
+ * Test of the hardware performance counters
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <errno.h>
+#include <pmu.h>
+#include <test/suites.h>
+
+#define PMU_UT_LOOPS	1000000
+
+/* Check that counting a known loop gives sensible results */
+static int test_pmu_loop(void)
+{
+	struct pmu_snapshot start, end, diff;
+	volatile unsigned int sink = 0;
+	unsigned int i;
+	int ret;
+
+	ret = pmu_read(&start);
+	if (ret)
+		return ret;
+	for (i = 0; i < PMU_UT_LOOPS; i++)
+		sink += i;
+	pmu_read(&end);
+	pmu_diff(&diff, &start, &end);
+	pmu_print(&diff);
+
+	/* Events the CPU cannot count read as 0, which is fine */
+	for (i = 0; i < PMU_EVENT_COUNT; i++) {
+		if (end.count[i] < start.count[i]) {
+			printf("%s: %s went backwards\n", __func__,
+			       pmu_event_name(i));
+			return -EINVAL;
+		}
+	}
+
+	/* Each iteration takes at least a load, an add and a store */
+	if (end.count[PMU_INSTRUCTIONS] &&
+	    diff.count[PMU_INSTRUCTIONS] < PMU_UT_LOOPS * 3) {
+		printf("%s: %llu instructions for %u iterations\n", __func__,
+		       (unsigned long long)diff.count[PMU_INSTRUCTIONS],
+		       PMU_UT_LOOPS);
+		return -EINVAL;
+	}
+	if (end.count[PMU_CYCLES] && !diff.count[PMU_CYCLES]) {
+		printf("%s: cycle counter is not running\n", __func__);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int do_ut_pmu(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	int ret;
+
+	ret = pmu_init();
+	if (ret == -ENODEV) {
+		/* e.g. sandbox on a host which does not allow perf events */
+		printf("No performance counters, skipping\n");
+		ret = 0;
+	} else if (!ret) {
+		ret = test_pmu_loop();
+	}
+
+	printf("Test %s\n", ret ? "failed" : "passed");
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
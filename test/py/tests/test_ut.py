@@ -27,3 +27,24 @@ def test_ut(u_boot_console, ut_subtest):
 
     output = u_boot_console.run_command('ut ' + ut_subtest)
     assert output.endswith('Failures: 0')
+
+@pytest.mark.buildconfigspec('ut_bootstage')
+def test_ut_bootstage(u_boot_console):
+    """Record nested bootstage spans and check their export."""
+
+    output = u_boot_console.run_command('ut bootstage')
+    assert output.endswith('Test passed')
+
+@pytest.mark.buildconfigspec('ut_efi_mem')
+def test_ut_efi_mem(u_boot_console):
+    """Run the EFI memory map stress test."""
+
+    output = u_boot_console.run_command('ut efi_mem')
+    assert output.endswith('Test passed')
+
+@pytest.mark.buildconfigspec('ut_efi_pool')
+def test_ut_efi_pool(u_boot_console):
+    """Run the EFI pool allocator workload."""
+
+    output = u_boot_console.run_command('ut efi_pool')
+    assert output.endswith('Test passed')
@@ -0,0 +1,81 @@
+/*
+ * Test of the round trip time estimate used to retransmit over UDP
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <errno.h>
+#include <net/rtt.h>
+#include <test/suites.h>
+
+#define RTT_TEST_MAX	4000		/* ms */
+
+static int rtt_check(struct net_rtt *rtt, const char *what, ulong lo,
+		     ulong hi)
+{
+	ulong rto = net_rtt_timeout(rtt);
+
+	if (rto >= lo && rto <= hi)
+		return 0;
+	printf("%s: timeout %lu ms, expected %lu to %lu\n", what, rto, lo, hi);
+
+	return -EINVAL;
+}
+
+static int test_rtt(void)
+{
+	struct net_rtt rtt;
+	int ret = 0;
+	int i;
+
+	net_rtt_init(&rtt, 1000, RTT_TEST_MAX);
+	ret |= rtt_check(&rtt, "initial", 1000, 1000);
+
+	/* A fast LAN gives the smallest timeout */
+	net_rtt_sample(&rtt, 500);
+	ret |= rtt_check(&rtt, "LAN", CONFIG_NET_RTO_MIN, CONFIG_NET_RTO_MIN);
+
+	/* A steady 300 ms link settles just above its round trip time */
+	for (i = 0; i < 100; i++)
+		net_rtt_sample(&rtt, 300000);
+	ret |= rtt_check(&rtt, "WAN", 300, 310);
+
+	/* A jittery one allows for the jitter */
+	for (i = 0; i < 100; i++)
+		net_rtt_sample(&rtt, i & 1 ? 200000 : 400000);
+	ret |= rtt_check(&rtt, "jitter", 650, 750);
+
+	/* Each timeout doubles it, up to the limit */
+	net_rtt_backoff(&rtt);
+	ret |= rtt_check(&rtt, "backoff", 1300, 1500);
+	for (i = 0; i < 5; i++)
+		net_rtt_backoff(&rtt);
+	ret |= rtt_check(&rtt, "limit", RTT_TEST_MAX, RTT_TEST_MAX);
+	if (rtt.retransmits != 6) {
+		printf("%lu retransmits, expected 6\n", rtt.retransmits);
+		ret = -EINVAL;
+	}
+
+	/* A new sample ends the backoff */
+	net_rtt_sample(&rtt, 300000);
+	ret |= rtt_check(&rtt, "recovered", 300, 750);
+
+	/* A very slow link is limited too */
+	net_rtt_init(&rtt, 1000, RTT_TEST_MAX);
+	net_rtt_sample(&rtt, 10000000);
+	ret |= rtt_check(&rtt, "slow", RTT_TEST_MAX, RTT_TEST_MAX);
+
+	return ret;
+}
+
+int do_ut_rtt(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	int ret;
+
+	ret = test_rtt();
+	printf("Test %s\n", ret ? "failed" : "passed");
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
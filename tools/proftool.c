@@ -56,6 +56,8 @@ struct func_info *func_list;
 int func_count;
 struct trace_call *call_list;
 int call_count;
+struct trace_output_func *sample_list;
+int sample_count;
 int verbose;	/* Verbosity level 0=none, 1=warn, 2=notice, 3=info, 4=debug */
 unsigned long text_offset;		/* text address of first function */
 
@@ -86,6 +88,7 @@ static void usage(void)
 		"\n"
 		"Commands\n"
 		"   dump-ftrace\t\tDump out textual data in ftrace format\n"
+		"   dump-samples\t\tDump out samples per function from 'perf dump'\n"
 		"\n"
 		"Options:\n"
 		"   -m <map>\tSpecify Systen.map file\n"
@@ -227,6 +230,26 @@ static int read_calls(FILE *fin, int count)
 	return 0;
 }
 
+static int read_samples(FILE *fin, int count)
+{
+	struct trace_output_func *sample;
+	int i;
+
+	notice("sampled address count: %d\n", count);
+	sample_list = calloc(count, sizeof(*sample_list));
+	if (!sample_list) {
+		error("Cannot allocate sample_list\n");
+		return -1;
+	}
+	sample_count = count;
+
+	for (i = 0, sample = sample_list; i < count; i++, sample++) {
+		if (read_data(fin, sample, sizeof(*sample)))
+			return 1;
+	}
+	return 0;
+}
+
 static int read_profile(FILE *fin, int *not_found)
 {
 	struct trace_output_hdr hdr;
@@ -250,6 +273,11 @@ static int read_profile(FILE *fin, int *not_found)
 			if (read_calls(fin, hdr.rec_count))
 				return 1;
 			break;
+
+		case TRACE_CHUNK_SAMPLES:
+			if (read_samples(fin, hdr.rec_count))
+				return 1;
+			break;
 		}
 	}
 	return 0;
@@ -533,6 +561,80 @@ static int make_ftrace(void)
 	return 0;
 }
 
+static int h_cmp_call_count(const void *v1, const void *v2)
+{
+	const struct func_info *f1 = *(struct func_info **)v1;
+	const struct func_info *f2 = *(struct func_info **)v2;
+
+	if (f1->call_count != f2->call_count)
+		return f1->call_count < f2->call_count ? 1 : -1;
+	return f1->offset < f2->offset ? -1 : f1->offset > f2->offset;
+}
+
+/*
+ * Output the number of PC samples taken in each function, most sampled
+ * first, in the form:
+ *
+ *	 Samples      %  Function
+ *	     812  40.6%  mmc_read_blocks
+ */
+static int make_samples(void)
+{
+	struct trace_output_func *sample;
+	struct func_info *func, **sorted;
+	unsigned long total = 0, missing = 0;
+	int i, count;
+
+	for (i = 0, func = func_list; i < func_count; i++, func++)
+		func->call_count = 0;
+	for (i = 0, sample = sample_list; i < sample_count; i++, sample++) {
+		func = find_caller_by_offset(sample->offset);
+		/*
+		 * This is the last function starting at or before the sample;
+		 * past its end, the sample is in a gap between symbols or past
+		 * the last one, so cannot be attributed
+		 */
+		if (func && func->code_size &&
+		    sample->offset >= func->offset + func->code_size)
+			func = NULL;
+		total += sample->call_count;
+		if (!func) {
+			warn("Cannot find function at %lx\n",
+			     text_offset + sample->offset);
+			missing += sample->call_count;
+			continue;
+		}
+		func->call_count += sample->call_count;
+	}
+	if (!total) {
+		error("No samples in profile data\n");
+		return -1;
+	}
+
+	sorted = malloc(func_count * sizeof(*sorted));
+	if (!sorted) {
+		error("Cannot allocate sorted function list\n");
+		return -1;
+	}
+	for (i = count = 0, func = func_list; i < func_count; i++, func++) {
+		if (func->call_count)
+			sorted[count++] = func;
+	}
+	qsort(sorted, count, sizeof(*sorted), h_cmp_call_count);
+
+	printf("%8s %6s  %s\n", "Samples", "%", "Function");
+	for (i = 0; i < count; i++) {
+		func = sorted[i];
+		printf("%8lu %3lu.%lu%%  %s\n", func->call_count,
+		       func->call_count * 100 / total,
+		       func->call_count * 1000 / total % 10, func->name);
+	}
+	info("samples: %lu total, %lu not attributed\n", total, missing);
+	free(sorted);
+
+	return 0;
+}
+
 static int prof_tool(int argc, char * const argv[],
 		     const char *prof_fname, const char *map_fname,
 		     const char *trace_config_fname)
@@ -553,6 +655,8 @@ static int prof_tool(int argc, char * const argv[],
 
 		if (0 == strcmp(cmd, "dump-ftrace"))
 			err = make_ftrace();
+		else if (0 == strcmp(cmd, "dump-samples"))
+			err = make_samples();
 		else
 			warn("Unknown command '%s'\n", cmd);
 	}